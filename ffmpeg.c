@@ -41,6 +41,7 @@
 #include "libavutil/pixdesc.h"
 #include "libavutil/avstring.h"
 #include "libavutil/libm.h"
+#include "libavutil/trace.h"
 #include "libavformat/os_support.h"
 
 #if CONFIG_AVFILTER
@@ -181,6 +182,8 @@ static int file_overwrite = 0;
 static int metadata_count;
 static AVMetadataTag *metadata;
 static int do_benchmark = 0;
+static int do_benchmark_stages = 0;
+static const char *trace_filename = NULL;
 static int do_hex_dump = 0;
 static int do_pkt_dump = 0;
 static int do_psnr = 0;
@@ -243,6 +246,36 @@ static AVBitStreamFilterContext *bitstream_filters[MAX_FILES][MAX_STREAMS];
 
 struct AVInputStream;
 
+/* processing stages timed by -benchmark_stages */
+enum BenchStage {
+    BENCH_DEMUX,
+    BENCH_DECODE,
+    BENCH_FILTER,   /* filter graph, deinterlacing, scaling and resampling */
+    BENCH_ENCODE,
+    BENCH_BSF,
+    BENCH_MUX,
+    BENCH_NB
+};
+
+static const char *const bench_stage_names[BENCH_NB] = {
+    "demux", "decode", "filter", "encode", "bsf", "mux"
+};
+
+typedef struct BenchStats {
+    int64_t wall[BENCH_NB];  /* wall clock time, in microseconds */
+    int64_t utime[BENCH_NB]; /* user CPU time of the process, in microseconds */
+    int     count[BENCH_NB];
+} BenchStats;
+
+typedef struct BenchTimer {
+    int64_t wall;
+    int64_t utime;
+} BenchTimer;
+
+/* all stages of all streams, including the work which cannot be
+   attributed to a stream (trailers, packets of ignored streams) */
+static BenchStats bench_total;
+
 typedef struct AVOutputStream {
     int file_index;          /* file index */
     int index;               /* stream index in the output file */
@@ -287,6 +320,8 @@ typedef struct AVOutputStream {
     AVAudioConvert *reformat_ctx;
     AVFifoBuffer *fifo;     /* for compression: one audio fifo per codec */
     FILE *logfile;
+
+    BenchStats bench;
 } AVOutputStream;
 
 typedef struct AVInputStream {
@@ -311,6 +346,7 @@ typedef struct AVInputStream {
     int has_filter_frame;
     AVFilterPicRef *picref;
 #endif
+    BenchStats bench;
 } AVInputStream;
 
 typedef struct AVInputFile {
@@ -320,6 +356,68 @@ typedef struct AVInputFile {
     int nb_streams;       /* nb streams we are aware of */
 } AVInputFile;
 
+static int64_t getutime(void)
+{
+#if HAVE_GETRUSAGE
+    struct rusage rusage;
+
+    getrusage(RUSAGE_SELF, &rusage);
+    return (rusage.ru_utime.tv_sec * 1000000LL) + rusage.ru_utime.tv_usec;
+#elif HAVE_GETPROCESSTIMES
+    HANDLE proc;
+    FILETIME c, e, k, u;
+    proc = GetCurrentProcess();
+    GetProcessTimes(proc, &c, &e, &k, &u);
+    return ((int64_t) u.dwHighDateTime << 32 | u.dwLowDateTime) / 10;
+#else
+    return av_gettime();
+#endif
+}
+
+static void bench_start(BenchTimer *t)
+{
+    if (!do_benchmark_stages) {
+        t->wall = t->utime = 0;
+        return;
+    }
+    t->wall  = av_gettime();
+    t->utime = getutime();
+}
+
+/* account the time elapsed since bench_start() to the given stage of a
+   stream, stats may be NULL if the work does not belong to a stream */
+static void bench_stop(BenchTimer *t, BenchStats *stats, enum BenchStage stage)
+{
+    int64_t wall, utime;
+
+    if (!do_benchmark_stages)
+        return;
+    wall  = av_gettime() - t->wall;
+    utime = getutime()   - t->utime;
+    if (stats) {
+        stats->wall [stage] += wall;
+        stats->utime[stage] += utime;
+        stats->count[stage]++;
+    }
+    bench_total.wall [stage] += wall;
+    bench_total.utime[stage] += utime;
+    bench_total.count[stage]++;
+}
+
+static void print_bench_stats(const char *name, const BenchStats *stats)
+{
+    int i;
+
+    for (i = 0; i < BENCH_NB; i++) {
+        if (!stats->count[i])
+            continue;
+        fprintf(stderr, "bench: %-12s %-6s wall=%8.3fs utime=%8.3fs calls=%8d avg=%8.1fus\n",
+                name, bench_stage_names[i],
+                stats->wall[i] / 1000000.0, stats->utime[i] / 1000000.0,
+                stats->count[i], (double)stats->wall[i] / stats->count[i]);
+    }
+}
+
 #if HAVE_TERMIOS_H
 
 /* init terminal so that we can grab keys */
@@ -585,6 +683,8 @@ static int av_exit(int ret)
 {
     int i;
 
+    av_trace_stop();
+
     /* close files */
     for(i=0;i<nb_output_files;i++) {
         /* maybe av_close_output_file ??? */
@@ -765,15 +865,21 @@ get_sync_ipts(const AVOutputStream *ost)
     return (double)(ist->pts - start_time)/AV_TIME_BASE;
 }
 
-static void write_frame(AVFormatContext *s, AVPacket *pkt, AVCodecContext *avctx, AVBitStreamFilterContext *bsfc){
+static void write_frame(AVFormatContext *s, AVPacket *pkt, AVOutputStream *ost){
+    AVCodecContext *avctx = ost->st->codec;
+    AVBitStreamFilterContext *bsfc = bitstream_filters[ost->file_index][pkt->stream_index];
+    BenchTimer timer;
     int ret;
 
     while(bsfc){
         AVPacket new_pkt= *pkt;
-        int a= av_bitstream_filter_filter(bsfc, avctx, NULL,
-                                          &new_pkt.data, &new_pkt.size,
-                                          pkt->data, pkt->size,
-                                          pkt->flags & AV_PKT_FLAG_KEY);
+        int a;
+        bench_start(&timer);
+        a= av_bitstream_filter_filter(bsfc, avctx, NULL,
+                                      &new_pkt.data, &new_pkt.size,
+                                      pkt->data, pkt->size,
+                                      pkt->flags & AV_PKT_FLAG_KEY);
+        bench_stop(&timer, &ost->bench, BENCH_BSF);
         if(a>0){
             av_free_packet(pkt);
             new_pkt.destruct= av_destruct_packet;
@@ -790,7 +896,9 @@ static void write_frame(AVFormatContext *s, AVPacket *pkt, AVCodecContext *avctx
         bsfc= bsfc->next;
     }
 
+    bench_start(&timer);
     ret= av_interleaved_write_frame(s, pkt);
+    bench_stop(&timer, &ost->bench, BENCH_MUX);
     if(ret < 0){
         print_error("av_interleaved_write_frame()", ret);
         av_exit(1);
@@ -814,6 +922,7 @@ static void do_audio_out(AVFormatContext *s,
     int osize= av_get_bits_per_sample_format(enc->sample_fmt)/8;
     int isize= av_get_bits_per_sample_format(dec->sample_fmt)/8;
     const int coded_bps = av_get_bits_per_sample(enc->codec->id);
+    BenchTimer timer;
 
 need_realloc:
     audio_buf_size= (allocated_for_size + isize*dec->channels - 1) / (isize*dec->channels);
@@ -922,9 +1031,11 @@ need_realloc:
 
     if (ost->audio_resample) {
         buftmp = audio_buf;
+        bench_start(&timer);
         size_out = audio_resample(ost->resample,
                                   (short *)buftmp, (short *)buf,
                                   size / (ist->st->codec->channels * isize));
+        bench_stop(&timer, &ost->bench, BENCH_FILTER);
         size_out = size_out * enc->channels * osize;
     } else {
         buftmp = buf;
@@ -937,7 +1048,10 @@ need_realloc:
         int istride[6]= {isize};
         int ostride[6]= {osize};
         int len= size_out/istride[0];
-        if (av_audio_convert(ost->reformat_ctx, obuf, ostride, ibuf, istride, len)<0) {
+        bench_start(&timer);
+        ret = av_audio_convert(ost->reformat_ctx, obuf, ostride, ibuf, istride, len);
+        bench_stop(&timer, &ost->bench, BENCH_FILTER);
+        if (ret < 0) {
             printf("av_audio_convert() failed\n");
             if (exit_on_error)
                 av_exit(1);
@@ -966,8 +1080,10 @@ need_realloc:
 
             //FIXME pass ost->sync_opts as AVFrame.pts in avcodec_encode_audio()
 
+            bench_start(&timer);
             ret = avcodec_encode_audio(enc, audio_out, audio_out_size,
                                        (short *)audio_buf);
+            bench_stop(&timer, &ost->bench, BENCH_ENCODE);
             if (ret < 0) {
                 fprintf(stderr, "Audio encoding failed\n");
                 av_exit(1);
@@ -979,7 +1095,7 @@ need_realloc:
             if(enc->coded_frame && enc->coded_frame->pts != AV_NOPTS_VALUE)
                 pkt.pts= av_rescale_q(enc->coded_frame->pts, enc->time_base, ost->st->time_base);
             pkt.flags |= AV_PKT_FLAG_KEY;
-            write_frame(s, &pkt, ost->st->codec, bitstream_filters[ost->file_index][pkt.stream_index]);
+            write_frame(s, &pkt, ost);
 
             ost->sync_opts += enc->frame_size;
         }
@@ -1001,8 +1117,10 @@ need_realloc:
         }
 
         //FIXME pass ost->sync_opts as AVFrame.pts in avcodec_encode_audio()
+        bench_start(&timer);
         ret = avcodec_encode_audio(enc, audio_out, size_out,
                                    (short *)buftmp);
+        bench_stop(&timer, &ost->bench, BENCH_ENCODE);
         if (ret < 0) {
             fprintf(stderr, "Audio encoding failed\n");
             av_exit(1);
@@ -1014,7 +1132,7 @@ need_realloc:
         if(enc->coded_frame && enc->coded_frame->pts != AV_NOPTS_VALUE)
             pkt.pts= av_rescale_q(enc->coded_frame->pts, enc->time_base, ost->st->time_base);
         pkt.flags |= AV_PKT_FLAG_KEY;
-        write_frame(s, &pkt, ost->st->codec, bitstream_filters[ost->file_index][pkt.stream_index]);
+        write_frame(s, &pkt, ost);
     }
 }
 
@@ -1071,6 +1189,7 @@ static void do_subtitle_out(AVFormatContext *s,
     int subtitle_out_size, nb, i;
     AVCodecContext *enc;
     AVPacket pkt;
+    BenchTimer timer;
 
     if (pts == AV_NOPTS_VALUE) {
         fprintf(stderr, "Subtitle packets must have a pts\n");
@@ -1099,8 +1218,10 @@ static void do_subtitle_out(AVFormatContext *s,
         sub->pts              += av_rescale_q(sub->start_display_time, (AVRational){1, 1000}, AV_TIME_BASE_Q);
         sub->end_display_time -= sub->start_display_time;
         sub->start_display_time = 0;
+        bench_start(&timer);
         subtitle_out_size = avcodec_encode_subtitle(enc, subtitle_out,
                                                     subtitle_out_max_size, sub);
+        bench_stop(&timer, &ost->bench, BENCH_ENCODE);
         if (subtitle_out_size < 0) {
             fprintf(stderr, "Subtitle encoding failed\n");
             av_exit(1);
@@ -1119,7 +1240,7 @@ static void do_subtitle_out(AVFormatContext *s,
             else
                 pkt.pts += 90 * sub->end_display_time;
         }
-        write_frame(s, &pkt, ost->st->codec, bitstream_filters[ost->file_index][pkt.stream_index]);
+        write_frame(s, &pkt, ost);
     }
 }
 
@@ -1140,6 +1261,7 @@ static void do_video_out(AVFormatContext *s,
     AVFrame picture_crop_temp, picture_pad_temp;
     AVCodecContext *enc, *dec;
     double sync_ipts;
+    BenchTimer timer;
 
     avcodec_get_frame_defaults(&picture_crop_temp);
     avcodec_get_frame_defaults(&picture_pad_temp);
@@ -1257,8 +1379,10 @@ static void do_video_out(AVFormatContext *s,
                 av_exit(1);
             }
         }
+        bench_start(&timer);
         sws_scale(ost->img_resample_ctx, formatted_picture->data, formatted_picture->linesize,
               0, ost->resample_height, resampling_dst->data, resampling_dst->linesize);
+        bench_stop(&timer, &ost->bench, BENCH_FILTER);
     }
 #endif
 
@@ -1279,7 +1403,7 @@ static void do_video_out(AVFormatContext *s,
             pkt.pts= av_rescale_q(ost->sync_opts, enc->time_base, ost->st->time_base);
             pkt.flags |= AV_PKT_FLAG_KEY;
 
-            write_frame(s, &pkt, ost->st->codec, bitstream_filters[ost->file_index][pkt.stream_index]);
+            write_frame(s, &pkt, ost);
             enc->coded_frame = old_frame;
         } else {
             AVFrame big_picture;
@@ -1307,9 +1431,11 @@ static void do_video_out(AVFormatContext *s,
             big_picture.pts= ost->sync_opts;
 //            big_picture.pts= av_rescale(ost->sync_opts, AV_TIME_BASE*(int64_t)enc->time_base.num, enc->time_base.den);
 //av_log(NULL, AV_LOG_DEBUG, "%"PRId64" -> encoder\n", ost->sync_opts);
+            bench_start(&timer);
             ret = avcodec_encode_video(enc,
                                        bit_buffer, bit_buffer_size,
                                        &big_picture);
+            bench_stop(&timer, &ost->bench, BENCH_ENCODE);
             if (ret < 0) {
                 fprintf(stderr, "Video encoding failed\n");
                 av_exit(1);
@@ -1326,7 +1452,7 @@ static void do_video_out(AVFormatContext *s,
 
                 if(enc->coded_frame->key_frame)
                     pkt.flags |= AV_PKT_FLAG_KEY;
-                write_frame(s, &pkt, ost->st->codec, bitstream_filters[ost->file_index][pkt.stream_index]);
+                write_frame(s, &pkt, ost);
                 *frame_size = ret;
                 video_size += ret;
                 //fprintf(stderr,"\nFrame: %3d size: %5d type: %d",
@@ -1488,6 +1614,18 @@ static void print_report(AVFormatContext **output_files,
           snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), " dup=%d drop=%d",
                   nb_frames_dup, nb_frames_drop);
 
+        if (do_benchmark_stages) {
+            /* share of each stage in the time spent in all of them */
+            int64_t stages_time = 0;
+            int j;
+            for (j = 0; j < BENCH_NB; j++)
+                stages_time += bench_total.wall[j];
+            for (j = 0; j < BENCH_NB && stages_time; j++)
+                if (bench_total.count[j])
+                    snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), " %s=%d%%",
+                             bench_stage_names[j], (int)(100 * bench_total.wall[j] / stages_time));
+        }
+
         if (verbose >= 0)
             fprintf(stderr, "%s    \r", buf);
 
@@ -1523,6 +1661,7 @@ static int output_packet(AVInputStream *ist, int ist_index,
 #if CONFIG_AVFILTER
     int frame_available;
 #endif
+    BenchTimer timer;
 
     AVPacket avpkt;
     int bps = av_get_bits_per_sample_format(ist->st->codec->sample_fmt)>>3;
@@ -1573,8 +1712,10 @@ static int output_packet(AVInputStream *ist, int ist_index,
                 decoded_data_size= samples_size;
                     /* XXX: could avoid copy if PCM 16 bits with same
                        endianness as CPU */
+                bench_start(&timer);
                 ret = avcodec_decode_audio3(ist->st->codec, samples, &decoded_data_size,
                                             &avpkt);
+                bench_stop(&timer, &ist->bench, BENCH_DECODE);
                 if (ret < 0)
                     goto fail_decode;
                 avpkt.data += ret;
@@ -1595,8 +1736,10 @@ static int output_packet(AVInputStream *ist, int ist_index,
                     /* XXX: allocate picture correctly */
                     avcodec_get_frame_defaults(&picture);
 
+                    bench_start(&timer);
                     ret = avcodec_decode_video2(ist->st->codec,
                                                 &picture, &got_picture, &avpkt);
+                    bench_stop(&timer, &ist->bench, BENCH_DECODE);
                     ist->st->quality= picture.quality;
                     if (ret < 0)
                         goto fail_decode;
@@ -1613,8 +1756,10 @@ static int output_packet(AVInputStream *ist, int ist_index,
                     avpkt.size = 0;
                     break;
             case AVMEDIA_TYPE_SUBTITLE:
+                bench_start(&timer);
                 ret = avcodec_decode_subtitle2(ist->st->codec,
                                                &subtitle, &got_subtitle, &avpkt);
+                bench_stop(&timer, &ist->bench, BENCH_DECODE);
                 if (ret < 0)
                     goto fail_decode;
                 if (!got_subtitle) {
@@ -1646,6 +1791,7 @@ static int output_packet(AVInputStream *ist, int ist_index,
         }
 
         buffer_to_free = NULL;
+        bench_start(&timer);
         if (ist->st->codec->codec_type == AVMEDIA_TYPE_VIDEO) {
             pre_process_video_frame(ist, (AVPicture *)&picture,
                                     &buffer_to_free);
@@ -1659,6 +1805,8 @@ static int output_packet(AVInputStream *ist, int ist_index,
                                      ist->st->codec->sample_aspect_ratio);
         }
 #endif
+        if (ist->st->codec->codec_type == AVMEDIA_TYPE_VIDEO)
+            bench_stop(&timer, &ist->bench, BENCH_FILTER);
 
         // preprocess audio (volume)
         if (ist->st->codec->codec_type == AVMEDIA_TYPE_AUDIO) {
@@ -1690,8 +1838,11 @@ static int output_packet(AVInputStream *ist, int ist_index,
         if (start_time == 0 || ist->pts >= start_time)
 #if CONFIG_AVFILTER
         while (frame_available) {
-            if (ist->st->codec->codec_type == AVMEDIA_TYPE_VIDEO && ist->out_video_filter)
+            if (ist->st->codec->codec_type == AVMEDIA_TYPE_VIDEO && ist->out_video_filter) {
+                bench_start(&timer);
                 get_filtered_video_pic(ist->out_video_filter, &ist->picref, &picture, &ist->pts);
+                bench_stop(&timer, &ist->bench, BENCH_FILTER);
+            }
 #endif
             for(i=0;i<nb_ostreams;i++) {
                 int frame_size;
@@ -1775,7 +1926,7 @@ static int output_packet(AVInputStream *ist, int ist_index,
                             opkt.size = data_size;
                         }
 
-                        write_frame(os, &opkt, ost->st->codec, bitstream_filters[ost->file_index][opkt.stream_index]);
+                        write_frame(os, &opkt, ost);
                         ost->st->codec->frame_number++;
                         ost->frame_number++;
                         av_free_packet(&opkt);
@@ -1829,6 +1980,7 @@ static int output_packet(AVInputStream *ist, int ist_index,
                         av_init_packet(&pkt);
                         pkt.stream_index= ost->index;
 
+                        bench_start(&timer);
                         switch(ost->st->codec->codec_type) {
                         case AVMEDIA_TYPE_AUDIO:
                             fifo_bytes = av_fifo_size(ost->fifo);
@@ -1879,6 +2031,7 @@ static int output_packet(AVInputStream *ist, int ist_index,
                         default:
                             ret=-1;
                         }
+                        bench_stop(&timer, &ost->bench, BENCH_ENCODE);
 
                         if(ret<=0)
                             break;
@@ -1886,7 +2039,7 @@ static int output_packet(AVInputStream *ist, int ist_index,
                         pkt.size= ret;
                         if(enc->coded_frame && enc->coded_frame->pts != AV_NOPTS_VALUE)
                             pkt.pts= av_rescale_q(enc->coded_frame->pts, enc->time_base, ost->st->time_base);
-                        write_frame(os, &pkt, ost->st->codec, bitstream_filters[ost->file_index][pkt.stream_index]);
+                        write_frame(os, &pkt, ost);
                     }
                 }
             }
@@ -1968,6 +2121,7 @@ static int av_transcode(AVFormatContext **output_files,
     int want_sdp = 1;
     uint8_t no_packet[MAX_FILES]={0};
     int no_packet_count=0;
+    BenchTimer timer;
 
     file_table= av_mallocz(nb_input_files * sizeof(AVInputFile));
     if (!file_table)
@@ -2365,6 +2519,11 @@ static int av_transcode(AVFormatContext **output_files,
                 ret = AVERROR(EINVAL);
                 goto dump_format;
             }
+#if CONFIG_AVFILTER
+            /* decode straight into the buffers of the filter graph */
+            if (ist->st->codec->codec_type == AVMEDIA_TYPE_VIDEO && ist->input_video_filter)
+                av_vsrc_buffer_set_codec(ist->input_video_filter, ist->st->codec);
+#endif
             //if (ist->st->codec->codec_type == AVMEDIA_TYPE_VIDEO)
             //    ist->st->codec->flags |= CODEC_FLAG_REPEAT_FIELD;
         }
@@ -2540,7 +2699,12 @@ static int av_transcode(AVFormatContext **output_files,
 
         /* read a frame from it and output it in the fifo */
         is = input_files[file_index];
+        bench_start(&timer);
         ret= av_read_frame(is, &pkt);
+        if (ret >= 0 && pkt.stream_index < file_table[file_index].nb_streams)
+            bench_stop(&timer, &ist_table[file_table[file_index].ist_index + pkt.stream_index]->bench, BENCH_DEMUX);
+        else
+            bench_stop(&timer, NULL, BENCH_DEMUX);
         if(ret == AVERROR(EAGAIN)){
             no_packet[file_index]=1;
             no_packet_count++;
@@ -2635,12 +2799,29 @@ static int av_transcode(AVFormatContext **output_files,
     /* write the trailer if needed and close file */
     for(i=0;i<nb_output_files;i++) {
         os = output_files[i];
+        bench_start(&timer);
         av_write_trailer(os);
+        bench_stop(&timer, NULL, BENCH_MUX);
     }
 
     /* dump report by using the first video and audio streams */
     print_report(output_files, ost_table, nb_ostreams, 1);
 
+    if (do_benchmark_stages && verbose >= 0) {
+        char name[32];
+        for(i=0;i<nb_istreams;i++) {
+            ist = ist_table[i];
+            snprintf(name, sizeof(name), "input #%d.%d", ist->file_index, ist->index);
+            print_bench_stats(name, &ist->bench);
+        }
+        for(i=0;i<nb_ostreams;i++) {
+            ost = ost_table[i];
+            snprintf(name, sizeof(name), "output #%d.%d", ost->file_index, ost->index);
+            print_bench_stats(name, &ost->bench);
+        }
+        print_bench_stats("total", &bench_total);
+    }
+
     /* close each encoder */
     for(i=0;i<nb_ostreams;i++) {
         ost = ost_table[i];
@@ -3764,24 +3945,6 @@ static void opt_pass(const char *pass_str)
     do_pass = pass;
 }
 
-static int64_t getutime(void)
-{
-#if HAVE_GETRUSAGE
-    struct rusage rusage;
-
-    getrusage(RUSAGE_SELF, &rusage);
-    return (rusage.ru_utime.tv_sec * 1000000LL) + rusage.ru_utime.tv_usec;
-#elif HAVE_GETPROCESSTIMES
-    HANDLE proc;
-    FILETIME c, e, k, u;
-    proc = GetCurrentProcess();
-    GetProcessTimes(proc, &c, &e, &k, &u);
-    return ((int64_t) u.dwHighDateTime << 32 | u.dwLowDateTime) / 10;
-#else
-    return av_gettime();
-#endif
-}
-
 static int64_t getmaxrss(void)
 {
 #if HAVE_GETRUSAGE && HAVE_STRUCT_RUSAGE_RU_MAXRSS
@@ -4141,6 +4304,10 @@ static const OptionDef options[] = {
     { "dframes", OPT_INT | HAS_ARG, {(void*)&max_frames[AVMEDIA_TYPE_DATA]}, "set the number of data frames to record", "number" },
     { "benchmark", OPT_BOOL | OPT_EXPERT, {(void*)&do_benchmark},
       "add timings for benchmarking" },
+    { "benchmark_stages", OPT_BOOL | OPT_EXPERT, {(void*)&do_benchmark_stages},
+      "add per stream timings of each processing stage" },
+    { "trace", HAS_ARG | OPT_STRING | OPT_EXPERT, {(void*)&trace_filename},
+      "write the time spent in each demuxer, decoder, filter, encoder and muxer call to a trace file", "filename" },
     { "timelimit", OPT_FUNC2 | HAS_ARG, {(void*)opt_timelimit}, "set max runtime in seconds", "limit" },
     { "dump", OPT_BOOL | OPT_EXPERT, {(void*)&do_pkt_dump},
       "dump each input packet" },
@@ -4299,6 +4466,11 @@ int main(int argc, char **argv)
         av_exit(1);
     }
 
+    if (trace_filename && av_trace_start(trace_filename) < 0) {
+        fprintf(stderr, "Could not open trace file '%s'\n", trace_filename);
+        av_exit(1);
+    }
+
     ti = getutime();
     if (av_transcode(output_files, nb_output_files, input_files, nb_input_files,
                      stream_maps, nb_stream_maps) < 0)
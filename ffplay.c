@@ -64,6 +64,17 @@ const int program_birth_year = 2003;
    A/V sync as SDL does not have hardware buffer fullness info. */
 #define SDL_AUDIO_BUFFER_SIZE 1024
 
+/* limits used in low delay mode, meant for live sources */
+#define LOW_DELAY_PROBESIZE 32768
+#define LOW_DELAY_ANALYZE_DURATION (AV_TIME_BASE / 2)
+#define LOW_DELAY_QUEUE_SIZE (256 * 1024)
+#define LOW_DELAY_AUDIO_BUFFER_SIZE 512
+/* latency (in seconds) above which playback catches up by shortening
+   the audio frames or showing the video frames immediately */
+#define LOW_DELAY_TARGET 0.1
+/* latency above which whole audio frames are dropped */
+#define LOW_DELAY_DROP_THRESHOLD 0.5
+
 /* no AV sync correction is done if below the AV sync threshold */
 #define AV_SYNC_THRESHOLD 0.01
 /* no AV correction is done if too big error */
@@ -132,6 +143,7 @@ typedef struct VideoState {
     int seek_flags;
     int64_t seek_pos;
     int64_t seek_rel;
+    int64_t seek_target;     /* target of the last accurate seek, in AV_TIME_BASE units */
     int read_pause_return;
     AVFormatContext *ic;
     int dtg_active_format;
@@ -143,6 +155,8 @@ typedef struct VideoState {
     int64_t external_clock_time;
 
     double audio_clock;
+    int64_t audio_recv_pts; /* pts of the last queued audio packet */
+    int64_t audio_seek_target; /* audio before this time is dropped */
     double audio_diff_cum; /* used for AV difference average computation */
     double audio_diff_avg_coef;
     double audio_diff_threshold;
@@ -190,6 +204,8 @@ typedef struct VideoState {
     double video_current_pts;                    ///<current displayed pts (different from video_clock if frame fifos are used)
     double video_current_pts_drift;              ///<video_current_pts - time (av_gettime) at which we updated video_current_pts - used to have running video pts
     int64_t video_current_pos;                   ///<current displayed file pos
+    int64_t video_recv_pts;                      ///<pts of the last queued video packet
+    int64_t video_seek_target;                   ///<frames before this time (AV_TIME_BASE units) are decoded but not shown
     VideoPicture pictq[VIDEO_PICTURE_QUEUE_SIZE];
     int pictq_size, pictq_rindex, pictq_windex;
     SDL_mutex *pictq_mutex;
@@ -261,6 +277,8 @@ static int decoder_reorder_pts= -1;
 static int autoexit;
 static int loop=1;
 static int framedrop=1;
+static int low_delay = 0;
+static int accurate_seek = 0;
 
 static int rdftspeed=20;
 #if CONFIG_AVFILTER
@@ -1087,6 +1105,27 @@ static double get_master_clock(VideoState *is)
     return val;
 }
 
+/* get the time between the last received packet of the stream driving
+   the master clock and the master clock, i.e. the playback latency
+   added by the queues and the decoders */
+static double get_latency(VideoState *is)
+{
+    int64_t pts;
+    AVStream *st;
+
+    if (is->audio_st && (is->av_sync_type != AV_SYNC_VIDEO_MASTER || !is->video_st)) {
+        st  = is->audio_st;
+        pts = is->audio_recv_pts;
+    } else if (is->video_st) {
+        st  = is->video_st;
+        pts = is->video_recv_pts;
+    } else
+        return 0;
+    if (pts == AV_NOPTS_VALUE)
+        return 0;
+    return FFMAX(pts * av_q2d(st->time_base) - get_master_clock(is), 0);
+}
+
 /* seek in the stream */
 static void stream_seek(VideoState *is, int64_t pos, int64_t rel, int seek_by_bytes)
 {
@@ -1144,6 +1183,10 @@ static double compute_target_time(double frame_current_pts, VideoState *is)
             else if (diff >= sync_threshold)
                 delay = 2 * delay;
         }
+    } else if (low_delay && get_latency(is) > LOW_DELAY_TARGET) {
+        /* video is the master clock: show the queued frames as soon as
+           possible until the latency is back under the target */
+        delay = 0;
     }
     is->frame_timer += delay;
 #if defined(DEBUG_SYNC)
@@ -1285,12 +1328,29 @@ retry:
             av_diff = 0;
             if (is->audio_st && is->video_st)
                 av_diff = get_audio_clock(is) - get_video_clock(is);
-            printf("%7.2f A-V:%7.3f s:%3.1f aq=%5dKB vq=%5dKB sq=%5dB f=%"PRId64"/%"PRId64"   \r",
+            printf("%7.2f A-V:%7.3f s:%3.1f aq=%5dKB vq=%5dKB sq=%5dB f=%"PRId64"/%"PRId64"   ",
                    get_master_clock(is), av_diff, FFMAX(is->skip_frames-1, 0), aqsize / 1024, vqsize / 1024, sqsize, is->faulty_dts, is->faulty_pts);
+            if (low_delay)
+                printf("lat:%6.3f   ", get_latency(is));
+            printf("\r");
             fflush(stdout);
             last_time = cur_time;
         }
     }
+    if (low_delay && screen) {
+        static int64_t last_time;
+        int64_t cur_time;
+        char caption[1024];
+
+        /* show the latency in the window title */
+        cur_time = av_gettime();
+        if (!last_time || (cur_time - last_time) >= 500000) {
+            snprintf(caption, sizeof(caption), "%s - latency %d ms",
+                     window_title, (int)(get_latency(is) * 1000));
+            SDL_WM_SetCaption(caption, window_title);
+            last_time = cur_time;
+        }
+    }
 }
 
 /* allocate a picture (needs to do that in main thread to avoid
@@ -1481,6 +1541,44 @@ static int output_picture2(VideoState *is, AVFrame *src_frame, double pts1, int6
     return queue_picture(is, src_frame, pts, pos);
 }
 
+/* return 1 if the frame with the given pts is still before the target
+   of the accurate seek in progress */
+static int video_seek_target_pending(VideoState *is, int64_t pts)
+{
+    AVStream *st = is->video_st;
+    int64_t half_frame = 0;
+
+    if (st->r_frame_rate.num && st->r_frame_rate.den)
+        half_frame = av_rescale(AV_TIME_BASE / 2, st->r_frame_rate.den, st->r_frame_rate.num);
+
+    return av_rescale_q(pts, st->time_base, AV_TIME_BASE_Q) < is->video_seek_target - half_frame;
+}
+
+/* while seeking accurately, let the decoder skip the non reference
+   frames and the non reference processing of the packets which are
+   before the seek target. A NULL packet restores the user settings. */
+static void set_seek_discard(VideoState *is, AVPacket *pkt)
+{
+    AVCodecContext *avctx = is->video_st->codec;
+    int64_t pkt_pts = AV_NOPTS_VALUE;
+
+    if (pkt) {
+        /* the dts of a frame can only be used as pts without B-frames */
+        pkt_pts = pkt->pts;
+        if (pkt_pts == AV_NOPTS_VALUE && !avctx->has_b_frames)
+            pkt_pts = pkt->dts;
+    }
+    if (pkt_pts != AV_NOPTS_VALUE && video_seek_target_pending(is, pkt_pts)) {
+        avctx->skip_frame       = FFMAX(skip_frame,       AVDISCARD_NONREF);
+        avctx->skip_idct        = FFMAX(skip_idct,        AVDISCARD_NONREF);
+        avctx->skip_loop_filter = FFMAX(skip_loop_filter, AVDISCARD_NONREF);
+    } else {
+        avctx->skip_frame       = skip_frame;
+        avctx->skip_idct        = skip_idct;
+        avctx->skip_loop_filter = skip_loop_filter;
+    }
+}
+
 static int get_video_frame(VideoState *is, AVFrame *frame, int64_t *pts, AVPacket *pkt)
 {
     int len1, got_picture, i;
@@ -1509,9 +1607,14 @@ static int get_video_frame(VideoState *is, AVFrame *frame, int64_t *pts, AVPacke
             is->frame_timer = (double)av_gettime() / 1000000.0;
             is->skip_frames= 1;
             is->skip_frames_index= 0;
+            is->video_seek_target= is->seek_target;
+            set_seek_discard(is, NULL);
             return 0;
         }
 
+        if (is->video_seek_target != AV_NOPTS_VALUE)
+            set_seek_discard(is, pkt);
+
         /* NOTE: ipts is the PTS of the _first_ picture beginning in
            this packet, if any */
         is->video_st->codec->reordered_opaque= pkt->pts;
@@ -1542,6 +1645,15 @@ static int get_video_frame(VideoState *is, AVFrame *frame, int64_t *pts, AVPacke
 
 //            if (len1 < 0)
 //                break;
+    if (got_picture && is->video_seek_target != AV_NOPTS_VALUE) {
+        /* frames before the target of an accurate seek are only decoded
+           as references, they are neither converted nor displayed */
+        if (   (pkt->dts != AV_NOPTS_VALUE || frame->reordered_opaque != AV_NOPTS_VALUE)
+            && video_seek_target_pending(is, *pts))
+            return 0;
+        is->video_seek_target = AV_NOPTS_VALUE;
+        set_seek_discard(is, NULL);
+    }
     if (got_picture){
         is->skip_frames_index += 1;
         if(is->skip_frames_index >= is->skip_frames){
@@ -2039,6 +2151,18 @@ static int synchronize_audio(VideoState *is, short *samples,
             is->audio_diff_avg_count = 0;
             is->audio_diff_cum = 0;
         }
+    } else if (low_delay) {
+        /* audio is the master clock: instead of letting the delay grow,
+           play the audio faster by removing samples, or drop whole frames
+           if we are too late */
+        double latency = get_latency(is);
+
+        if (latency > LOW_DELAY_DROP_THRESHOLD) {
+            samples_size = 0;
+        } else if (latency > LOW_DELAY_TARGET) {
+            int nb_samples = samples_size / n;
+            samples_size = ((nb_samples * (100 - SAMPLE_CORRECTION_PERCENT_MAX)) / 100) * n;
+        }
     }
 
     return samples_size;
@@ -2105,10 +2229,26 @@ static int audio_decode_frame(VideoState *is, double *pts_ptr)
 
             /* if no pts, then compute it */
             pts = is->audio_clock;
-            *pts_ptr = pts;
             n = 2 * dec->channels;
             is->audio_clock += (double)data_size /
                 (double)(n * dec->sample_rate);
+
+            if (is->audio_seek_target != AV_NOPTS_VALUE) {
+                /* drop the samples before the target of an accurate seek */
+                double target = (double)is->audio_seek_target / AV_TIME_BASE;
+                int skip;
+
+                if (is->audio_clock <= target)
+                    continue;
+                skip = (int)((target - pts) * dec->sample_rate) * n;
+                if (skip > 0) {
+                    is->audio_buf += skip;
+                    data_size     -= skip;
+                    pts            = target;
+                }
+                is->audio_seek_target = AV_NOPTS_VALUE;
+            }
+            *pts_ptr = pts;
 #if defined(DEBUG_SYNC)
             {
                 static double last_clock;
@@ -2134,6 +2274,7 @@ static int audio_decode_frame(VideoState *is, double *pts_ptr)
             return -1;
         if(pkt->data == flush_pkt.data){
             avcodec_flush_buffers(dec);
+            is->audio_seek_target = is->seek_target;
             continue;
         }
 
@@ -2239,7 +2380,7 @@ static int stream_component_open(VideoState *is, int stream_index)
         wanted_spec.format = AUDIO_S16SYS;
         wanted_spec.channels = avctx->channels;
         wanted_spec.silence = 0;
-        wanted_spec.samples = SDL_AUDIO_BUFFER_SIZE;
+        wanted_spec.samples = low_delay ? LOW_DELAY_AUDIO_BUFFER_SIZE : SDL_AUDIO_BUFFER_SIZE;
         wanted_spec.callback = sdl_audio_callback;
         wanted_spec.userdata = is;
         if (SDL_OpenAudio(&wanted_spec, &spec) < 0) {
@@ -2263,7 +2404,7 @@ static int stream_component_open(VideoState *is, int stream_index)
         is->audio_diff_avg_count = 0;
         /* since we do not have a precise anough audio fifo fullness,
            we correct audio sync only if larger than this threshold */
-        is->audio_diff_threshold = 2.0 * SDL_AUDIO_BUFFER_SIZE / avctx->sample_rate;
+        is->audio_diff_threshold = 2.0 * spec.samples / avctx->sample_rate;
 
         memset(&is->audio_pkt, 0, sizeof(is->audio_pkt));
         packet_queue_init(&is->audioq);
@@ -2385,6 +2526,7 @@ static int decode_thread(void *arg)
     AVFormatParameters params, *ap = &params;
     int eof=0;
     int pkt_in_play_range = 0;
+    int max_queue_size = low_delay ? LOW_DELAY_QUEUE_SIZE : MAX_QUEUE_SIZE;
 
     ic = avformat_alloc_context();
 
@@ -2405,6 +2547,12 @@ static int decode_thread(void *arg)
     ap->time_base= (AVRational){1, 25};
     ap->pix_fmt = frame_pix_fmt;
 
+    if (low_delay) {
+        /* probe as little as possible, the options given by the user
+           still take precedence */
+        ic->probesize            = LOW_DELAY_PROBESIZE;
+        ic->max_analyze_duration = LOW_DELAY_ANALYZE_DURATION;
+    }
     set_context_opts(ic, avformat_opts, AV_OPT_FLAG_DECODING_PARAM);
 
     err = av_open_input_file(&ic, is->filename, is->iformat, 0, ap);
@@ -2438,11 +2586,13 @@ static int decode_thread(void *arg)
         /* add the stream start time */
         if (ic->start_time != AV_NOPTS_VALUE)
             timestamp += ic->start_time;
-        ret = avformat_seek_file(ic, -1, INT64_MIN, timestamp, INT64_MAX, 0);
+        ret = avformat_seek_file(ic, -1, INT64_MIN, timestamp,
+                                 accurate_seek ? timestamp : INT64_MAX, 0);
         if (ret < 0) {
             fprintf(stderr, "%s: could not seek to position %0.3f\n",
                     is->filename, (double)timestamp / AV_TIME_BASE);
-        }
+        } else if (accurate_seek)
+            is->seek_target = timestamp;
     }
 
     for(i = 0; i < ic->nb_streams; i++) {
@@ -2525,11 +2675,19 @@ static int decode_thread(void *arg)
             int64_t seek_max= is->seek_rel < 0 ? seek_target - is->seek_rel - 2: INT64_MAX;
 //FIXME the +-2 is due to rounding being not done in the correct direction in generation
 //      of the seek_pos/seek_rel variables
+            int accurate = accurate_seek && !(is->seek_flags & AVSEEK_FLAG_BYTE);
 
+            if (accurate) {
+                /* start decoding from the keyframe before the target,
+                   even if it is before the current position */
+                seek_min = INT64_MIN;
+                seek_max = seek_target;
+            }
             ret = avformat_seek_file(is->ic, -1, seek_min, seek_target, seek_max, is->seek_flags);
             if (ret < 0) {
                 fprintf(stderr, "%s: error while seeking\n", is->ic->filename);
             }else{
+                is->seek_target = accurate ? seek_target : AV_NOPTS_VALUE;
                 if (is->audio_stream >= 0) {
                     packet_queue_flush(&is->audioq);
                     packet_queue_put(&is->audioq, &flush_pkt);
@@ -2542,14 +2700,19 @@ static int decode_thread(void *arg)
                     packet_queue_flush(&is->videoq);
                     packet_queue_put(&is->videoq, &flush_pkt);
                 }
+                is->audio_recv_pts = AV_NOPTS_VALUE;
+                is->video_recv_pts = AV_NOPTS_VALUE;
             }
             is->seek_req = 0;
             eof= 0;
         }
 
-        /* if the queue are full, no need to read more */
-        if (   is->audioq.size + is->videoq.size + is->subtitleq.size > MAX_QUEUE_SIZE
-            || (   (is->audioq   .size  > MIN_AUDIOQ_SIZE || is->audio_stream<0)
+        /* if the queue are full, no need to read more. In low delay mode
+           keep reading so that the data does not wait in the network
+           buffers, the queues are kept short by the catch-up logic */
+        if (   is->audioq.size + is->videoq.size + is->subtitleq.size > max_queue_size
+            || (   !low_delay
+                && (is->audioq   .size  > MIN_AUDIOQ_SIZE || is->audio_stream<0)
                 && (is->videoq   .nb_packets > MIN_FRAMES || is->video_stream<0)
                 && (is->subtitleq.nb_packets > MIN_FRAMES || is->subtitle_stream<0))) {
             /* wait 10 ms */
@@ -2591,8 +2754,12 @@ static int decode_thread(void *arg)
                 (double)(start_time != AV_NOPTS_VALUE ? start_time : 0)/1000000
                 <= ((double)duration/1000000);
         if (pkt->stream_index == is->audio_stream && pkt_in_play_range) {
+            if (pkt->pts != AV_NOPTS_VALUE)
+                is->audio_recv_pts = pkt->pts;
             packet_queue_put(&is->audioq, pkt);
         } else if (pkt->stream_index == is->video_stream && pkt_in_play_range) {
+            if (pkt->pts != AV_NOPTS_VALUE)
+                is->video_recv_pts = pkt->pts;
             packet_queue_put(&is->videoq, pkt);
         } else if (pkt->stream_index == is->subtitle_stream && pkt_in_play_range) {
             packet_queue_put(&is->subtitleq, pkt);
@@ -2653,6 +2820,11 @@ static VideoState *stream_open(const char *filename, AVInputFormat *iformat)
     is->subpq_cond = SDL_CreateCond();
 
     is->av_sync_type = av_sync_type;
+    is->audio_recv_pts = AV_NOPTS_VALUE;
+    is->video_recv_pts = AV_NOPTS_VALUE;
+    is->seek_target = AV_NOPTS_VALUE;
+    is->audio_seek_target = AV_NOPTS_VALUE;
+    is->video_seek_target = AV_NOPTS_VALUE;
     is->parse_tid = SDL_CreateThread(decode_thread, is);
     if (!is->parse_tid) {
         av_free(is);
@@ -3066,6 +3238,8 @@ static const OptionDef options[] = {
     { "autoexit", OPT_BOOL | OPT_EXPERT, {(void*)&autoexit}, "exit at the end", "" },
     { "loop", OPT_INT | HAS_ARG | OPT_EXPERT, {(void*)&loop}, "set number of times the playback shall be looped", "loop count" },
     { "framedrop", OPT_BOOL | OPT_EXPERT, {(void*)&framedrop}, "drop frames when cpu is too slow", "" },
+    { "accurate_seek", OPT_BOOL | OPT_EXPERT, {(void*)&accurate_seek}, "show the exact seek position instead of the preceding keyframe", "" },
+    { "lowdelay", OPT_BOOL | OPT_EXPERT, {(void*)&low_delay}, "minimize the playback latency of live sources", "" },
     { "window_title", OPT_STRING | HAS_ARG, {(void*)&window_title}, "set window title", "window title" },
 #if CONFIG_AVFILTER
     { "vf", OPT_STRING | HAS_ARG, {(void*)&vfilters}, "video filters", "filter list" },
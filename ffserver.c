@@ -34,6 +34,7 @@
 #include "libavformat/rtpdec.h"
 #include "libavformat/rtsp.h"
 #include "libavutil/avstring.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/lfg.h"
 #include "libavutil/random_seed.h"
 #include "libavcodec/opt.h"
@@ -41,14 +42,21 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #if HAVE_POLL_H
 #include <poll.h>
 #endif
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #include <errno.h>
 #include <sys/time.h>
 #include <time.h>
 #include <sys/wait.h>
 #include <signal.h>
+#if HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 #if HAVE_DLFCN_H
 #include <dlfcn.h>
 #endif
@@ -93,6 +101,10 @@ static const char *http_state[] = {
 
 #define IOBUFFER_INIT_SIZE 8192
 
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
 /* timeouts are in ms */
 #define HTTP_REQUEST_TIMEOUT (15 * 1000)
 #define RTSP_REQUEST_TIMEOUT (3600 * 24 * 1000)
@@ -109,12 +121,29 @@ typedef struct {
     int64_t time1, time2;
 } DataRateData;
 
+#define BACKLOG_BUCKETS 6
+
+/* output statistics of a connection, or of all the connections of a
+   stream. Times are in us. */
+typedef struct OutputStats {
+    int64_t prepare_time;       /* time spent preparing the data to send */
+    int64_t send_time;          /* time spent in the send calls */
+    int64_t nb_sends;
+    int64_t nb_blocked;         /* send calls which could not send everything */
+    int64_t drops;              /* packets skipped because the connection was too slow */
+    int64_t backlog[BACKLOG_BUCKETS]; /* histogram of the data left after each send call */
+} OutputStats;
+
 /* context associated with one connection */
 typedef struct HTTPContext {
     enum HTTPState state;
     int fd; /* socket file descriptor */
     struct sockaddr_in from_addr; /* origin */
     struct pollfd *poll_entry; /* used when polling */
+    struct pollfd poll_ev;     /* events reported by the epoll backend */
+    int poll_events;           /* events registered with epoll, 0 if none */
+    int timed;                 /* true if it is in the timed_ctx table */
+    int timed_index;           /* index in the timed_ctx table */
     int64_t timeout;
     uint8_t *buffer_ptr, *buffer_end;
     int http_error;
@@ -172,6 +201,19 @@ typedef struct HTTPContext {
     /* RTP/TCP specific */
     struct HTTPContext *rtsp_c;
     uint8_t *packet_buffer, *packet_buffer_ptr, *packet_buffer_end;
+
+    /* shared muxing */
+    struct SharedMux *shared;     /* NULL if the connection muxes its own output */
+    struct MuxBuffer *shared_buf; /* packet being sent */
+    int64_t shared_seq;           /* sequence number of the next packet to send */
+
+    /* feed relaying */
+    int relay;                    /* true if the feed file pages are sent as is */
+    int relay_fd;
+    int64_t relay_pos;            /* position of the next page to send */
+
+    OutputStats stats;
+    int64_t last_dts;             /* dts of the last packet read from the input in us */
 } HTTPContext;
 
 /* each generated stream is described here */
@@ -238,10 +280,19 @@ typedef struct FFStream {
     int truncate;        /* True if feeder connection truncate the feed file */
     int conns_served;
     int64_t bytes_served;
+    OutputStats stats;
     int64_t feed_max_size;      /* maximum storage size, zero means unlimited */
     int64_t feed_write_index;   /* current write position in feed (it wraps around) */
     int64_t feed_size;          /* current size of feed */
+    int64_t feed_head_dts;      /* dts of the last page written to the feed, 0 if unknown */
+    struct FeedState *shared_state; /* copy shared by the workers, NULL if only one */
+    int mapped;                 /* true if the feed file must be memory mapped */
+    uint8_t *map;               /* mapping of the feed file, NULL if none */
     struct FFStream *next_feed;
+
+    /* shared muxing */
+    int shared_mux_size;        /* ring size in packets, 0 if each connection muxes */
+    struct SharedMux *shared_mux; /* NULL if nobody is connected */
 } FFStream;
 
 typedef struct FeedData {
@@ -249,6 +300,43 @@ typedef struct FeedData {
     float avg_frame_size;   /* frame size averaged over last frames with exponential mean */
 } FeedData;
 
+/* state of a feed which must be seen by all the worker processes */
+typedef struct FeedState {
+    int64_t write_index;
+    int64_t size;
+    int64_t head_dts;
+    int opened;
+} FeedState;
+
+/* one muxed output packet of a shared stream, referenced by the ring
+   and by the connections which are sending it */
+typedef struct MuxBuffer {
+    int refcount;
+    int size;
+    int key;                    /* true if it starts a key frame */
+    int64_t dts;                /* dts of the packet in us */
+    uint8_t data[1];
+} MuxBuffer;
+
+/* live stream demuxed from its feed and muxed once for all its HTTP
+   connections, which only keep a cursor into the ring of output packets */
+typedef struct SharedMux {
+    FFStream *stream;
+    AVFormatContext *fmt_in;
+    AVFormatContext fmt_ctx;
+    uint8_t *header;            /* output of av_write_header() */
+    int header_size;
+    int header_written;
+    MuxBuffer **ring;
+    int ring_size;
+    int64_t head;               /* sequence number of the next packet */
+    int64_t last_key;           /* sequence number of the last key packet, -1 if none */
+    int got_key_frame;
+    int pending_key;            /* a key frame was given to the muxer but not output yet */
+    int nb_clients;
+    int64_t drops;              /* packets skipped by lagging connections */
+} SharedMux;
+
 static struct sockaddr_in my_http_addr;
 static struct sockaddr_in my_rtsp_addr;
 
@@ -259,13 +347,18 @@ static FFStream *first_stream; /* contains all streams, including feeds */
 
 static void new_connection(int server_fd, int is_rtsp);
 static void close_connection(HTTPContext *c);
+static void update_poll_events(HTTPContext *c);
 
 /* HTTP handling */
 static int handle_connection(HTTPContext *c);
 static int http_parse_request(HTTPContext *c);
 static int http_send_data(HTTPContext *c);
-static void compute_status(HTTPContext *c);
+static void compute_status(HTTPContext *c, const char *info);
 static int open_input_stream(HTTPContext *c, const char *info);
+static int open_relay(HTTPContext *c);
+static void close_input_stream(AVFormatContext *s);
+static int shared_mux_attach(HTTPContext *c);
+static void shared_mux_detach(HTTPContext *c);
 static int http_start_receive_data(HTTPContext *c);
 static int http_receive_data(HTTPContext *c);
 
@@ -308,8 +401,31 @@ static unsigned int nb_connections;
 static uint64_t max_bandwidth = 1000;
 static uint64_t current_bandwidth;
 
+/* worker processes, each one running its own event loop on the
+   listening sockets. The connection and bandwidth limits apply to
+   each worker. */
+static int nb_workers = 1;
+static int worker_index;           /* 0 for the main process */
+static pid_t *worker_pids;
+static int *worker_loads;          /* shared number of connections of each worker */
+static int *worker_accepting;      /* shared, true if the worker polls the listening sockets */
+
 static int64_t cur_time;           // Making this global saves on passing it around everywhere
 
+/* event loop backend */
+static int use_epoll = 1;          /* use epoll instead of poll() when available */
+static int epoll_fd = -1;          /* epoll instance, -1 if poll() is used */
+
+/* connections which must be handled at each tick of the epoll loop,
+   because ffserver does the timing of their output */
+static HTTPContext **timed_ctx;
+static int nb_timed_ctx, timed_ctx_size;
+
+/* event loop statistics, in microseconds */
+static int64_t loop_count;
+static int64_t loop_latency_avg;   /* exponential mean of the time spent handling events */
+static int64_t loop_latency_max;
+
 static AVLFG random_state;
 
 static FILE *logfile = NULL;
@@ -577,54 +693,200 @@ static void start_multicast(void)
 
             /* change state to send data */
             rtp_c->state = HTTPSTATE_SEND_DATA;
+            update_poll_events(rtp_c);
         }
     }
 }
 
-/* main loop of the http server */
-static int http_server(void)
+/* return the events a connection waits for in its current state, and
+   whether its output is timed by ffserver instead of the socket */
+static int get_poll_events(HTTPContext *c, int *timed)
 {
-    int server_fd = 0, rtsp_server_fd = 0;
-    int ret, delay, delay1;
-    struct pollfd *poll_table, *poll_entry;
-    HTTPContext *c, *c_next;
+    *timed = 0;
+    switch(c->state) {
+    case HTTPSTATE_SEND_HEADER:
+    case RTSPSTATE_SEND_REPLY:
+    case RTSPSTATE_SEND_PACKET:
+        return POLLOUT;
+    case HTTPSTATE_SEND_DATA_HEADER:
+    case HTTPSTATE_SEND_DATA:
+    case HTTPSTATE_SEND_DATA_TRAILER:
+        /* for TCP, we output as much as we can (may need to put a limit) */
+        if (!c->is_packetized)
+            return POLLOUT;
+        /* when ffserver is doing the timing, we work by looking at
+           which packet need to be sent every 10 ms */
+        *timed = 1;
+        return 0;
+    case HTTPSTATE_WAIT_FEED:
+        /* the feed may be written by another worker, which cannot wake
+           us up: check it at each tick */
+        *timed = nb_workers > 1;
+        return POLLIN;
+    case HTTPSTATE_WAIT_REQUEST:
+    case HTTPSTATE_RECEIVE_DATA:
+    case RTSPSTATE_WAIT_REQUEST:
+        /* need to catch errors */
+        return POLLIN; /* Maybe this will work */
+    default:
+        return 0;
+    }
+}
 
-    if(!(poll_table = av_mallocz((nb_max_http_connections + 2)*sizeof(*poll_table)))) {
-        http_log("Impossible to allocate a poll table handling %d connections.\n", nb_max_http_connections);
-        return -1;
+static void set_poll_events(HTTPContext *c, int events, int timed)
+{
+    if (epoll_fd < 0)
+        return;
+
+    if (timed && !c->timed) {
+        if (nb_timed_ctx >= timed_ctx_size) {
+            int new_size = FFMAX(2 * timed_ctx_size, 16);
+            HTTPContext **t = av_realloc(timed_ctx, new_size * sizeof(*timed_ctx));
+            if (!t)
+                return;
+            timed_ctx = t;
+            timed_ctx_size = new_size;
+        }
+        c->timed = 1;
+        c->timed_index = nb_timed_ctx;
+        timed_ctx[nb_timed_ctx++] = c;
+    } else if (!timed && c->timed) {
+        HTTPContext *last = timed_ctx[--nb_timed_ctx];
+        timed_ctx[c->timed_index] = last;
+        last->timed_index = c->timed_index;
+        c->timed = 0;
     }
 
-    if (my_http_addr.sin_port) {
-        server_fd = socket_open_listen(&my_http_addr);
-        if (server_fd < 0)
-            return -1;
+#if HAVE_SYS_EPOLL_H
+    if (c->fd >= 0 && events != c->poll_events) {
+        struct epoll_event ev;
+        int op = !c->poll_events ? EPOLL_CTL_ADD :
+                 !events         ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+
+        memset(&ev, 0, sizeof(ev));
+        ev.events   = (events & POLLIN  ? EPOLLIN  : 0) |
+                      (events & POLLOUT ? EPOLLOUT : 0);
+        ev.data.ptr = c;
+        if (epoll_ctl(epoll_fd, op, c->fd, &ev) < 0)
+            http_log("epoll_ctl failed on fd %d: %s\n", c->fd, strerror(errno));
+        c->poll_events = events;
     }
+#endif
+}
 
-    if (my_rtsp_addr.sin_port) {
-        rtsp_server_fd = socket_open_listen(&my_rtsp_addr);
-        if (rtsp_server_fd < 0)
-            return -1;
+/* keep the epoll registration and the timed_ctx table of a connection
+   in sync with its state; must be called whenever the state changes
+   outside of the handling of the connection itself */
+static void update_poll_events(HTTPContext *c)
+{
+    int timed, events = get_poll_events(c, &timed);
+    set_poll_events(c, events, timed);
+}
+
+/* handle a connection and close it on error. Return 0 if it was closed */
+static int run_connection(HTTPContext *c)
+{
+    if (handle_connection(c) < 0) {
+        /* close and free the connection */
+        log_connection(c);
+        close_connection(c);
+        return 0;
+    }
+    c->poll_ev.revents = 0;
+    update_poll_events(c);
+    return 1;
+}
+
+static void store_feed_state(FFStream *feed)
+{
+    FeedState *fs = feed->shared_state;
+
+    if (fs) {
+        fs->write_index = feed->feed_write_index;
+        fs->size        = feed->feed_size;
+        fs->head_dts    = feed->feed_head_dts;
+        fs->opened      = feed->feed_opened;
     }
+}
 
-    if (!rtsp_server_fd && !server_fd) {
-        http_log("HTTP and RTSP disabled.\n");
-        return -1;
+/* publish the load of this worker, pick up the feeds written by other
+   workers and wake up the connections waiting for them */
+static void sync_workers(void)
+{
+    FFStream *feed;
+    HTTPContext *c;
+
+    worker_loads[worker_index] = nb_connections;
+
+    for(feed = first_feed; feed != NULL; feed = feed->next_feed) {
+        FeedState *fs = feed->shared_state;
+
+        if (!fs || (fs->write_index == feed->feed_write_index &&
+                    fs->size        == feed->feed_size &&
+                    fs->opened      == feed->feed_opened))
+            continue;
+        feed->feed_write_index = fs->write_index;
+        feed->feed_size        = fs->size;
+        feed->feed_head_dts    = fs->head_dts;
+        feed->feed_opened      = fs->opened;
+
+        for(c = first_http_ctx; c != NULL; c = c->next) {
+            if (c->state == HTTPSTATE_WAIT_FEED &&
+                c->stream->feed == feed) {
+                c->state = feed->feed_opened ? HTTPSTATE_SEND_DATA :
+                                               HTTPSTATE_SEND_DATA_TRAILER;
+                update_poll_events(c);
+            }
+        }
     }
+}
+
+/* all the workers polling the listening sockets are woken up by a new
+   connection: only poll them if no worker with fewer connections does,
+   so that the connections go to the least loaded workers */
+static int accept_connections(void)
+{
+    int i;
 
-    http_log("FFserver started.\n");
+    if (!worker_loads)
+        return 1;
+    for (i = 0; i < nb_workers; i++)
+        if (worker_accepting[i] && worker_loads[i] < (int)nb_connections - 1)
+            break;
+    worker_accepting[worker_index] = i == nb_workers;
+    return worker_accepting[worker_index];
+}
 
-    start_children(first_feed);
+static void update_loop_stats(int64_t start)
+{
+    int64_t latency = av_gettime() - start;
+
+    loop_count++;
+    loop_latency_avg += (latency - loop_latency_avg) / 16;
+    loop_latency_max  = FFMAX(loop_latency_max, latency);
+}
+
+static int poll_loop(int server_fd, int rtsp_server_fd)
+{
+    int ret, delay, delay1, accepting;
+    int64_t start;
+    struct pollfd *poll_table, *poll_entry;
+    HTTPContext *c, *c_next;
 
-    start_multicast();
+    if(!(poll_table = av_mallocz((nb_max_http_connections + 2)*sizeof(*poll_table)))) {
+        http_log("Impossible to allocate a poll table handling %d connections.\n", nb_max_http_connections);
+        return -1;
+    }
 
     for(;;) {
+        accepting = accept_connections();
         poll_entry = poll_table;
-        if (server_fd) {
+        if (server_fd && accepting) {
             poll_entry->fd = server_fd;
             poll_entry->events = POLLIN;
             poll_entry++;
         }
-        if (rtsp_server_fd) {
+        if (rtsp_server_fd && accepting) {
             poll_entry->fd = rtsp_server_fd;
             poll_entry->events = POLLIN;
             poll_entry++;
@@ -634,48 +896,20 @@ static int http_server(void)
         c = first_http_ctx;
         delay = 1000;
         while (c != NULL) {
-            int fd;
-            fd = c->fd;
-            switch(c->state) {
-            case HTTPSTATE_SEND_HEADER:
-            case RTSPSTATE_SEND_REPLY:
-            case RTSPSTATE_SEND_PACKET:
-                c->poll_entry = poll_entry;
-                poll_entry->fd = fd;
-                poll_entry->events = POLLOUT;
-                poll_entry++;
-                break;
-            case HTTPSTATE_SEND_DATA_HEADER:
-            case HTTPSTATE_SEND_DATA:
-            case HTTPSTATE_SEND_DATA_TRAILER:
-                if (!c->is_packetized) {
-                    /* for TCP, we output as much as we can (may need to put a limit) */
-                    c->poll_entry = poll_entry;
-                    poll_entry->fd = fd;
-                    poll_entry->events = POLLOUT;
-                    poll_entry++;
-                } else {
-                    /* when ffserver is doing the timing, we work by
-                       looking at which packet need to be sent every
-                       10 ms */
-                    delay1 = 10; /* one tick wait XXX: 10 ms assumed */
-                    if (delay1 < delay)
-                        delay = delay1;
-                }
-                break;
-            case HTTPSTATE_WAIT_REQUEST:
-            case HTTPSTATE_RECEIVE_DATA:
-            case HTTPSTATE_WAIT_FEED:
-            case RTSPSTATE_WAIT_REQUEST:
-                /* need to catch errors */
+            int events, timed;
+            events = get_poll_events(c, &timed);
+            if (events) {
                 c->poll_entry = poll_entry;
-                poll_entry->fd = fd;
-                poll_entry->events = POLLIN;/* Maybe this will work */
+                poll_entry->fd = c->fd;
+                poll_entry->events = events;
                 poll_entry++;
-                break;
-            default:
+            } else {
                 c->poll_entry = NULL;
-                break;
+            }
+            if (timed) {
+                delay1 = 10; /* one tick wait XXX: 10 ms assumed */
+                if (delay1 < delay)
+                    delay = delay1;
             }
             c = c->next;
         }
@@ -689,38 +923,268 @@ static int http_server(void)
                 return -1;
         } while (ret < 0);
 
-        cur_time = av_gettime() / 1000;
+        start = av_gettime();
+        cur_time = start / 1000;
 
         if (need_to_start_children) {
             need_to_start_children = 0;
             start_children(first_feed);
         }
 
+        if (nb_workers > 1)
+            sync_workers();
+
         /* now handle the events */
         for(c = first_http_ctx; c != NULL; c = c_next) {
             c_next = c->next;
-            if (handle_connection(c) < 0) {
-                /* close and free the connection */
-                log_connection(c);
-                close_connection(c);
-            }
+            run_connection(c);
         }
 
         poll_entry = poll_table;
-        if (server_fd) {
+        if (server_fd && accepting) {
             /* new HTTP connection request ? */
             if (poll_entry->revents & POLLIN)
                 new_connection(server_fd, 0);
             poll_entry++;
         }
-        if (rtsp_server_fd) {
+        if (rtsp_server_fd && accepting) {
             /* new RTSP connection request ? */
             if (poll_entry->revents & POLLIN)
                 new_connection(rtsp_server_fd, 1);
         }
+
+        update_loop_stats(start);
     }
 }
 
+#if HAVE_SYS_EPOLL_H
+#define MAX_EPOLL_EVENTS 256
+
+/* Connections are registered once in the epoll set and their registration
+   is only changed along with their state, so that an iteration only costs
+   the number of ready and timed connections. The registration is level
+   triggered: the connection handlers do a single read or write per call
+   and rely on being called again while the socket stays ready. */
+static int epoll_loop(int server_fd, int rtsp_server_fd)
+{
+    struct epoll_event events[MAX_EPOLL_EVENTS], ev;
+    int64_t start, last_sweep = 0;
+    HTTPContext *c, *c_next;
+    int i, nb_events, accepting = 0;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+
+    /* connections opened before the loop, i.e. multicast ones */
+    for(c = first_http_ctx; c != NULL; c = c->next)
+        update_poll_events(c);
+
+    for(;;) {
+        if (accept_connections() != accepting) {
+            int op = accepting ? EPOLL_CTL_DEL : EPOLL_CTL_ADD;
+
+            accepting = !accepting;
+            if (server_fd) {
+                ev.data.ptr = &server_fd;
+                if (epoll_ctl(epoll_fd, op, server_fd, &ev) < 0)
+                    return -1;
+            }
+            if (rtsp_server_fd) {
+                ev.data.ptr = &rtsp_server_fd;
+                if (epoll_ctl(epoll_fd, op, rtsp_server_fd, &ev) < 0)
+                    return -1;
+            }
+        }
+
+        /* We wait at least every second to handle timeouts */
+        do {
+            nb_events = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS,
+                                   nb_timed_ctx ? 10 : 1000);
+            if (nb_events < 0 && errno != EINTR)
+                return -1;
+        } while (nb_events < 0);
+
+        start = av_gettime();
+        cur_time = start / 1000;
+
+        if (need_to_start_children) {
+            need_to_start_children = 0;
+            start_children(first_feed);
+        }
+
+        if (nb_workers > 1)
+            sync_workers();
+
+        for (i = 0; i < nb_events; i++) {
+            void *ptr = events[i].data.ptr;
+            uint32_t e = events[i].events;
+
+            if (ptr == &server_fd) {
+                new_connection(server_fd, 0);
+            } else if (ptr == &rtsp_server_fd) {
+                new_connection(rtsp_server_fd, 1);
+            } else {
+                c = ptr;
+                c->poll_ev.revents = (e & EPOLLIN  ? POLLIN  : 0) |
+                                     (e & EPOLLOUT ? POLLOUT : 0) |
+                                     (e & EPOLLERR ? POLLERR : 0) |
+                                     (e & EPOLLHUP ? POLLHUP : 0);
+                run_connection(c);
+            }
+        }
+
+        /* connections whose output is timed by ffserver; going backwards,
+           a connection leaving the table is replaced by one already run */
+        for (i = nb_timed_ctx - 1; i >= 0; i--)
+            if (i < nb_timed_ctx)
+                run_connection(timed_ctx[i]);
+
+        /* check the request timeouts */
+        if (cur_time - last_sweep >= 1000) {
+            last_sweep = cur_time;
+            for(c = first_http_ctx; c != NULL; c = c_next) {
+                c_next = c->next;
+                if (c->state == HTTPSTATE_WAIT_REQUEST ||
+                    c->state == RTSPSTATE_WAIT_REQUEST)
+                    run_connection(c);
+            }
+        }
+
+        update_loop_stats(start);
+    }
+}
+#endif
+
+static void handle_term(int sig)
+{
+    int i;
+
+    for (i = 1; i < nb_workers; i++)
+        if (worker_pids[i])
+            kill(worker_pids[i], SIGTERM);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* allocate zeroed memory which stays shared with the processes forked
+   afterwards */
+static void *alloc_shared(size_t size)
+{
+    void *ptr = MAP_FAILED;
+    int fd = open("/dev/zero", O_RDWR);
+
+    if (fd >= 0) {
+        ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (ptr == MAP_FAILED) {
+        http_log("Could not allocate shared memory: %s\n", strerror(errno));
+        return NULL;
+    }
+    return ptr;
+}
+
+/* fork the worker processes, which share the listening sockets, the
+   state of the feeds and their loads */
+static int start_workers(void)
+{
+    FFStream *feed;
+    FeedState *states;
+    int i, nb_feeds = 0;
+
+    for(feed = first_feed; feed != NULL; feed = feed->next_feed)
+        nb_feeds++;
+    if (nb_feeds) {
+        if (!(states = alloc_shared(nb_feeds * sizeof(*states))))
+            return -1;
+        for(feed = first_feed, i = 0; feed != NULL; feed = feed->next_feed, i++) {
+            feed->shared_state = &states[i];
+            store_feed_state(feed);
+        }
+    }
+    if (!(worker_loads = alloc_shared(2 * nb_workers * sizeof(*worker_loads))))
+        return -1;
+    worker_accepting = worker_loads + nb_workers;
+
+    nb_max_http_connections = (nb_max_http_connections + nb_workers - 1) / nb_workers;
+    nb_max_connections      = (nb_max_connections      + nb_workers - 1) / nb_workers;
+    max_bandwidth           = (max_bandwidth           + nb_workers - 1) / nb_workers;
+
+    worker_pids = av_mallocz(nb_workers * sizeof(*worker_pids));
+    if (!worker_pids)
+        return -1;
+    for (i = 1; i < nb_workers; i++) {
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            http_log("Could not start worker %d: %s\n", i, strerror(errno));
+            return -1;
+        } else if (pid == 0) {
+            /* feeders are launched and restarted by the main process */
+            worker_index = i;
+            no_launch = 1;
+            av_freep(&worker_pids);
+            return 0;
+        }
+        worker_pids[i] = pid;
+    }
+
+    signal(SIGTERM, handle_term);
+    signal(SIGINT, handle_term);
+    return 0;
+}
+
+/* main loop of the http server */
+static int http_server(void)
+{
+    int server_fd = 0, rtsp_server_fd = 0;
+
+    if (my_http_addr.sin_port) {
+        server_fd = socket_open_listen(&my_http_addr);
+        if (server_fd < 0)
+            return -1;
+    }
+
+    if (my_rtsp_addr.sin_port) {
+        rtsp_server_fd = socket_open_listen(&my_rtsp_addr);
+        if (rtsp_server_fd < 0)
+            return -1;
+    }
+
+    if (!rtsp_server_fd && !server_fd) {
+        http_log("HTTP and RTSP disabled.\n");
+        return -1;
+    }
+
+    /* before anything is registered in the event loop */
+    if (nb_workers > 1 && start_workers() < 0)
+        return -1;
+
+#if HAVE_SYS_EPOLL_H
+    if (use_epoll) {
+        epoll_fd = epoll_create(nb_max_http_connections + 2);
+        if (epoll_fd < 0)
+            http_log("epoll unavailable (%s), using poll()\n", strerror(errno));
+        else
+            fcntl(epoll_fd, F_SETFD, FD_CLOEXEC);
+    }
+#endif
+
+    if (!worker_index)
+        http_log("FFserver started.\n");
+
+    start_children(first_feed);
+
+    if (!worker_index)
+        start_multicast();
+
+#if HAVE_SYS_EPOLL_H
+    if (epoll_fd >= 0)
+        return epoll_loop(server_fd, rtsp_server_fd);
+#endif
+    return poll_loop(server_fd, rtsp_server_fd);
+}
+
 /* start waiting for a new HTTP/RTSP request */
 static void start_wait_request(HTTPContext *c, int is_rtsp)
 {
@@ -762,7 +1226,9 @@ static void new_connection(int server_fd, int is_rtsp)
     fd = accept(server_fd, (struct sockaddr *)&from_addr,
                 &len);
     if (fd < 0) {
-        http_log("error during accept %s\n", strerror(errno));
+        /* another worker may have taken the connection */
+        if (ff_neterrno() != FF_NETERROR(EAGAIN))
+            http_log("error during accept %s\n", strerror(errno));
         return;
     }
     ff_socket_nonblock(fd, 1);
@@ -778,7 +1244,8 @@ static void new_connection(int server_fd, int is_rtsp)
         goto fail;
 
     c->fd = fd;
-    c->poll_entry = NULL;
+    c->poll_entry = &c->poll_ev;
+    c->last_dts = AV_NOPTS_VALUE;
     c->from_addr = from_addr;
     c->buffer_size = IOBUFFER_INIT_SIZE;
     c->buffer = av_malloc(c->buffer_size);
@@ -788,8 +1255,11 @@ static void new_connection(int server_fd, int is_rtsp)
     c->next = first_http_ctx;
     first_http_ctx = c;
     nb_connections++;
+    if (worker_loads)
+        worker_loads[worker_index] = nb_connections;
 
     start_wait_request(c, is_rtsp);
+    update_poll_events(c);
 
     return;
 
@@ -825,6 +1295,9 @@ static void close_connection(HTTPContext *c)
             c1->rtsp_c = NULL;
     }
 
+    /* unregister it from the event loop */
+    set_poll_events(c, 0, 0);
+
     /* remove connection associated resources */
     if (c->fd >= 0)
         closesocket(c->fd);
@@ -835,8 +1308,11 @@ static void close_connection(HTTPContext *c)
             if (st->codec->codec)
                 avcodec_close(st->codec);
         }
-        av_close_input_file(c->fmt_in);
+        close_input_stream(c->fmt_in);
     }
+    shared_mux_detach(c);
+    if (c->relay)
+        close(c->relay_fd);
 
     /* free RTP output streams if any */
     nb_streams = 0;
@@ -878,6 +1354,7 @@ static void close_connection(HTTPContext *c)
     /* signal that there is no feed if we are the feeder socket */
     if (c->state == HTTPSTATE_RECEIVE_DATA && c->stream) {
         c->stream->feed_opened = 0;
+        store_feed_state(c->stream);
         close(c->feed_fd);
     }
 
@@ -942,7 +1419,10 @@ static int handle_connection(HTTPContext *c)
         /* no need to write if no events */
         if (!(c->poll_entry->revents & POLLOUT))
             return 0;
-        len = send(c->fd, c->buffer_ptr, c->buffer_end - c->buffer_ptr, 0);
+        /* if the stream data follows, let the kernel put the beginning
+           of it in the same segment as the header */
+        len = send(c->fd, c->buffer_ptr, c->buffer_end - c->buffer_ptr,
+                   c->http_error ? 0 : MSG_MORE);
         if (len < 0) {
             if (ff_neterrno() != FF_NETERROR(EAGAIN) &&
                 ff_neterrno() != FF_NETERROR(EINTR)) {
@@ -1462,6 +1942,7 @@ static int http_parse_request(HTTPContext *c)
     FFStream *stream;
     int i;
     char ratebuf[32];
+    int rate_switch = 0;
     char *useragent = 0;
 
     p = c->buffer;
@@ -1570,6 +2051,7 @@ static int http_parse_request(HTTPContext *c)
 
     /* If this is WMP, get the rate information */
     if (extract_rates(ratebuf, sizeof(ratebuf), c->buffer)) {
+        rate_switch = 1;
         if (modify_current_stream(c, ratebuf)) {
             for (i = 0; i < FF_ARRAY_ELEMS(c->feed_streams); i++) {
                 if (c->switch_feed_streams[i] >= 0)
@@ -1582,7 +2064,7 @@ static int http_parse_request(HTTPContext *c)
         current_bandwidth += stream->bandwidth;
 
     /* If already streaming this feed, do not let start another feeder. */
-    if (stream->feed_opened) {
+    if (c->post && stream->feed_opened) {
         snprintf(msg, sizeof(msg), "This feed is already being received.");
         http_log("Feed '%s' already being received\n", stream->feed_filename);
         goto send_error;
@@ -1779,7 +2261,8 @@ static int http_parse_request(HTTPContext *c)
                         break;
                 }
 
-                if (wmpc && modify_current_stream(wmpc, ratebuf))
+                /* a shared connection cannot switch streams */
+                if (wmpc && !wmpc->shared && modify_current_stream(wmpc, ratebuf))
                     wmpc->switch_pending = 1;
             }
 
@@ -1804,8 +2287,17 @@ static int http_parse_request(HTTPContext *c)
     if (c->stream->stream_type == STREAM_TYPE_STATUS)
         goto send_status;
 
-    /* open input stream */
-    if (open_input_stream(c, info) < 0) {
+    /* open input stream, or join the shared one if the stream has one,
+       no particular start date or buffer is requested and the client
+       does not switch rates */
+    if (c->stream->shared_mux_size && !rate_switch &&
+        !strstr(info, "date=") && !strstr(info, "buffer=")) {
+        if (shared_mux_attach(c) < 0) {
+            snprintf(msg, sizeof(msg), "Input stream corresponding to '%s' not found", url);
+            goto send_error;
+        }
+    } else if (open_input_stream(c, info) < 0 ||
+               (c->stream->feed == c->stream && open_relay(c) < 0)) {
         snprintf(msg, sizeof(msg), "Input stream corresponding to '%s' not found", url);
         goto send_error;
     }
@@ -1852,7 +2344,7 @@ static int http_parse_request(HTTPContext *c)
     c->state = HTTPSTATE_SEND_HEADER;
     return 0;
  send_status:
-    compute_status(c);
+    compute_status(c, info);
     c->http_error = 200; /* horrible : we use this value to avoid
                             going to the send data state */
     c->state = HTTPSTATE_SEND_HEADER;
@@ -1869,11 +2361,88 @@ static void fmt_bytecount(ByteIOContext *pb, int64_t count)
     url_fprintf(pb, "%"PRId64"%c", count, *s);
 }
 
-static void compute_status(HTTPContext *c)
+/* return the number of bytes waiting in the socket send queue of a
+   connection, or -1 if unknown */
+static int get_send_queue(HTTPContext *c)
+{
+#ifdef TIOCOUTQ
+    int size;
+
+    if (c->fd >= 0 && ioctl(c->fd, TIOCOUTQ, &size) == 0)
+        return size;
+#endif
+    return -1;
+}
+
+/* return by how many ms a connection lags behind the last data written
+   to its feed, or -1 if unknown */
+static int64_t get_feed_lag(HTTPContext *c)
+{
+    FFStream *feed = c->stream ? c->stream->feed : NULL;
+
+    if (!feed || !feed->feed_head_dts || c->last_dts == AV_NOPTS_VALUE)
+        return -1;
+    return FFMAX(feed->feed_head_dts - c->last_dts, 0) / 1000;
+}
+
+static void fmt_output_stats(ByteIOContext *pb, OutputStats *st)
+{
+    int i;
+
+    url_fprintf(pb, " prepare_us=%"PRId64" send_us=%"PRId64" sends=%"PRId64
+                " blocked=%"PRId64" drops=%"PRId64" backlog=",
+                st->prepare_time, st->send_time, st->nb_sends,
+                st->nb_blocked, st->drops);
+    for (i = 0; i < BACKLOG_BUCKETS; i++)
+        url_fprintf(pb, "%s%"PRId64, i ? "," : "", st->backlog[i]);
+}
+
+/* status in a format easy to parse: one line per object, made of its
+   type followed by name=value fields */
+static void compute_text_status(ByteIOContext *pb)
+{
+    HTTPContext *c1;
+    FFStream *stream;
+    int i;
+
+    url_fprintf(pb, "server connections=%d max_connections=%d bandwidth=%"PRIu64
+                " max_bandwidth=%"PRIu64" loop_latency_us=%"PRId64" loop_latency_max_us=%"PRId64
+                " worker=%d workers=%d\n",
+                nb_connections, nb_max_connections, current_bandwidth, max_bandwidth,
+                loop_latency_avg, loop_latency_max, worker_index + 1, nb_workers);
+
+    for (stream = first_stream; stream; stream = stream->next) {
+        if (stream->stream_type != STREAM_TYPE_LIVE)
+            continue;
+        url_fprintf(pb, "stream name=%s feed=%d conns_served=%d bytes=%"PRId64,
+                    stream->filename, stream->feed == stream,
+                    stream->conns_served, stream->bytes_served);
+        if (stream->feed == stream)
+            url_fprintf(pb, " receiving=%d head_dts=%"PRId64,
+                        stream->feed_opened, stream->feed_head_dts);
+        fmt_output_stats(pb, &stream->stats);
+        url_fprintf(pb, "\n");
+    }
+
+    for (c1 = first_http_ctx, i = 1; c1; c1 = c1->next, i++) {
+        url_fprintf(pb, "connection id=%d stream=%s ip=%s proto=%s state=%s"
+                    " bitrate=%d bytes=%"PRId64" queued=%d lag_ms=%"PRId64,
+                    i, c1->stream ? c1->stream->filename : "-",
+                    inet_ntoa(c1->from_addr.sin_addr), c1->protocol,
+                    http_state[c1->state],
+                    compute_datarate(&c1->datarate, c1->data_count) * 8,
+                    c1->data_count, get_send_queue(c1), get_feed_lag(c1));
+        fmt_output_stats(pb, &c1->stats);
+        url_fprintf(pb, "\n");
+    }
+}
+
+static void compute_status(HTTPContext *c, const char *info)
 {
     HTTPContext *c1;
     FFStream *stream;
     char *p;
+    char buf[32];
     time_t ti;
     int i, len;
     ByteIOContext *pb;
@@ -1885,6 +2454,15 @@ static void compute_status(HTTPContext *c)
         return;
     }
 
+    if (find_info_tag(buf, sizeof(buf), "format", info) && !strcmp(buf, "text")) {
+        url_fprintf(pb, "HTTP/1.0 200 OK\r\n");
+        url_fprintf(pb, "Content-type: %s\r\n", "text/plain");
+        url_fprintf(pb, "Pragma: no-cache\r\n");
+        url_fprintf(pb, "\r\n");
+        compute_text_status(pb);
+        goto done;
+    }
+
     url_fprintf(pb, "HTTP/1.0 200 OK\r\n");
     url_fprintf(pb, "Content-type: %s\r\n", "text/html");
     url_fprintf(pb, "Pragma: no-cache\r\n");
@@ -1988,6 +2566,28 @@ static void compute_status(HTTPContext *c)
     }
     url_fprintf(pb, "</table>\n");
 
+    url_fprintf(pb, "<h2>Output Statistics</h2>\n");
+    url_fprintf(pb, "<table cellspacing=0 cellpadding=4>\n");
+    url_fprintf(pb, "<tr><th valign=top>Path<th>Prepare<br>ms<th>Send<br>ms<th>Send<br>calls<th valign=top>Blocked<th>Dropped<br>packets"
+                "<th colspan=%d>Bytes left after a send call<br>0 / &lt;1k / &lt;4k / &lt;16k / &lt;64k / more\n", BACKLOG_BUCKETS);
+    for (stream = first_stream; stream; stream = stream->next) {
+        OutputStats *st = &stream->stats;
+        if (stream->stream_type != STREAM_TYPE_LIVE)
+            continue;
+        url_fprintf(pb, "<tr><td>%s<td align=right>%"PRId64"<td align=right>%"PRId64"<td align=right>",
+                    stream->filename, st->prepare_time / 1000, st->send_time / 1000);
+        fmt_bytecount(pb, st->nb_sends);
+        url_fprintf(pb, "<td align=right>");
+        fmt_bytecount(pb, st->nb_blocked);
+        url_fprintf(pb, "<td align=right>%"PRId64, st->drops);
+        for (i = 0; i < BACKLOG_BUCKETS; i++) {
+            url_fprintf(pb, "<td align=right>");
+            fmt_bytecount(pb, st->backlog[i]);
+        }
+        url_fprintf(pb, "\n");
+    }
+    url_fprintf(pb, "</table>\n");
+
     stream = first_stream;
     while (stream != NULL) {
         if (stream->feed == stream) {
@@ -2063,13 +2663,31 @@ static void compute_status(HTTPContext *c)
     url_fprintf(pb, "Bandwidth in use: %"PRIu64"k / %"PRIu64"k<br>\n",
                  current_bandwidth, max_bandwidth);
 
+    url_fprintf(pb, "Event loop: %s, %"PRId64" iterations, latency %0.3f ms average, %0.3f ms max<br>\n",
+                 epoll_fd >= 0 ? "epoll" : "poll", loop_count,
+                 loop_latency_avg / 1000.0, loop_latency_max / 1000.0);
+
+    if (nb_workers > 1)
+        url_fprintf(pb, "Worker %d of %d (pid %d), only its connections are listed<br>\n",
+                     worker_index + 1, nb_workers, (int)getpid());
+
+    for (stream = first_stream; stream; stream = stream->next) {
+        SharedMux *sm = stream->shared_mux;
+        if (sm)
+            url_fprintf(pb, "Shared muxing of %s: %d connections, %d / %d packets buffered, %"PRId64" packets skipped<br>\n",
+                         stream->filename, sm->nb_clients,
+                         (int)FFMIN(sm->head, sm->ring_size), sm->ring_size, sm->drops);
+    }
+
     url_fprintf(pb, "<table>\n");
-    url_fprintf(pb, "<tr><th>#<th>File<th>IP<th>Proto<th>State<th>Target bits/sec<th>Actual bits/sec<th>Bytes transferred\n");
+    url_fprintf(pb, "<tr><th>#<th>File<th>IP<th>Proto<th>State<th>Target bits/sec<th>Actual bits/sec<th>Bytes transferred"
+                "<th>Bytes queued<th>Feed lag ms<th>Prepare ms<th>Send ms<th>Blocked sends<th>Dropped packets\n");
     c1 = first_http_ctx;
     i = 0;
     while (c1 != NULL) {
         int bitrate;
         int j;
+        int64_t lag;
 
         bitrate = 0;
         if (c1->stream) {
@@ -2095,7 +2713,15 @@ static void compute_status(HTTPContext *c)
         fmt_bytecount(pb, compute_datarate(&c1->datarate, c1->data_count) * 8);
         url_fprintf(pb, "<td align=right>");
         fmt_bytecount(pb, c1->data_count);
-        url_fprintf(pb, "\n");
+        url_fprintf(pb, "<td align=right>");
+        if ((len = get_send_queue(c1)) >= 0)
+            fmt_bytecount(pb, len);
+        url_fprintf(pb, "<td align=right>");
+        if ((lag = get_feed_lag(c1)) >= 0)
+            url_fprintf(pb, "%"PRId64, lag);
+        url_fprintf(pb, "<td align=right>%"PRId64"<td align=right>%"PRId64"<td align=right>%"PRId64"<td align=right>%"PRId64"\n",
+                    c1->stats.prepare_time / 1000, c1->stats.send_time / 1000,
+                    c1->stats.nb_blocked, c1->stats.drops);
         c1 = c1->next;
     }
     url_fprintf(pb, "</table>\n");
@@ -2106,6 +2732,7 @@ static void compute_status(HTTPContext *c)
     url_fprintf(pb, "<hr size=1 noshade>Generated at %s", p);
     url_fprintf(pb, "</body>\n</html>\n");
 
+ done:
     len = url_close_dyn_buf(pb, &c->pb_buffer);
     c->buffer_ptr = c->pb_buffer;
     c->buffer_end = c->pb_buffer + len;
@@ -2127,6 +2754,59 @@ static void open_parser(AVFormatContext *s, int i)
     }
 }
 
+static int64_t mapped_feed_seek(void *opaque, int64_t offset, int whence)
+{
+    FFStream *feed = opaque;
+
+    if (whence == AVSEEK_SIZE)
+        return feed->feed_size;
+    /* everything is in the buffer, nothing else can be reached */
+    return AVERROR(EINVAL);
+}
+
+/* open a mapped feed for reading: the buffer of the ByteIOContext is
+   the mapping itself, so that reading and seeking never make a system
+   call and the demuxer can use the pages in place */
+static int open_mapped_feed(AVFormatContext **ps, FFStream *stream)
+{
+    FFStream *feed = stream->feed;
+    ByteIOContext *pb;
+    int ret;
+
+    pb = av_alloc_put_byte(feed->map, feed->feed_size, 0, feed,
+                           NULL, NULL, mapped_feed_seek);
+    if (!pb)
+        return AVERROR(ENOMEM);
+    ret = av_open_input_stream(ps, pb, feed->feed_filename,
+                               av_find_input_format("ffm"), stream->ap_in);
+    if (ret < 0)
+        av_free(pb);
+    return ret;
+}
+
+/* make the pages written since the last call readable */
+static void update_mapped_feed(AVFormatContext *s, FFStream *feed)
+{
+    ByteIOContext *pb = s->pb;
+
+    if (pb->seek != mapped_feed_seek)
+        return;
+    pb->buf_end = pb->buffer + feed->feed_size;
+    pb->pos = feed->feed_size;
+    pb->eof_reached = 0;
+}
+
+static void close_input_stream(AVFormatContext *s)
+{
+    ByteIOContext *pb = s->pb;
+
+    if (pb && pb->seek == mapped_feed_seek) {
+        av_close_input_stream(s);
+        av_free(pb);
+    } else
+        av_close_input_file(s);
+}
+
 static int open_input_stream(HTTPContext *c, const char *info)
 {
     char buf[128];
@@ -2164,8 +2844,12 @@ static int open_input_stream(HTTPContext *c, const char *info)
         return -1;
 
     /* open stream */
-    if ((ret = av_open_input_file(&s, input_filename, c->stream->ifmt,
-                                  buf_size, c->stream->ap_in)) < 0) {
+    if (c->stream->feed && c->stream->feed->map)
+        ret = open_mapped_feed(&s, c->stream);
+    else
+        ret = av_open_input_file(&s, input_filename, c->stream->ifmt,
+                                 buf_size, c->stream->ap_in);
+    if (ret < 0) {
         http_log("could not open %s: %d\n", input_filename, ret);
         return -1;
     }
@@ -2198,6 +2882,423 @@ static int open_input_stream(HTTPContext *c, const char *info)
     /* set the start time (needed for maxtime and RTP packet timing) */
     c->start_time = cur_time;
     c->first_pts = AV_NOPTS_VALUE;
+    c->last_dts = AV_NOPTS_VALUE;
+    return 0;
+}
+
+static void update_prepare_stats(HTTPContext *c, int64_t start)
+{
+    int64_t t = av_gettime() - start;
+
+    c->stats.prepare_time += t;
+    if (c->stream)
+        c->stream->stats.prepare_time += t;
+}
+
+/* account a send call which started at time start and sent len bytes
+   out of size */
+static void update_send_stats(HTTPContext *c, int64_t start, int len, int size)
+{
+    static const int backlog_limits[BACKLOG_BUCKETS - 1] = {
+        1, 1024, 4096, 16384, 65536
+    };
+    OutputStats *st[2] = { &c->stats, c->stream ? &c->stream->stats : NULL };
+    int64_t t = av_gettime() - start;
+    int i, j, left = size - FFMAX(len, 0);
+
+    for (i = 0; i < BACKLOG_BUCKETS - 1 && left >= backlog_limits[i]; i++);
+    for (j = 0; j < 2 && st[j]; j++) {
+        st[j]->send_time += t;
+        st[j]->nb_sends++;
+        if (left)
+            st[j]->nb_blocked++;
+        st[j]->backlog[i]++;
+    }
+}
+
+/* a feed is sent as it is stored: instead of demuxing and remuxing it,
+   send the pages of the feed file following the position the demuxer
+   was seeked to */
+static int open_relay(HTTPContext *c)
+{
+    AVFormatContext *s = c->fmt_in;
+    int64_t pos;
+    int i;
+
+    pos = url_ftell(s->pb);
+    pos = FFMAX(pos - pos % FFM_PACKET_SIZE, FFM_PACKET_SIZE);
+
+    c->relay_fd = open(c->stream->feed_filename, O_RDONLY);
+    if (c->relay_fd < 0) {
+        http_log("Could not open feed file '%s': %s\n",
+                 c->stream->feed_filename, strerror(errno));
+        return -1;
+    }
+    c->relay = 1;
+    c->relay_pos = pos;
+
+    for(i=0;i<s->nb_streams;i++) {
+        if (s->streams[i]->codec->codec)
+            avcodec_close(s->streams[i]->codec);
+    }
+    close_input_stream(s);
+    c->fmt_in = NULL;
+    return 0;
+}
+
+/* return the number of bytes which can be relayed from relay_pos without
+   wrapping around the feed file. If there are none, the state is changed
+   and 0 is returned */
+static int64_t relay_available(HTTPContext *c)
+{
+    FFStream *feed = c->stream;
+
+    if (c->relay_pos >= feed->feed_size &&
+        c->relay_pos > feed->feed_write_index)
+        c->relay_pos = FFM_PACKET_SIZE;
+    if (c->relay_pos == feed->feed_write_index) {
+        c->state = feed->feed_opened ? HTTPSTATE_WAIT_FEED :
+                                       HTTPSTATE_SEND_DATA_TRAILER;
+        return 0;
+    }
+    if (c->relay_pos < feed->feed_write_index)
+        return feed->feed_write_index - c->relay_pos;
+    return feed->feed_size - c->relay_pos;
+}
+
+#if HAVE_SENDFILE
+/* send the available feed pages without copying them to user space */
+static int relay_send_file(HTTPContext *c)
+{
+    off_t pos;
+    int64_t size, start;
+    ssize_t len;
+
+    size = relay_available(c);
+    if (!size)
+        return 0;
+    pos = c->relay_pos;
+    start = av_gettime();
+    len = sendfile(c->fd, c->relay_fd, &pos, FFMIN(size, INT_MAX));
+    update_send_stats(c, start, len, FFMIN(size, INT_MAX));
+    if (len < 0) {
+        if (ff_neterrno() != FF_NETERROR(EAGAIN) &&
+            ff_neterrno() != FF_NETERROR(EINTR))
+            /* error : close connection */
+            return -1;
+        return 0;
+    } else if (len == 0) {
+        /* the feed file is shorter than expected */
+        return -1;
+    }
+    c->relay_pos += len;
+    c->data_count += len;
+    update_datarate(&c->datarate, c->data_count);
+    c->stream->bytes_served += len;
+    return 0;
+}
+#endif
+
+static void mux_buffer_unref(MuxBuffer *buf)
+{
+    if (buf && --buf->refcount == 0)
+        av_free(buf);
+}
+
+static void shared_mux_free(SharedMux *sm)
+{
+    AVFormatContext *ctx = &sm->fmt_ctx;
+    uint8_t *data;
+    int i;
+
+    if (sm->ring) {
+        for(i=0;i<sm->ring_size;i++)
+            mux_buffer_unref(sm->ring[i]);
+        av_free(sm->ring);
+    }
+    if (sm->fmt_in) {
+        for(i=0;i<sm->fmt_in->nb_streams;i++) {
+            AVStream *st = sm->fmt_in->streams[i];
+            if (st->codec->codec)
+                avcodec_close(st->codec);
+        }
+        close_input_stream(sm->fmt_in);
+    }
+    /* the trailer is not sent to anybody, but frees the muxer data */
+    if (sm->header_written && url_open_dyn_buf(&ctx->pb) >= 0) {
+        av_write_trailer(ctx);
+        url_close_dyn_buf(ctx->pb, &data);
+        av_free(data);
+    }
+    av_metadata_free(&ctx->metadata);
+    for(i=0;i<ctx->nb_streams;i++)
+        av_free(ctx->streams[i]);
+    av_free(sm->header);
+    av_free(sm);
+}
+
+static SharedMux *shared_mux_open(FFStream *stream)
+{
+    SharedMux *sm;
+    AVFormatContext *s, *ctx;
+    int i, ret;
+
+    sm = av_mallocz(sizeof(SharedMux));
+    if (!sm)
+        return NULL;
+    sm->stream = stream;
+    sm->last_key = -1;
+    sm->ring_size = stream->shared_mux_size;
+    sm->ring = av_mallocz(sm->ring_size * sizeof(*sm->ring));
+    if (!sm->ring)
+        goto fail;
+
+    /* open the feed */
+    if (stream->feed->map)
+        ret = open_mapped_feed(&s, stream);
+    else
+        ret = av_open_input_file(&s, stream->feed->feed_filename, stream->ifmt,
+                                 FFM_PACKET_SIZE, stream->ap_in);
+    if (ret < 0) {
+        http_log("could not open %s: %d\n", stream->feed->feed_filename, ret);
+        goto fail;
+    }
+    s->flags |= AVFMT_FLAG_GENPTS;
+    sm->fmt_in = s;
+    for(i=0;i<s->nb_streams;i++)
+        open_parser(s, i);
+    if (s->iformat->read_seek)
+        av_seek_frame(s, -1, av_gettime() - stream->prebuffer * (int64_t)1000, 0);
+
+    /* prepare the output context, as for a single connection */
+    ctx = &sm->fmt_ctx;
+    av_metadata_set2(&ctx->metadata, "author"   , stream->author   , 0);
+    av_metadata_set2(&ctx->metadata, "comment"  , stream->comment  , 0);
+    av_metadata_set2(&ctx->metadata, "copyright", stream->copyright, 0);
+    av_metadata_set2(&ctx->metadata, "title"    , stream->title    , 0);
+
+    for(i=0;i<stream->nb_streams;i++) {
+        AVStream *st = av_mallocz(sizeof(AVStream));
+        if (!st)
+            goto fail;
+        ctx->streams[i] = st;
+        ctx->nb_streams = i + 1;
+        *st = *stream->feed->streams[stream->feed_streams[i]];
+        st->priv_data = 0;
+        st->codec->frame_number = 0;
+    }
+    ctx->oformat = stream->fmt;
+
+    if (url_open_dyn_buf(&ctx->pb) < 0)
+        goto fail;
+    ctx->pb->is_streamed = 1;
+    ctx->preload   = (int)(0.5*AV_TIME_BASE);
+    ctx->max_delay = (int)(0.7*AV_TIME_BASE);
+
+    av_set_parameters(ctx, NULL);
+    ret = av_write_header(ctx);
+    sm->header_size = url_close_dyn_buf(ctx->pb, &sm->header);
+    if (ret < 0) {
+        http_log("Error writing output header\n");
+        goto fail;
+    }
+    sm->header_written = 1;
+    return sm;
+ fail:
+    shared_mux_free(sm);
+    return NULL;
+}
+
+/* mux the next packet of the feed into the ring. Return 0 if OK, 1 if
+   the feed has no data yet and -1 at the end of the stream. */
+static int shared_mux_read(SharedMux *sm)
+{
+    FFStream *stream = sm->stream;
+    AVFormatContext *ctx = &sm->fmt_ctx;
+    AVStream *ist, *ost;
+    AVPacket pkt;
+    MuxBuffer *buf;
+    uint8_t *data;
+    int64_t dts;
+    int i, len, ret;
+
+    update_mapped_feed(sm->fmt_in, stream->feed);
+    ffm_set_write_index(sm->fmt_in,
+                        stream->feed->feed_write_index,
+                        stream->feed->feed_size);
+    for(;;) {
+        if (av_read_frame(sm->fmt_in, &pkt) < 0)
+            return stream->feed->feed_opened ? 1 : -1;
+
+        for(i=0;i<stream->nb_streams;i++) {
+            if (stream->feed_streams[i] == pkt.stream_index)
+                break;
+        }
+        if (i == stream->nb_streams) {
+            av_free_packet(&pkt);
+            continue;
+        }
+        ist = sm->fmt_in->streams[pkt.stream_index];
+        ost = ctx->streams[i];
+        if (pkt.flags & AV_PKT_FLAG_KEY &&
+            (ist->codec->codec_type == AVMEDIA_TYPE_VIDEO ||
+             stream->nb_streams == 1)) {
+            sm->got_key_frame = 1;
+            sm->pending_key = 1;
+        }
+        if (stream->send_on_key && !sm->got_key_frame) {
+            av_free_packet(&pkt);
+            continue;
+        }
+
+        if (url_open_dyn_buf(&ctx->pb) < 0) {
+            av_free_packet(&pkt);
+            return -1;
+        }
+        ctx->pb->is_streamed = 1;
+        pkt.stream_index = i;
+        dts = AV_NOPTS_VALUE;
+        if (pkt.dts != AV_NOPTS_VALUE) {
+            dts = av_rescale_q(pkt.dts, ist->time_base, AV_TIME_BASE_Q);
+            pkt.dts = av_rescale_q(pkt.dts, ist->time_base, ost->time_base);
+        }
+        if (pkt.pts != AV_NOPTS_VALUE)
+            pkt.pts = av_rescale_q(pkt.pts, ist->time_base, ost->time_base);
+        pkt.duration = av_rescale_q(pkt.duration, ist->time_base, ost->time_base);
+        ret = av_write_frame(ctx, &pkt);
+        av_free_packet(&pkt);
+        len = url_close_dyn_buf(ctx->pb, &data);
+        ost->codec->frame_number++;
+        if (ret < 0) {
+            http_log("Error writing frame to output\n");
+            av_free(data);
+            return -1;
+        }
+        if (len == 0) {
+            av_free(data);
+            continue;
+        }
+
+        buf = av_malloc(sizeof(MuxBuffer) + len);
+        if (!buf) {
+            av_free(data);
+            return -1;
+        }
+        buf->refcount = 1;
+        buf->size = len;
+        buf->key = sm->pending_key;
+        buf->dts = dts;
+        memcpy(buf->data, data, len);
+        av_free(data);
+        sm->pending_key = 0;
+
+        /* the oldest packet leaves the ring, connections still sending it
+           keep their reference */
+        mux_buffer_unref(sm->ring[sm->head % sm->ring_size]);
+        sm->ring[sm->head % sm->ring_size] = buf;
+        if (buf->key)
+            sm->last_key = sm->head;
+        sm->head++;
+        return 0;
+    }
+}
+
+static int shared_mux_attach(HTTPContext *c)
+{
+    SharedMux *sm = c->stream->shared_mux;
+
+    if (!sm) {
+        sm = shared_mux_open(c->stream);
+        if (!sm)
+            return -1;
+        c->stream->shared_mux = sm;
+    }
+    sm->nb_clients++;
+    c->shared = sm;
+    /* start at the last key frame still in the ring, if any */
+    if (sm->last_key >= 0 && sm->last_key >= sm->head - sm->ring_size)
+        c->shared_seq = sm->last_key;
+    else
+        c->shared_seq = sm->head;
+    c->start_time = cur_time;
+    c->first_pts = AV_NOPTS_VALUE;
+    c->last_dts = AV_NOPTS_VALUE;
+    return 0;
+}
+
+static void shared_mux_detach(HTTPContext *c)
+{
+    SharedMux *sm = c->shared;
+
+    if (!sm)
+        return;
+    mux_buffer_unref(c->shared_buf);
+    c->shared_buf = NULL;
+    c->shared = NULL;
+    if (--sm->nb_clients == 0) {
+        sm->stream->shared_mux = NULL;
+        shared_mux_free(sm);
+    }
+}
+
+/* make the next packet of the ring the output buffer of the connection */
+static int shared_mux_prepare_data(HTTPContext *c)
+{
+    SharedMux *sm = c->shared;
+    MuxBuffer *buf;
+    int64_t oldest, seq;
+    int ret;
+
+    mux_buffer_unref(c->shared_buf);
+    c->shared_buf = NULL;
+
+    if (c->stream->max_time &&
+        c->stream->max_time + c->start_time - cur_time < 0) {
+        /* We have timed out */
+        c->state = HTTPSTATE_SEND_DATA_TRAILER;
+        return 0;
+    }
+
+    for(;;) {
+        oldest = FFMAX(sm->head - sm->ring_size, 0);
+        if (c->shared_seq < oldest) {
+            /* the connection is too slow: skip to the first key frame
+               still in the ring */
+            for (seq = oldest; seq < sm->head; seq++)
+                if (sm->ring[seq % sm->ring_size]->key)
+                    break;
+            if (seq == sm->head)
+                seq = oldest;
+            sm->drops += seq - c->shared_seq;
+            c->stats.drops += seq - c->shared_seq;
+            c->stream->stats.drops += seq - c->shared_seq;
+            c->shared_seq = seq;
+        }
+        if (c->shared_seq == sm->head) {
+            ret = shared_mux_read(sm);
+            if (ret > 0) {
+                /* wait for more data from the feed */
+                c->state = HTTPSTATE_WAIT_FEED;
+                return 1; /* state changed */
+            } else if (ret < 0) {
+                c->state = HTTPSTATE_SEND_DATA_TRAILER;
+                return 0;
+            }
+            continue;
+        }
+        buf = sm->ring[c->shared_seq++ % sm->ring_size];
+        if (c->stream->send_on_key && !c->got_key_frame && !buf->key)
+            continue;
+        break;
+    }
+    if (buf->key)
+        c->got_key_frame = 1;
+    if (buf->dts != AV_NOPTS_VALUE)
+        c->last_dts = buf->dts;
+    buf->refcount++;
+    c->shared_buf = buf;
+    c->buffer_ptr = buf->data;
+    c->buffer_end = buf->data + buf->size;
     return 0;
 }
 
@@ -2233,6 +3334,25 @@ static int http_prepare_data(HTTPContext *c)
     av_freep(&c->pb_buffer);
     switch(c->state) {
     case HTTPSTATE_SEND_DATA_HEADER:
+        if (c->shared) {
+            /* the header was written when the shared muxer was opened */
+            c->buffer_ptr = c->shared->header;
+            c->buffer_end = c->shared->header + c->shared->header_size;
+            c->state = HTTPSTATE_SEND_DATA;
+            c->last_packet_sent = 0;
+            break;
+        }
+        if (c->relay) {
+            /* the feed header, with a null write index since the client
+               reads it as a stream and not as a circular file */
+            if (pread(c->relay_fd, c->buffer, FFM_PACKET_SIZE, 0) != FFM_PACKET_SIZE)
+                return -1;
+            AV_WB64(c->buffer + 8, 0);
+            c->buffer_ptr = c->buffer;
+            c->buffer_end = c->buffer + FFM_PACKET_SIZE;
+            c->state = HTTPSTATE_SEND_DATA;
+            break;
+        }
         memset(&c->fmt_ctx, 0, sizeof(c->fmt_ctx));
         av_metadata_set2(&c->fmt_ctx.metadata, "author"   , c->stream->author   , 0);
         av_metadata_set2(&c->fmt_ctx.metadata, "comment"  , c->stream->comment  , 0);
@@ -2292,12 +3412,30 @@ static int http_prepare_data(HTTPContext *c)
         c->last_packet_sent = 0;
         break;
     case HTTPSTATE_SEND_DATA:
+        if (c->shared)
+            return shared_mux_prepare_data(c);
+        if (c->relay) {
+            /* used only if the pages cannot be sent with sendfile() */
+            int64_t size = relay_available(c);
+            if (!size)
+                return 1;
+            len = pread(c->relay_fd, c->buffer,
+                        FFMIN(size, c->buffer_size), c->relay_pos);
+            if (len <= 0)
+                return -1;
+            c->relay_pos += len;
+            c->buffer_ptr = c->buffer;
+            c->buffer_end = c->buffer + len;
+            break;
+        }
         /* find a new packet */
         /* read a packet from the input stream */
-        if (c->stream->feed)
+        if (c->stream->feed) {
+            update_mapped_feed(c->fmt_in, c->stream->feed);
             ffm_set_write_index(c->fmt_in,
                                 c->stream->feed->feed_write_index,
                                 c->stream->feed->feed_size);
+        }
 
         if (c->stream->max_time &&
             c->stream->max_time + c->start_time - cur_time < 0)
@@ -2327,6 +3465,8 @@ static int http_prepare_data(HTTPContext *c)
                 }
             } else {
                 int source_index = pkt.stream_index;
+                if (pkt.dts != AV_NOPTS_VALUE)
+                    c->last_dts = av_rescale_q(pkt.dts, c->fmt_in->streams[pkt.stream_index]->time_base, AV_TIME_BASE_Q);
                 /* update first pts if needed */
                 if (c->first_pts == AV_NOPTS_VALUE) {
                     c->first_pts = av_rescale_q(pkt.dts, c->fmt_in->streams[pkt.stream_index]->time_base, AV_TIME_BASE_Q);
@@ -2431,8 +3571,9 @@ static int http_prepare_data(HTTPContext *c)
         break;
     default:
     case HTTPSTATE_SEND_DATA_TRAILER:
-        /* last packet test ? */
-        if (c->last_packet_sent || c->is_packetized)
+        /* last packet test ? the trailer of a shared stream is never sent,
+           a relayed feed has no muxer to write one */
+        if (c->last_packet_sent || c->is_packetized || c->shared || c->relay)
             return -1;
         ctx = &c->fmt_ctx;
         /* prepare header */
@@ -2455,21 +3596,84 @@ static int http_prepare_data(HTTPContext *c)
 /* should convert the format at the same time */
 /* send data starting at c->buffer_ptr to the output connection
    (either UDP or TCP connection) */
+#define RTP_BATCH_SIZE 64
+
+/* send with a single call all the RTP packets of the output buffer
+   whose send time has come. Return 1 if the connection must wait before
+   sending the next packet. */
+static int rtp_send_udp_packets(HTTPContext *c)
+{
+    uint8_t *bufs[RTP_BATCH_SIZE];
+    int sizes[RTP_BATCH_SIZE];
+    int n = 0, len, total = 0, ret, wait = 0;
+    int64_t start;
+
+    while (n < RTP_BATCH_SIZE) {
+        len = c->buffer_end - c->buffer_ptr;
+        if (len == 0)
+            break;
+        if (len < 4 || AV_RB32(c->buffer_ptr) > len - 4) {
+            /* fail safe - should never happen */
+            c->buffer_ptr = c->buffer_end;
+            break;
+        }
+        len = AV_RB32(c->buffer_ptr);
+        if ((get_packet_send_clock(c) - get_server_clock(c)) > 0) {
+            wait = 1;
+            break;
+        }
+        c->data_count += len;
+        update_datarate(&c->datarate, c->data_count);
+        if (c->stream)
+            c->stream->bytes_served += len;
+        bufs[n] = c->buffer_ptr + 4;
+        sizes[n++] = len;
+        total += len;
+        c->buffer_ptr += 4 + len;
+    }
+
+    if (n) {
+        start = av_gettime();
+        ret = rtp_write_packets(c->rtp_handles[c->packet_stream_index],
+                                bufs, sizes, n);
+        update_send_stats(c, start, ret < 0 ? ret : total, total);
+    }
+    return wait;
+}
+
 static int http_send_data(HTTPContext *c)
 {
     int len, ret;
+    int64_t start;
 
     for(;;) {
         if (c->buffer_ptr >= c->buffer_end) {
+#if HAVE_SENDFILE
+            if (c->relay && c->state == HTTPSTATE_SEND_DATA)
+                return relay_send_file(c);
+#endif
+            start = av_gettime();
             ret = http_prepare_data(c);
+            update_prepare_stats(c, start);
             if (ret < 0)
                 return -1;
             else if (ret != 0)
                 /* state change requested */
                 break;
         } else {
-            if (c->is_packetized) {
-                /* RTP data output */
+            if (c->is_packetized &&
+                c->rtp_protocol != RTSP_LOWER_TRANSPORT_TCP) {
+                /* RTP data output in UDP */
+                if (rtp_send_udp_packets(c))
+                    /* nothing more to send yet: we can wait */
+                    return 0;
+            } else if (c->is_packetized) {
+                /* RTP packets are sent inside the RTSP TCP connection */
+                ByteIOContext *pb;
+                int interleaved_index, size;
+                uint8_t header[4];
+                HTTPContext *rtsp_c;
+
                 len = c->buffer_end - c->buffer_ptr;
                 if (len < 4) {
                     /* fail safe - should never happen */
@@ -2493,66 +3697,56 @@ static int http_send_data(HTTPContext *c)
                 if (c->stream)
                     c->stream->bytes_served += len;
 
-                if (c->rtp_protocol == RTSP_LOWER_TRANSPORT_TCP) {
-                    /* RTP packets are sent inside the RTSP TCP connection */
-                    ByteIOContext *pb;
-                    int interleaved_index, size;
-                    uint8_t header[4];
-                    HTTPContext *rtsp_c;
-
-                    rtsp_c = c->rtsp_c;
-                    /* if no RTSP connection left, error */
-                    if (!rtsp_c)
-                        return -1;
-                    /* if already sending something, then wait. */
-                    if (rtsp_c->state != RTSPSTATE_WAIT_REQUEST)
-                        break;
-                    if (url_open_dyn_buf(&pb) < 0)
-                        goto fail1;
-                    interleaved_index = c->packet_stream_index * 2;
-                    /* RTCP packets are sent at odd indexes */
-                    if (c->buffer_ptr[1] == 200)
-                        interleaved_index++;
-                    /* write RTSP TCP header */
-                    header[0] = '$';
-                    header[1] = interleaved_index;
-                    header[2] = len >> 8;
-                    header[3] = len;
-                    put_buffer(pb, header, 4);
-                    /* write RTP packet data */
-                    c->buffer_ptr += 4;
-                    put_buffer(pb, c->buffer_ptr, len);
-                    size = url_close_dyn_buf(pb, &c->packet_buffer);
-                    /* prepare asynchronous TCP sending */
-                    rtsp_c->packet_buffer_ptr = c->packet_buffer;
-                    rtsp_c->packet_buffer_end = c->packet_buffer + size;
-                    c->buffer_ptr += len;
-
-                    /* send everything we can NOW */
-                    len = send(rtsp_c->fd, rtsp_c->packet_buffer_ptr,
-                                rtsp_c->packet_buffer_end - rtsp_c->packet_buffer_ptr, 0);
-                    if (len > 0)
-                        rtsp_c->packet_buffer_ptr += len;
-                    if (rtsp_c->packet_buffer_ptr < rtsp_c->packet_buffer_end) {
-                        /* if we could not send all the data, we will
-                           send it later, so a new state is needed to
-                           "lock" the RTSP TCP connection */
-                        rtsp_c->state = RTSPSTATE_SEND_PACKET;
-                        break;
-                    } else
-                        /* all data has been sent */
-                        av_freep(&c->packet_buffer);
-                } else {
-                    /* send RTP packet directly in UDP */
-                    c->buffer_ptr += 4;
-                    url_write(c->rtp_handles[c->packet_stream_index],
-                              c->buffer_ptr, len);
-                    c->buffer_ptr += len;
-                    /* here we continue as we can send several packets per 10 ms slot */
-                }
+                rtsp_c = c->rtsp_c;
+                /* if no RTSP connection left, error */
+                if (!rtsp_c)
+                    return -1;
+                /* if already sending something, then wait. */
+                if (rtsp_c->state != RTSPSTATE_WAIT_REQUEST)
+                    break;
+                if (url_open_dyn_buf(&pb) < 0)
+                    goto fail1;
+                interleaved_index = c->packet_stream_index * 2;
+                /* RTCP packets are sent at odd indexes */
+                if (c->buffer_ptr[1] == 200)
+                    interleaved_index++;
+                /* write RTSP TCP header */
+                header[0] = '$';
+                header[1] = interleaved_index;
+                header[2] = len >> 8;
+                header[3] = len;
+                put_buffer(pb, header, 4);
+                /* write RTP packet data */
+                c->buffer_ptr += 4;
+                put_buffer(pb, c->buffer_ptr, len);
+                size = url_close_dyn_buf(pb, &c->packet_buffer);
+                /* prepare asynchronous TCP sending */
+                rtsp_c->packet_buffer_ptr = c->packet_buffer;
+                rtsp_c->packet_buffer_end = c->packet_buffer + size;
+                c->buffer_ptr += len;
+
+                /* send everything we can NOW */
+                start = av_gettime();
+                len = send(rtsp_c->fd, rtsp_c->packet_buffer_ptr,
+                            rtsp_c->packet_buffer_end - rtsp_c->packet_buffer_ptr, 0);
+                update_send_stats(c, start, len, size);
+                if (len > 0)
+                    rtsp_c->packet_buffer_ptr += len;
+                if (rtsp_c->packet_buffer_ptr < rtsp_c->packet_buffer_end) {
+                    /* if we could not send all the data, we will
+                       send it later, so a new state is needed to
+                       "lock" the RTSP TCP connection */
+                    rtsp_c->state = RTSPSTATE_SEND_PACKET;
+                    update_poll_events(rtsp_c);
+                    break;
+                } else
+                    /* all data has been sent */
+                    av_freep(&c->packet_buffer);
             } else {
                 /* TCP data output */
+                start = av_gettime();
                 len = send(c->fd, c->buffer_ptr, c->buffer_end - c->buffer_ptr, 0);
+                update_send_stats(c, start, len, c->buffer_end - c->buffer_ptr);
                 if (len < 0) {
                     if (ff_neterrno() != FF_NETERROR(EAGAIN) &&
                         ff_neterrno() != FF_NETERROR(EINTR))
@@ -2594,9 +3788,13 @@ static int http_start_receive_data(HTTPContext *c)
     c->feed_fd = fd;
 
     if (c->stream->truncate) {
-        /* truncate feed file */
+        /* truncate feed file. A mapped feed keeps its size: other
+           workers and readers may still access the mapping up to the
+           old size, and pages past the end of the file would fault, so
+           only the write index is reset as if the ring wrapped around */
         ffm_write_write_index(c->feed_fd, FFM_PACKET_SIZE);
-        ftruncate(c->feed_fd, FFM_PACKET_SIZE);
+        if (!c->stream->map)
+            ftruncate(c->feed_fd, FFM_PACKET_SIZE);
         http_log("Truncating feed file '%s'\n", c->stream->feed_filename);
     } else {
         if ((c->stream->feed_write_index = ffm_read_write_index(fd)) < 0) {
@@ -2613,6 +3811,7 @@ static int http_start_receive_data(HTTPContext *c)
     c->buffer_ptr = c->buffer;
     c->buffer_end = c->buffer + FFM_PACKET_SIZE;
     c->stream->feed_opened = 1;
+    store_feed_state(c->stream);
     c->chunked_encoding = !!av_stristr(c->buffer, "Transfer-Encoding: chunked");
     return 0;
 }
@@ -2685,13 +3884,24 @@ static int http_receive_data(HTTPContext *c)
         if (c->data_count > FFM_PACKET_SIZE) {
 
             //            printf("writing pos=0x%"PRIx64" size=0x%"PRIx64"\n", feed->feed_write_index, feed->feed_size);
-            /* XXX: use llseek or url_seek */
-            lseek(c->feed_fd, feed->feed_write_index, SEEK_SET);
-            if (write(c->feed_fd, c->buffer, FFM_PACKET_SIZE) < 0) {
-                http_log("Error writing to feed file: %s\n", strerror(errno));
-                goto fail;
+            if (feed->map && feed->feed_write_index + FFM_PACKET_SIZE <= feed->feed_size) {
+                /* the page already exists in the file: overwrite it in
+                   the mapping */
+                memcpy(feed->map + feed->feed_write_index, c->buffer, FFM_PACKET_SIZE);
+            } else {
+                /* XXX: use llseek or url_seek */
+                lseek(c->feed_fd, feed->feed_write_index, SEEK_SET);
+                if (write(c->feed_fd, c->buffer, FFM_PACKET_SIZE) < 0) {
+                    http_log("Error writing to feed file: %s\n", strerror(errno));
+                    goto fail;
+                }
             }
 
+            /* the page header holds the dts of the first packet starting
+               in it, if any */
+            if (AV_RB64(c->buffer + 4))
+                feed->feed_head_dts = AV_RB64(c->buffer + 4);
+
             feed->feed_write_index += FFM_PACKET_SIZE;
             /* update file size */
             if (feed->feed_write_index > c->stream->feed_size)
@@ -2702,16 +3912,21 @@ static int http_receive_data(HTTPContext *c)
                 feed->feed_write_index = FFM_PACKET_SIZE;
 
             /* write index */
-            if (ffm_write_write_index(c->feed_fd, feed->feed_write_index) < 0) {
+            if (feed->map)
+                AV_WB64(feed->map + 8, feed->feed_write_index);
+            else if (ffm_write_write_index(c->feed_fd, feed->feed_write_index) < 0) {
                 http_log("Error writing index to feed file: %s\n", strerror(errno));
                 goto fail;
             }
+            store_feed_state(feed);
 
             /* wake up any waiting connections */
             for(c1 = first_http_ctx; c1 != NULL; c1 = c1->next) {
                 if (c1->state == HTTPSTATE_WAIT_FEED &&
-                    c1->stream->feed == c->stream->feed)
+                    c1->stream->feed == c->stream->feed) {
                     c1->state = HTTPSTATE_SEND_DATA;
+                    update_poll_events(c1);
+                }
             }
         } else {
             /* We have a header in our hands that contains useful data */
@@ -2764,12 +3979,15 @@ static int http_receive_data(HTTPContext *c)
     return 0;
  fail:
     c->stream->feed_opened = 0;
+    store_feed_state(c->stream);
     close(c->feed_fd);
     /* wake up any waiting connections to stop waiting for feed */
     for(c1 = first_http_ctx; c1 != NULL; c1 = c1->next) {
         if (c1->state == HTTPSTATE_WAIT_FEED &&
-            c1->stream->feed == c->stream->feed)
+            c1->stream->feed == c->stream->feed) {
             c1->state = HTTPSTATE_SEND_DATA_TRAILER;
+            update_poll_events(c1);
+        }
     }
     return -1;
 }
@@ -3236,6 +4454,7 @@ static void rtsp_cmd_play(HTTPContext *c, const char *url, RTSPMessageHeader *h)
     }
 
     rtp_c->state = HTTPSTATE_SEND_DATA;
+    update_poll_events(rtp_c);
 
     /* now everything is OK, so we can send the connection parameters */
     rtsp_reply_header(c, RTSP_STATUS_OK);
@@ -3262,6 +4481,7 @@ static void rtsp_cmd_pause(HTTPContext *c, const char *url, RTSPMessageHeader *h
 
     rtp_c->state = HTTPSTATE_READY;
     rtp_c->first_pts = AV_NOPTS_VALUE;
+    update_poll_events(rtp_c);
     /* now everything is OK, so we can send the connection parameters */
     rtsp_reply_header(c, RTSP_STATUS_OK);
     /* session ID */
@@ -3789,8 +5009,27 @@ static void build_feed_streams(void)
         /* ensure that we do not wrap before the end of file */
         if (feed->feed_max_size && feed->feed_max_size < feed->feed_size)
             feed->feed_max_size = feed->feed_size;
-
         close(fd);
+
+        if (feed->mapped) {
+            /* map the whole ring, the file grows inside the mapping
+               until it wraps around. The last page written may end
+               after the maximum size. */
+            fd = open(feed->feed_filename, feed->readonly ? O_RDONLY : O_RDWR);
+            if (fd < 0 || feed->feed_max_size > INT_MAX - FFM_PACKET_SIZE) {
+                http_log("Could not map feed file '%s'\n", feed->feed_filename);
+                exit(1);
+            }
+            feed->map = mmap(NULL, feed->feed_max_size + FFM_PACKET_SIZE,
+                             PROT_READ | (feed->readonly ? 0 : PROT_WRITE),
+                             MAP_SHARED, fd, 0);
+            close(fd);
+            if (feed->map == MAP_FAILED) {
+                http_log("Could not map feed file '%s': %s\n",
+                         feed->feed_filename, strerror(errno));
+                exit(1);
+            }
+        }
     }
 }
 
@@ -4038,6 +5277,8 @@ static int parse_ffconfig(const char *filename)
             }
         } else if (!strcasecmp(cmd, "NoDaemon")) {
             ffserver_daemon = 0;
+        } else if (!strcasecmp(cmd, "NoEpoll")) {
+            use_epoll = 0;
         } else if (!strcasecmp(cmd, "RTSPPort")) {
             get_arg(arg, sizeof(arg), &p);
             val = atoi(arg);
@@ -4065,6 +5306,13 @@ static int parse_ffconfig(const char *filename)
             } else {
                 nb_max_connections = val;
             }
+        } else if (!strcasecmp(cmd, "Workers")) {
+            get_arg(arg, sizeof(arg), &p);
+            val = atoi(arg);
+            if (val < 1 || val > 256) {
+                ERROR("Invalid Workers: %s\n", arg);
+            } else
+                nb_workers = val;
         } else if (!strcasecmp(cmd, "MaxBandwidth")) {
             int64_t llval;
             get_arg(arg, sizeof(arg), &p);
@@ -4173,9 +5421,15 @@ static int parse_ffconfig(const char *filename)
                     ERROR("Feed max file size is too small, must be at least %d\n", FFM_PACKET_SIZE*4);
                 }
             }
+        } else if (!strcasecmp(cmd, "MapFile")) {
+            if (feed)
+                feed->mapped = 1;
         } else if (!strcasecmp(cmd, "</Feed>")) {
             if (!feed) {
                 ERROR("No corresponding <Feed> for </Feed>\n");
+            } else if (feed->mapped &&
+                       (!feed->feed_max_size || feed->feed_max_size > INT_MAX / 2)) {
+                ERROR("MapFile requires a FileMaxSize below 1G\n");
             }
             feed = NULL;
         } else if (!strcasecmp(cmd, "<Stream")) {
@@ -4496,6 +5750,13 @@ static int parse_ffconfig(const char *filename)
             get_arg(arg, sizeof(arg), &p);
             if (stream)
                 stream->multicast_ttl = atoi(arg);
+        } else if (!strcasecmp(cmd, "SharedMux")) {
+            get_arg(arg, sizeof(arg), &p);
+            if (stream) {
+                stream->shared_mux_size = atoi(arg);
+                if (stream->shared_mux_size < 0)
+                    ERROR("Invalid SharedMux ring size: %s\n", arg);
+            }
         } else if (!strcasecmp(cmd, "NoLoop")) {
             if (stream)
                 stream->loop = 0;
@@ -4515,6 +5776,11 @@ static int parse_ffconfig(const char *filename)
                         add_codec(stream, &video_enc);
                     }
                 }
+                if (stream->shared_mux_size &&
+                    (!stream->feed || stream->feed == stream)) {
+                    ERROR("SharedMux requires a stream of a feed\n");
+                    stream->shared_mux_size = 0;
+                }
                 stream = NULL;
             }
         } else if (!strcasecmp(cmd, "<Redirect")) {
@@ -4568,7 +5834,7 @@ static int parse_ffconfig(const char *filename)
 static void handle_child_exit(int sig)
 {
     pid_t pid;
-    int status;
+    int status, i;
 
     while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
         FFStream *feed;
@@ -4585,6 +5851,15 @@ static void handle_child_exit(int sig)
                     feed->child_argv = 0;
             }
         }
+        for (i = 1; worker_pids && i < nb_workers; i++) {
+            if (worker_pids[i] == pid) {
+                fprintf(stderr, "Worker %d (pid %d) exited with status %d\n", i + 1, pid, status);
+                worker_pids[i] = 0;
+                /* never leave a connection to it */
+                worker_loads[i] = INT_MAX;
+                worker_accepting[i] = 0;
+            }
+        }
     }
 
     need_to_start_children = 1;
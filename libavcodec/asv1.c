@@ -511,6 +511,7 @@ static int encode_frame(AVCodecContext *avctx, unsigned char *buf, int buf_size,
     align_put_bits(&a->pb);
     while(put_bits_count(&a->pb)&31)
         put_bits(&a->pb, 8, 0);
+    flush_put_bits(&a->pb);
 
     size= put_bits_count(&a->pb)/32;
 
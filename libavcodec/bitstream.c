@@ -339,3 +339,34 @@ void free_vlc(VLC *vlc)
     av_freep(&vlc->table);
 }
 
+void ff_init_vlc_multi(VLC_MULTI_ELEM *multi, const VLC *vlc,
+                       int max_symbols, int flags)
+{
+    const int bits = vlc->bits;
+    const unsigned mask = (1 << bits) - 1;
+    unsigned i;
+
+    max_symbols = FFMIN(max_symbols, VLC_MULTI_MAX_SYMBOLS);
+
+    for (i = 0; i <= mask; i++) {
+        VLC_MULTI_ELEM *e = &multi[i];
+        int pos = 0;
+
+        memset(e, 0, sizeof(*e));
+        while (e->num < max_symbols) {
+            /* the bits after the codes read so far, padded with zeros */
+            unsigned index = flags & INIT_VLC_LE ? i >> pos : (i << pos) & mask;
+            int code = vlc->table[index][0];
+            int n    = vlc->table[index][1];
+
+            /* stop at invalid codes, subtables, codes which are cut off
+             * by the end of the lookup and symbols which do not fit */
+            if (n <= 0 || pos + n > bits || code < 0 || code > 255)
+                break;
+            e->val[e->num++] = code;
+            pos += n;
+        }
+        e->len = pos;
+    }
+}
+
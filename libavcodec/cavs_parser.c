@@ -43,10 +43,9 @@ static int cavs_find_frame_end(ParseContext *pc, const uint8_t *buf,
 
     i=0;
     if(!pic_found){
-        for(i=0; i<buf_size; i++){
-            state= (state<<8) | buf[i];
+        while(i<buf_size){
+            i= ff_find_start_code(buf+i, buf+buf_size, &state) - buf;
             if(state == PIC_I_START_CODE || state == PIC_PB_START_CODE){
-                i++;
                 pic_found=1;
                 break;
             }
@@ -57,14 +56,12 @@ static int cavs_find_frame_end(ParseContext *pc, const uint8_t *buf,
         /* EOF considered as end of frame */
         if (buf_size == 0)
             return 0;
-        for(; i<buf_size; i++){
-            state= (state<<8) | buf[i];
-            if((state&0xFFFFFF00) == 0x100){
-                if(state > SLICE_MAX_START_CODE){
-                    pc->frame_start_found=0;
-                    pc->state=-1;
-                    return i-3;
-                }
+        while(i<buf_size){
+            i= ff_find_start_code(buf+i, buf+buf_size, &state) - buf;
+            if((state&0xFFFFFF00) == 0x100 && state > SLICE_MAX_START_CODE){
+                pc->frame_start_found=0;
+                pc->state=-1;
+                return i-4;
             }
         }
     }
@@ -0,0 +1,2037 @@
+/*
+ * DSP function test
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * DSP function test.
+ * The DSP contexts are initialized once per CPU flag set, restricting the
+ * CPU flags with av_set_cpu_flags_mask(). Every function which differs
+ * from the C version is run on random input next to the C version, the
+ * outputs are compared and the cycles of both are reported.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "libavutil/cpu.h"
+#include "libavutil/lfg.h"
+#include "libavutil/timer.h"
+#include "avcodec.h"
+#include "dsputil.h"
+#include "fft.h"
+#include "h264dsp.h"
+#include "startcode.h"
+#include "vp56dsp.h"
+
+#undef exit
+#undef printf
+#undef random
+
+#define STRIDE      64
+#define BUF_SIZE    (STRIDE * 48)
+#define NB_CHECKS   32
+#define BENCH_RUNS  64
+#define FLOAT_LEN   256
+
+enum {
+    CTX_DSP,
+    CTX_H264,
+    CTX_VP5,
+    CTX_VP6,
+    CTX_FFT,
+    CTX_MDCT,
+    CTX_STARTCODE,
+};
+
+static const struct {
+    int nbits, inverse;
+} fft_sizes[] = {
+    {  4, 0 }, {  6, 0 }, {  8, 0 }, { 10, 0 }, { 8, 1 },
+}, mdct_sizes[] = {
+    {  6, 1 }, {  8, 1 }, { 11, 1 }, { 8, 0 },
+};
+
+static const struct {
+    const char *name;
+    int flags;
+} cpu_flag_sets[] = {
+    { "c",        0 },
+#if ARCH_X86
+    { "mmx",      AV_CPU_FLAG_MMX      },
+    { "mmx2",     AV_CPU_FLAG_MMX2     },
+    { "3dnow",    AV_CPU_FLAG_3DNOW    },
+    { "3dnowext", AV_CPU_FLAG_3DNOWEXT },
+    { "sse",      AV_CPU_FLAG_SSE      },
+    { "sse2",     AV_CPU_FLAG_SSE2     },
+    { "sse3",     AV_CPU_FLAG_SSE3     },
+    { "ssse3",    AV_CPU_FLAG_SSSE3    },
+    { "sse4",     AV_CPU_FLAG_SSE4     },
+    { "sse42",    AV_CPU_FLAG_SSE42    },
+#else
+    { "simd",     -1 },
+#endif
+};
+
+#define NB_FLAG_SETS FF_ARRAY_ELEMS(cpu_flag_sets)
+
+/** all contexts, initialized with one set of CPU flags */
+typedef struct Impl {
+    const char *name;
+    int flags;
+    DSPContext dsp;
+    H264DSPContext h264;
+    VP56DSPContext vp5, vp6;
+    FFTContext fft[FF_ARRAY_ELEMS(fft_sizes)];
+    FFTContext mdct[FF_ARRAY_ELEMS(mdct_sizes)];
+    const uint8_t *(*find_start_code_prefix)(const uint8_t *p, const uint8_t *end);
+} Impl;
+
+typedef void (*dsp_func)(void);
+
+typedef struct DSPTest DSPTest;
+
+/**
+ * Run the C version fref and the SIMD version fnew on the same random input.
+ * @param i,j index of the function in the tables of the context
+ * @return 0 if the outputs match
+ */
+typedef int (*check_func)(const DSPTest *t, int i, int j,
+                          Impl *ref, Impl *new, dsp_func fref, dsp_func fnew);
+
+struct DSPTest {
+    const char *name;
+    int ctx;
+    size_t offset;
+    int n1, n2;         ///< table dimensions, 1 for scalars
+    check_func check;
+    int w[10];          ///< width of the block, or check specific, per first index
+    int h[10];          ///< height of the block if it differs from the width, or check specific
+};
+
+static Impl impls[NB_FLAG_SETS];
+static int nb_impls;
+
+static AVLFG lfg;
+static int bench = 1;
+static double cycles_ref, cycles_new;
+
+DECLARE_ALIGNED(16, static uint8_t, src0)[BUF_SIZE];
+DECLARE_ALIGNED(16, static uint8_t, src1)[BUF_SIZE];
+DECLARE_ALIGNED(16, static uint8_t, dst0)[BUF_SIZE];
+DECLARE_ALIGNED(16, static uint8_t, dst1)[BUF_SIZE];
+DECLARE_ALIGNED(16, static DCTELEM, blk0)[64 * 24];
+DECLARE_ALIGNED(16, static DCTELEM, blk1)[64 * 24];
+DECLARE_ALIGNED(16, static DCTELEM, blk2)[64 * 24];
+DECLARE_ALIGNED(16, static float, fsrc0)[FLOAT_LEN * 8];
+DECLARE_ALIGNED(16, static float, fsrc1)[FLOAT_LEN * 8];
+DECLARE_ALIGNED(16, static float, fsrc2)[FLOAT_LEN * 8];
+DECLARE_ALIGNED(16, static float, fdst0)[FLOAT_LEN * 8];
+DECLARE_ALIGNED(16, static float, fdst1)[FLOAT_LEN * 8];
+
+#define rnd() av_lfg_get(&lfg)
+
+#ifdef AV_READ_TIME
+/* the best of BENCH_RUNS runs of four calls, which hides interrupts and
+ * cache misses of the first call */
+#define BENCH(cycles, call) do {                                        \
+    uint64_t best_ = UINT64_MAX;                                        \
+    int r_, k_;                                                         \
+    for (r_ = 0; bench && r_ < BENCH_RUNS; r_++) {                      \
+        uint64_t t_ = AV_READ_TIME();                                   \
+        for (k_ = 0; k_ < 4; k_++) {                                    \
+            call;                                                       \
+        }                                                               \
+        t_ = AV_READ_TIME() - t_;                                       \
+        if (t_ < best_)                                                 \
+            best_ = t_;                                                 \
+    }                                                                   \
+    emms_c();                                                           \
+    if (bench)                                                          \
+        cycles = best_ / 4.0;                                           \
+} while (0)
+#else
+#define BENCH(cycles, call) do { } while (0)
+#endif
+
+#define BENCH2(call_ref, call_new) do {                                 \
+    BENCH(cycles_ref, call_ref);                                        \
+    BENCH(cycles_new, call_new);                                        \
+} while (0)
+
+static float rnd_float(void)
+{
+    return (int32_t)rnd() * (1.0f / 2147483648.0f);
+}
+
+static void randomize(uint8_t *buf, int size)
+{
+    while (size--)
+        *buf++ = rnd();
+}
+
+/**
+ * Fill buf with pixels around a random base value, with an amplitude
+ * chosen so that loop filters see both edges they filter and edges they
+ * leave alone.
+ */
+static void randomize_smooth(uint8_t *buf, int size)
+{
+    static const int amp[] = { 2, 4, 8, 16, 32, 256 };
+    int a    = amp[rnd() % FF_ARRAY_ELEMS(amp)];
+    int base = rnd() & 255;
+
+    while (size--)
+        *buf++ = av_clip_uint8(base + (int)(rnd() % a) - a / 2);
+}
+
+static void randomize_blk(DCTELEM *blk, int size, int range)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        blk[i] = (int)(rnd() % (2 * range)) - range;
+}
+
+/** Like randomize_blk() but leaves most coefficients zero. */
+static void randomize_coeffs(DCTELEM *blk, int size, int range)
+{
+    int i, density = rnd() % 4;
+
+    for (i = 0; i < size; i++)
+        blk[i] = (int)(rnd() & 3) < density ? (int)(rnd() % (2 * range)) - range : 0;
+}
+
+static void randomize_float(float *buf, int size, float scale)
+{
+    while (size--)
+        *buf++ = rnd_float() * scale;
+}
+
+static int fail_u8(const uint8_t *a, const uint8_t *b, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        if (a[i] != b[i]) {
+            printf("    mismatch at offset %d: %d != %d\n", i, a[i], b[i]);
+            return 1;
+        }
+    return 0;
+}
+
+static int fail_s16(const int16_t *a, const int16_t *b, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        if (a[i] != b[i]) {
+            printf("    mismatch at index %d: %d != %d\n", i, a[i], b[i]);
+            return 1;
+        }
+    return 0;
+}
+
+static int fail_int(int a, int b)
+{
+    if (a != b) {
+        printf("    mismatch: %d != %d\n", a, b);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Compare floats, allowing a difference of eps * (|a| + scale).
+ * eps 0 asks for bit exact output.
+ */
+static int fail_float(const float *a, const float *b, int size, float eps, float scale)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        if (eps ? !(fabsf(a[i] - b[i]) <= eps * (fabsf(a[i]) + scale)) : a[i] != b[i]) {
+            printf("    mismatch at index %d: %.9g != %.9g\n", i, a[i], b[i]);
+            return 1;
+        }
+    return 0;
+}
+
+#if CONFIG_FFT || CONFIG_MDCT
+static float max_abs(const float *a, int size)
+{
+    float m = 0;
+
+    while (size--)
+        m = FFMAX(m, fabsf(a[size]));
+    return m;
+}
+#endif
+
+#define DECL(type)                      \
+    type f0 = (type)fref;               \
+    type f1 = (type)fnew;               \
+    int n
+
+#define DECL_FUNC(ret, args)            \
+    ret (*f0)args = (void *)fref;       \
+    ret (*f1)args = (void *)fnew;       \
+    int n
+
+#define CHECK_ARGS const DSPTest *t, int i, int j, Impl *ref, Impl *new, \
+                   dsp_func fref, dsp_func fnew
+
+#define W (t->w[i])
+#define H (t->h[i] ? t->h[i] : t->w[i])
+
+/* pixel copy/average, dst aligned, src not */
+static int check_pixels(CHECK_ARGS)
+{
+    DECL(op_pixels_func);
+    uint8_t *d0 = dst0 + 2 * STRIDE, *d1 = dst1 + 2 * STRIDE, *src;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        src = src0 + 2 * STRIDE + (rnd() & 15);
+        f0(d0, src, STRIDE, H);
+        f1(d1, src, STRIDE, H);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 2 * STRIDE + 1, STRIDE, H),
+           f1(d1, src0 + 2 * STRIDE + 1, STRIDE, H));
+    return 0;
+}
+
+static int check_pixels_l2(CHECK_ARGS)
+{
+    void (*f0)(uint8_t *, const uint8_t *, const uint8_t *, int, int) = (void *)fref;
+    void (*f1)(uint8_t *, const uint8_t *, const uint8_t *, int, int) = (void *)fnew;
+    uint8_t *d0 = dst0 + 2 * STRIDE, *d1 = dst1 + 2 * STRIDE, *a, *b;
+    int n;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(src1, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        a = src0 + 2 * STRIDE + (rnd() & 15);
+        b = src1 + 2 * STRIDE + (rnd() & 15);
+        f0(d0, a, b, STRIDE, H);
+        f1(d1, a, b, STRIDE, H);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 1, src1 + 3, STRIDE, H),
+           f1(d1, src0 + 1, src1 + 3, STRIDE, H));
+    return 0;
+}
+
+/* VC-1 mspel: an 8x8 op_pixels_func whose last argument is the rounding mode */
+static int check_vc1_mspel(CHECK_ARGS)
+{
+    DECL(op_pixels_func);
+    uint8_t *d0 = dst0 + 8 * STRIDE, *d1 = dst1 + 8 * STRIDE, *src;
+    int r;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        src = src0 + 8 * STRIDE + 8 + (rnd() & 7);
+        r   = rnd() & 1;
+        f0(d0, src, STRIDE, r);
+        f1(d1, src, STRIDE, r);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 8 * STRIDE + 9, STRIDE, 0),
+           f1(d1, src0 + 8 * STRIDE + 9, STRIDE, 0));
+    return 0;
+}
+
+/* subpel interpolation of pixels up to max, reading a few pixels around the block */
+static int qpel(qpel_mc_func f0, qpel_mc_func f1, int max)
+{
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16, *src;
+    int n, k;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        for (k = 0; k < BUF_SIZE; k++)
+            src0[k] = src0[k] * (max + 1) >> 8;
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        src = src0 + 8 * STRIDE + 8 + (rnd() & 15);
+        f0(d0, src, STRIDE);
+        f1(d1, src, STRIDE);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 8 * STRIDE + 9, STRIDE),
+           f1(d1, src0 + 8 * STRIDE + 9, STRIDE));
+    return 0;
+}
+
+static int check_qpel(CHECK_ARGS)
+{
+    return qpel((qpel_mc_func)fref, (qpel_mc_func)fnew, 255);
+}
+
+/* The MMX vertical CAVS filters sum in 16 bits, which overflows for
+ * 255 next to darker pixels. */
+static int check_cavs_qpel(CHECK_ARGS)
+{
+    return qpel((qpel_mc_func)fref, (qpel_mc_func)fnew, 223);
+}
+
+static int check_chroma(CHECK_ARGS)
+{
+    DECL(h264_chroma_mc_func);
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16, *src;
+    int x, y;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        src = src0 + 8 * STRIDE + 8 + (rnd() & 15);
+        x   = rnd() & 7;
+        y   = rnd() & 7;
+        f0(d0, src, STRIDE, H, x, y);
+        f1(d1, src, STRIDE, H, x, y);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 8 * STRIDE + 9, STRIDE, H, 3, 5),
+           f1(d1, src0 + 8 * STRIDE + 9, STRIDE, H, 3, 5));
+    return 0;
+}
+
+static int check_cmp(CHECK_ARGS)
+{
+    DECL(me_cmp_func);
+    uint8_t *a = src0 + 8 * STRIDE + 16, *b;
+    int r0, r1;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(src1, BUF_SIZE);
+        b  = src1 + 8 * STRIDE + 8 + (rnd() & 15);
+        r0 = f0(NULL, a, b, STRIDE, H);
+        r1 = f1(NULL, a, b, STRIDE, H);
+        emms_c();
+        if (fail_int(r0, r1))
+            return 1;
+    }
+    b = src1 + 8 * STRIDE + 9;
+    BENCH2(f0(NULL, a, b, STRIDE, H), f1(NULL, a, b, STRIDE, H));
+    return 0;
+}
+
+static int check_get_pixels(CHECK_ARGS)
+{
+    void (*f0)(DCTELEM *, const uint8_t *, int) = (void *)fref;
+    void (*f1)(DCTELEM *, const uint8_t *, int) = (void *)fnew;
+    int n;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize_blk(blk0, 64, 1 << 15);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        f0(blk0, src0 + 8, STRIDE);
+        f1(blk1, src0 + 8, STRIDE);
+        emms_c();
+        if (fail_s16(blk0, blk1, 64))
+            return 1;
+    }
+    BENCH2(f0(blk0, src0, STRIDE), f1(blk1, src0, STRIDE));
+    return 0;
+}
+
+static int check_diff_pixels(CHECK_ARGS)
+{
+    void (*f0)(DCTELEM *, const uint8_t *, const uint8_t *, int) = (void *)fref;
+    void (*f1)(DCTELEM *, const uint8_t *, const uint8_t *, int) = (void *)fnew;
+    int n;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(src1, BUF_SIZE);
+        f0(blk0, src0 + 8, src1 + 16, STRIDE);
+        f1(blk1, src0 + 8, src1 + 16, STRIDE);
+        emms_c();
+        if (fail_s16(blk0, blk1, 64))
+            return 1;
+    }
+    BENCH2(f0(blk0, src0, src1, STRIDE), f1(blk1, src0, src1, STRIDE));
+    return 0;
+}
+
+/* put/add a block of coefficients in [-w, w) to pixels */
+static int check_put_block(CHECK_ARGS)
+{
+    void (*f0)(const DCTELEM *, uint8_t *, int) = (void *)fref;
+    void (*f1)(const DCTELEM *, uint8_t *, int) = (void *)fnew;
+    uint8_t *d0 = dst0 + 8 * STRIDE + 8, *d1 = dst1 + 8 * STRIDE + 8;
+    int n;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_blk(blk0, 64, W);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(blk0, d0, STRIDE);
+        f1(blk0, d1, STRIDE);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(blk0, d0, STRIDE), f1(blk0, d1, STRIDE));
+    return 0;
+}
+
+/* add_pixels8/4: pixels += block without clipping */
+static int check_add_pixels(CHECK_ARGS)
+{
+    void (*f0)(uint8_t *, DCTELEM *, int) = (void *)fref;
+    void (*f1)(uint8_t *, DCTELEM *, int) = (void *)fnew;
+    uint8_t *d0 = dst0 + 8 * STRIDE + 8, *d1 = dst1 + 8 * STRIDE + 8;
+    int n;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_blk(blk0, 64, 256);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(d0, blk0, STRIDE);
+        f1(d1, blk1, STRIDE);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE) || fail_s16(blk0, blk1, 64))
+            return 1;
+    }
+    BENCH2(f0(d0, blk0, STRIDE), f1(d1, blk1, STRIDE));
+    return 0;
+}
+
+static int check_sum_abs(CHECK_ARGS)
+{
+    DECL_FUNC(int, (DCTELEM *));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_blk(blk0, 64, 256);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        if (fail_int(f0(blk0), f1(blk1)))
+            return 1;
+        emms_c();
+    }
+    BENCH2(f0(blk0), f1(blk1));
+    return 0;
+}
+
+/* clear_block, clear_blocks: w is the number of blocks */
+static int check_clear(CHECK_ARGS)
+{
+    DECL_FUNC(void, (DCTELEM *));
+
+    for (n = 0; n < 4; n++) {
+        randomize_blk(blk0, 64 * 8, 1 << 15);
+        memcpy(blk1, blk0, 64 * 8 * sizeof(DCTELEM));
+        f0(blk0);
+        f1(blk1);
+        emms_c();
+        if (fail_s16(blk0, blk1, 64 * 8))
+            return 1;
+    }
+    BENCH2(f0(blk0), f1(blk1));
+    return 0;
+}
+
+static int check_pix_sum(CHECK_ARGS)
+{
+    DECL_FUNC(int, (uint8_t *, int));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        if (fail_int(f0(src0 + 16, STRIDE), f1(src0 + 16, STRIDE)))
+            return 1;
+        emms_c();
+    }
+    BENCH2(f0(src0, STRIDE), f1(src0, STRIDE));
+    return 0;
+}
+
+static int check_ssd_int8(CHECK_ARGS)
+{
+    DECL_FUNC(int, (const int8_t *, const int16_t *, int));
+    int size;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        size = 8 * (1 + rnd() % 64);
+        randomize(src0, BUF_SIZE);
+        randomize_blk(blk0, size, 256);
+        if (fail_int(f0((int8_t *)src0, blk0, size), f1((int8_t *)src0, blk0, size)))
+            return 1;
+        emms_c();
+    }
+    BENCH2(f0((int8_t *)src0, blk0, 512), f1((int8_t *)src0, blk0, 512));
+    return 0;
+}
+
+static int check_gmc1(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, uint8_t *, int, int, int, int, int));
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16, *src;
+    int x16, y16, r;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        src = src0 + 8 * STRIDE + 8 + (rnd() & 15);
+        x16 = rnd() & 15;
+        y16 = rnd() & 15;
+        r   = 128 - (rnd() & 1);
+        f0(d0, src, STRIDE, 8, x16, y16, r);
+        f1(d1, src, STRIDE, 8, x16, y16, r);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 8 * STRIDE + 9, STRIDE, 8, 5, 3, 128),
+           f1(d1, src0 + 8 * STRIDE + 9, STRIDE, 8, 5, 3, 128));
+    return 0;
+}
+
+static int check_fill_block(CHECK_ARGS)
+{
+    DECL(op_fill_func);
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+    int v;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        v = rnd() & 255;
+        f0(d0, v, STRIDE, H);
+        f1(d1, v, STRIDE, H);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, 17, STRIDE, H), f1(d1, 17, STRIDE, H));
+    return 0;
+}
+
+static int check_scale_block(CHECK_ARGS)
+{
+    DECL_FUNC(void, (const uint8_t *, uint8_t *, int));
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, 64);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(src0, d0, STRIDE);
+        f1(src0, d1, STRIDE);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(src0, d0, STRIDE), f1(src0, d1, STRIDE));
+    return 0;
+}
+
+/* huffyuv byte rows: add_bytes; w 1 for add_bytes_l2 and diff_bytes */
+static int check_bytes(CHECK_ARGS)
+{
+    void (*f0)(uint8_t *, uint8_t *, uint8_t *, int) = (void *)fref;
+    void (*f1)(uint8_t *, uint8_t *, uint8_t *, int) = (void *)fnew;
+    void (*g0)(uint8_t *, uint8_t *, int) = (void *)fref;
+    void (*g1)(uint8_t *, uint8_t *, int) = (void *)fnew;
+    int n, w;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        w = 1 + rnd() % 1024;
+        randomize(src0, BUF_SIZE);
+        randomize(src1, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        if (W) {
+            f0(dst0, src0, src1 + 1, w);
+            f1(dst1, src0, src1 + 1, w);
+        } else {
+            g0(dst0, src0, w);
+            g1(dst1, src0, w);
+        }
+        emms_c();
+        if (fail_u8(dst0, dst1, w))
+            return 1;
+    }
+    if (W)
+        BENCH2(f0(dst0, src0, src1 + 1, 1024), f1(dst1, src0, src1 + 1, 1024));
+    else
+        BENCH2(g0(dst0, src0, 1024), g1(dst1, src0, 1024));
+    return 0;
+}
+
+static int check_hfyu_median(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, const uint8_t *, const uint8_t *, int, int *, int *));
+    int w, l0, l1, lt0, lt1;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        w = 1 + rnd() % 1024;
+        randomize(src0, BUF_SIZE);
+        randomize(src1, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        l0  = l1  = rnd() & 255;
+        lt0 = lt1 = rnd() & 255;
+        f0(dst0 + 16, src0 + 16, src1 + 16, w, &l0, &lt0);
+        f1(dst1 + 16, src0 + 16, src1 + 16, w, &l1, &lt1);
+        emms_c();
+        if (fail_u8(dst0 + 16, dst1 + 16, w) || fail_int(l0, l1) || fail_int(lt0, lt1))
+            return 1;
+    }
+    BENCH2(f0(dst0 + 16, src0 + 16, src1 + 16, 1024, &l0, &lt0),
+           f1(dst1 + 16, src0 + 16, src1 + 16, 1024, &l1, &lt1));
+    return 0;
+}
+
+static int check_hfyu_left(CHECK_ARGS)
+{
+    DECL_FUNC(int, (uint8_t *, const uint8_t *, int, int));
+    int w, left, r0, r1;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        w    = 1 + rnd() % 1024;
+        left = rnd() & 255;
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        r0 = f0(dst0, src0, w, left);
+        r1 = f1(dst1, src0, w, left);
+        emms_c();
+        if (fail_u8(dst0, dst1, w) || fail_int(r0, r1))
+            return 1;
+    }
+    BENCH2(f0(dst0, src0, 1024, 0), f1(dst1, src0, 1024, 0));
+    return 0;
+}
+
+static int check_hfyu_left_bgr32(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, const uint8_t *, int, int *, int *, int *, int *));
+    int w, k, c0[4], c1[4];
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        w = 1 + rnd() % 256;
+        for (k = 0; k < 4; k++)
+            c0[k] = c1[k] = rnd() & 255;
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(dst0, src0, w, &c0[0], &c0[1], &c0[2], &c0[3]);
+        f1(dst1, src0, w, &c1[0], &c1[1], &c1[2], &c1[3]);
+        emms_c();
+        if (fail_u8(dst0, dst1, 4 * w))
+            return 1;
+        for (k = 0; k < 4; k++)
+            if (fail_int(c0[k], c1[k]))
+                return 1;
+    }
+    BENCH2(f0(dst0, src0, 256, &c0[0], &c0[1], &c0[2], &c0[3]),
+           f1(dst1, src0, 256, &c1[0], &c1[1], &c1[2], &c1[3]));
+    return 0;
+}
+
+/* png paeth: the first bpp bytes of the row are done by the caller and
+ * the function may write one byte past w */
+static int check_png_paeth(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, uint8_t *, uint8_t *, int, int));
+    int w, bpp;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        bpp = 3 + (rnd() & 1);
+        w   = bpp * (1 + rnd() % 256);
+        randomize(src0, BUF_SIZE);
+        randomize(src1, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(dst0 + 16, src0 + 16, src1 + 16, w, bpp);
+        f1(dst1 + 16, src0 + 16, src1 + 16, w, bpp);
+        emms_c();
+        if (fail_u8(dst0, dst1, 16 + w))
+            return 1;
+    }
+    BENCH2(f0(dst0 + 16, src0 + 16, src1 + 16, 768, 3),
+           f1(dst1 + 16, src0 + 16, src1 + 16, 768, 3));
+    return 0;
+}
+
+static int check_bswap_buf(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint32_t *, const uint32_t *, int));
+    int w;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        w = 1 + rnd() % 512;
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0((uint32_t *)dst0, (uint32_t *)src0, w);
+        f1((uint32_t *)dst1, (uint32_t *)src0, w);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0((uint32_t *)dst0, (uint32_t *)src0, 512),
+           f1((uint32_t *)dst1, (uint32_t *)src0, 512));
+    return 0;
+}
+
+/* in-place filters on an edge in the middle of the buffer;
+ * w is the range of the strength argument, 0 if there is none */
+static int check_filter(CHECK_ARGS)
+{
+    void (*f0)(uint8_t *, int, int) = (void *)fref;
+    void (*f1)(uint8_t *, int, int) = (void *)fnew;
+    uint8_t *d0 = dst0 + 16 * STRIDE + 16, *d1 = dst1 + 16 * STRIDE + 16;
+    int n, q;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_smooth(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        q = W ? 1 + rnd() % W : 0;
+        f0(d0, STRIDE, q);
+        f1(d1, STRIDE, q);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, STRIDE, W), f1(d1, STRIDE, W));
+    return 0;
+}
+
+static int check_vp3_filter(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, int, int *));
+    uint8_t *d0 = dst0 + 16 * STRIDE + 16, *d1 = dst1 + 16 * STRIDE + 16;
+    int array[256 + 2], *bounding_values = array + 127;
+    int x, value, filter_limit;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        /* same as init_loop_filter() in vp3.c */
+        filter_limit = 1 + rnd() % 64;
+        memset(array, 0, sizeof(array));
+        for (x = 0; x < filter_limit; x++) {
+            bounding_values[-x] = -x;
+            bounding_values[x]  =  x;
+        }
+        for (x = value = filter_limit; x < 128 && value; x++, value--) {
+            bounding_values[ x] =  value;
+            bounding_values[-x] = -value;
+        }
+        if (value)
+            bounding_values[128] = value;
+        bounding_values[129] = bounding_values[130] = filter_limit * 0x02020202;
+
+        randomize_smooth(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(d0, STRIDE, bounding_values);
+        f1(d1, STRIDE, bounding_values);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, STRIDE, bounding_values), f1(d1, STRIDE, bounding_values));
+    return 0;
+}
+
+static int check_vp6_diag4(CHECK_ARGS)
+{
+    /* a few rows of vp6_block_copy_filter */
+    static const int16_t filters[][4] = {
+        { -3, 122,   9,  0 }, { -4, 109,  24, -1 }, { -5,  91,  45, -3 },
+        { -4,  68,  68, -4 }, { -3,  45,  91, -5 }, { -1,  24, 109, -4 },
+        {  0,   9, 122, -3 }, { -4, 118,  16, -2 }, { -8,  90,  53, -7 },
+        { -8,  72,  72, -8 }, { -5,  34, 106, -7 }, { -2,  16, 118, -4 },
+    };
+    DECL_FUNC(void, (uint8_t *, uint8_t *, int, const int16_t *, const int16_t *));
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16, *src;
+    const int16_t *hw, *vw;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        src = src0 + 8 * STRIDE + 8 + (rnd() & 15);
+        hw  = filters[rnd() % FF_ARRAY_ELEMS(filters)];
+        vw  = filters[rnd() % FF_ARRAY_ELEMS(filters)];
+        f0(d0, src, STRIDE, hw, vw);
+        f1(d1, src, STRIDE, hw, vw);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src0 + 8 * STRIDE + 9, STRIDE, filters[2], filters[4]),
+           f1(d1, src0 + 8 * STRIDE + 9, STRIDE, filters[2], filters[4]));
+    return 0;
+}
+
+/* (dest, line_size, block) transforms; w is the coefficient range */
+static int check_trans_add(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, int, DCTELEM *));
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_coeffs(blk0, 64, W);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        memcpy(blk2, blk0, 64 * sizeof(DCTELEM));
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(d0, STRIDE, blk0);
+        f1(d1, STRIDE, blk1);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, STRIDE, blk2), f1(d1, STRIDE, blk2));
+    return 0;
+}
+
+static void transpose8x8(DCTELEM *blk)
+{
+    int x, y;
+
+    for (y = 0; y < 8; y++)
+        for (x = 0; x < y; x++)
+            FFSWAP(DCTELEM, blk[8 * y + x], blk[8 * x + y]);
+}
+
+/**
+ * (dst, block, stride) transforms; w is the coefficient range.
+ * h 1 if the SIMD version takes the coefficients transposed, as the x86
+ * CAVS IDCT does through FF_TRANSPOSE_IDCT_PERM.
+ */
+static int check_idct_add(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, DCTELEM *, int));
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_coeffs(blk0, 64, W);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        if (t->h[0])
+            transpose8x8(blk1);
+        memcpy(blk2, blk0, 64 * sizeof(DCTELEM));
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(d0, blk0, STRIDE);
+        f1(d1, blk1, STRIDE);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, blk2, STRIDE), f1(d1, blk2, STRIDE));
+    return 0;
+}
+
+/* in-place transform of a block; w is the coefficient range */
+static int check_trans_inplace(CHECK_ARGS)
+{
+    DECL_FUNC(void, (DCTELEM *));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_coeffs(blk0, 64, W);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        f0(blk0);
+        f1(blk1);
+        emms_c();
+        if (fail_s16(blk0, blk1, 64))
+            return 1;
+    }
+    BENCH2(f0(blk0), f1(blk1));
+    return 0;
+}
+
+static int check_8x8basis(CHECK_ARGS)
+{
+    int (*f0)(int16_t *, int16_t *, int16_t *, int) = (void *)fref;
+    int (*f1)(int16_t *, int16_t *, int16_t *, int) = (void *)fnew;
+    int16_t *rem0 = blk0, *rem1 = blk1, *weight = blk2, *basis = blk2 + 64;
+    int n, k, scale;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        for (k = 0; k < 64; k++) {
+            rem0[k]   = rem1[k] = (int)(rnd() % 4096) - 2048;
+            weight[k] = rnd() % 64;
+            basis[k]  = (int)(rnd() % 16384) - 8192;
+        }
+        scale = (int)(rnd() % 256) - 128;
+        if (fail_int(f0(rem0, weight, basis, scale), f1(rem1, weight, basis, scale)))
+            return 1;
+        emms_c();
+    }
+    BENCH2(f0(rem0, weight, basis, 17), f1(rem1, weight, basis, 17));
+    return 0;
+}
+
+static int check_add_8x8basis(CHECK_ARGS)
+{
+    DECL_FUNC(void, (int16_t *, int16_t *, int));
+    int16_t *rem0 = blk0, *rem1 = blk1, *basis = blk2;
+    int k, scale;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        for (k = 0; k < 64; k++) {
+            rem0[k]  = rem1[k] = (int)(rnd() % 4096) - 2048;
+            basis[k] = (int)(rnd() % 16384) - 8192;
+        }
+        scale = (int)(rnd() % 256) - 128;
+        f0(rem0, basis, scale);
+        f1(rem1, basis, scale);
+        emms_c();
+        if (fail_s16(rem0, rem1, 64))
+            return 1;
+    }
+    BENCH2(f0(rem0, basis, 17), f1(rem1, basis, 17));
+    return 0;
+}
+
+static int check_draw_edges(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, int, int, int, int));
+    int edge  = W;
+    int wrap  = STRIDE;
+    int width = STRIDE - 2 * edge, height = BUF_SIZE / STRIDE - 2 * edge;
+    uint8_t *d0 = dst0 + edge * wrap + edge, *d1 = dst1 + edge * wrap + edge;
+
+    for (n = 0; n < 4; n++) {
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(d0, wrap, width, height, edge);
+        f1(d1, wrap, width, height, edge);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, wrap, width, height, edge), f1(d1, wrap, width, height, edge));
+    return 0;
+}
+
+static int check_scalarproduct_int16(CHECK_ARGS)
+{
+    DECL_FUNC(int32_t, (int16_t *, int16_t *, int, int));
+    int len, shift;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        len   = 16 * (1 + rnd() % 32);
+        shift = rnd() % 8;
+        randomize_blk(blk0, len, 1024);
+        randomize_blk(blk1, len, 1024);
+        if (fail_int(f0(blk0, blk1, len, shift), f1(blk0, blk1, len, shift)))
+            return 1;
+        emms_c();
+    }
+    BENCH2(f0(blk0, blk1, 512, 0), f1(blk0, blk1, 512, 0));
+    return 0;
+}
+
+static int check_scalarproduct_madd(CHECK_ARGS)
+{
+    DECL_FUNC(int32_t, (int16_t *, int16_t *, int16_t *, int, int));
+    int16_t *v0 = blk0, *v1 = blk1, *v2 = blk2, *v3 = blk2 + 512;
+    int len, mul, r0, r1;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        len = 16 * (1 + rnd() % 32);
+        mul = (int)(rnd() % 64) - 32;
+        randomize_blk(v0, len, 1024);
+        memcpy(v1, v0, len * sizeof(*v0));
+        randomize_blk(v2, len, 1024);
+        randomize_blk(v3, len, 1024);
+        r0 = f0(v0, v2, v3, len, mul);
+        r1 = f1(v1, v2, v3, len, mul);
+        emms_c();
+        if (fail_int(r0, r1) || fail_s16(v0, v1, len))
+            return 1;
+    }
+    BENCH2(f0(v0, v2, v3, 512, 1), f1(v1, v2, v3, 512, 1));
+    return 0;
+}
+
+static int check_vector_fmul(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const float *, int));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fdst0, FLOAT_LEN, 1);
+        memcpy(fdst1, fdst0, FLOAT_LEN * sizeof(float));
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        f0(fdst0, fsrc0, FLOAT_LEN);
+        f1(fdst1, fsrc0, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    /* values near 1 so that repeated calls stay out of denormals */
+    randomize_float(fsrc0, FLOAT_LEN, 0.01);
+    for (n = 0; n < FLOAT_LEN; n++)
+        fsrc0[n] += 1;
+    BENCH2(f0(fdst0, fsrc0, FLOAT_LEN), f1(fdst1, fsrc0, FLOAT_LEN));
+    return 0;
+}
+
+static int check_vector_fmul_reverse(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const float *, const float *, int));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        randomize_float(fsrc1, FLOAT_LEN, 1);
+        f0(fdst0, fsrc0, fsrc1, FLOAT_LEN);
+        f1(fdst1, fsrc0, fsrc1, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2(f0(fdst0, fsrc0, fsrc1, FLOAT_LEN), f1(fdst1, fsrc0, fsrc1, FLOAT_LEN));
+    return 0;
+}
+
+static int check_vector_fmul_add(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const float *, const float *, const float *, int));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        randomize_float(fsrc1, FLOAT_LEN, 1);
+        randomize_float(fsrc2, FLOAT_LEN, 1);
+        f0(fdst0, fsrc0, fsrc1, fsrc2, FLOAT_LEN);
+        f1(fdst1, fsrc0, fsrc1, fsrc2, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2(f0(fdst0, fsrc0, fsrc1, fsrc2, FLOAT_LEN),
+           f1(fdst1, fsrc0, fsrc1, fsrc2, FLOAT_LEN));
+    return 0;
+}
+
+static int check_vector_fmul_window(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const float *, const float *, const float *, float, int));
+    float bias;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        randomize_float(fsrc1, FLOAT_LEN, 1);
+        randomize_float(fsrc2, 2 * FLOAT_LEN, 1);
+        bias = n & 1 ? 385 : 0;
+        f0(fdst0, fsrc0, fsrc1, fsrc2, bias, FLOAT_LEN);
+        f1(fdst1, fsrc0, fsrc1, fsrc2, bias, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, 2 * FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2(f0(fdst0, fsrc0, fsrc1, fsrc2, 0, FLOAT_LEN),
+           f1(fdst1, fsrc0, fsrc1, fsrc2, 0, FLOAT_LEN));
+    return 0;
+}
+
+static int check_int32_to_float(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const int *, float, int));
+    float mul;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, FLOAT_LEN * sizeof(int));
+        mul = rnd_float();
+        f0(fdst0, (int *)src0, mul, FLOAT_LEN);
+        f1(fdst1, (int *)src0, mul, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2(f0(fdst0, (int *)src0, 0.5, FLOAT_LEN), f1(fdst1, (int *)src0, 0.5, FLOAT_LEN));
+    return 0;
+}
+
+static int check_vector_clipf(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const float *, float, float, int));
+    float min, max;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 2);
+        min = rnd_float();
+        max = min + fabsf(rnd_float());
+        f0(fdst0, fsrc0, min, max, FLOAT_LEN);
+        f1(fdst1, fsrc0, min, max, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2(f0(fdst0, fsrc0, -0.5, 0.5, FLOAT_LEN), f1(fdst1, fsrc0, -0.5, 0.5, FLOAT_LEN));
+    return 0;
+}
+
+static int check_vector_fmul_scalar(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, const float *, float, int));
+    float mul;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        mul = rnd_float();
+        f0(fdst0, fsrc0, mul, FLOAT_LEN);
+        f1(fdst1, fsrc0, mul, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2(f0(fdst0, fsrc0, 0.5, FLOAT_LEN), f1(fdst1, fsrc0, 0.5, FLOAT_LEN));
+    return 0;
+}
+
+/* vector_fmul_sv_scalar[i], sv_fmul_scalar[i]: sv points to vectors of
+ * 2 << i floats; w 1 if there is a src argument */
+static int check_sv_scalar(CHECK_ARGS)
+{
+    void (*f0)(float *, const float *, const float **, float, int) = (void *)fref;
+    void (*f1)(float *, const float *, const float **, float, int) = (void *)fnew;
+    void (*g0)(float *, const float **, float, int) = (void *)fref;
+    void (*g1)(float *, const float **, float, int) = (void *)fnew;
+    const float *sv[FLOAT_LEN / 2];
+    int n, k, vlen = 2 << i;
+    float mul;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        randomize_float(fsrc1, FLOAT_LEN, 1);
+        for (k = 0; k < FLOAT_LEN / vlen; k++)
+            sv[k] = fsrc1 + vlen * (rnd() % (FLOAT_LEN / vlen));
+        mul = rnd_float();
+        if (W) {
+            f0(fdst0, fsrc0, sv, mul, FLOAT_LEN);
+            f1(fdst1, fsrc0, sv, mul, FLOAT_LEN);
+        } else {
+            g0(fdst0, sv, mul, FLOAT_LEN);
+            g1(fdst1, sv, mul, FLOAT_LEN);
+        }
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    if (W)
+        BENCH2(f0(fdst0, fsrc0, sv, 0.5, FLOAT_LEN), f1(fdst1, fsrc0, sv, 0.5, FLOAT_LEN));
+    else
+        BENCH2(g0(fdst0, sv, 0.5, FLOAT_LEN), g1(fdst1, sv, 0.5, FLOAT_LEN));
+    return 0;
+}
+
+static int check_scalarproduct_float(CHECK_ARGS)
+{
+    DECL_FUNC(float, (const float *, const float *, int));
+    float r0, r1;
+    int len;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        len = 16 * (1 + rnd() % (FLOAT_LEN / 16));
+        randomize_float(fsrc0, len, 1);
+        randomize_float(fsrc1, len, 1);
+        r0 = f0(fsrc0, fsrc1, len);
+        r1 = f1(fsrc0, fsrc1, len);
+        emms_c();
+        /* the sum is taken in a different order */
+        if (fail_float(&r0, &r1, 1, 1e-5, len))
+            return 1;
+    }
+    BENCH2(f0(fsrc0, fsrc1, FLOAT_LEN), f1(fsrc0, fsrc1, FLOAT_LEN));
+    return 0;
+}
+
+static int check_butterflies_float(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, float *, int));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        randomize_float(fsrc1, FLOAT_LEN, 1);
+        memcpy(fdst0, fsrc0, FLOAT_LEN * sizeof(float));
+        memcpy(fdst1, fsrc0, FLOAT_LEN * sizeof(float));
+        memcpy(fsrc2, fsrc1, FLOAT_LEN * sizeof(float));
+        f0(fdst0, fsrc1, FLOAT_LEN);
+        f1(fdst1, fsrc2, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0) ||
+            fail_float(fsrc1, fsrc2, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    /* the magnitude doubles every two calls, start over each time */
+    BENCH2((memcpy(fdst0, fsrc0, FLOAT_LEN * sizeof(float)), f0(fdst0, fsrc1, FLOAT_LEN)),
+           (memcpy(fdst1, fsrc0, FLOAT_LEN * sizeof(float)), f1(fdst1, fsrc2, FLOAT_LEN)));
+    return 0;
+}
+
+static int check_vorbis_coupling(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float *, float *, int));
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fdst0, FLOAT_LEN, 1);
+        randomize_float(fsrc0, FLOAT_LEN, 1);
+        memcpy(fdst1, fdst0, FLOAT_LEN * sizeof(float));
+        memcpy(fsrc1, fsrc0, FLOAT_LEN * sizeof(float));
+        f0(fdst0, fsrc0, FLOAT_LEN);
+        f1(fdst1, fsrc1, FLOAT_LEN);
+        emms_c();
+        if (fail_float(fdst0, fdst1, FLOAT_LEN, 0, 0) ||
+            fail_float(fsrc0, fsrc1, FLOAT_LEN, 0, 0))
+            return 1;
+    }
+    BENCH2((memcpy(fdst0, fsrc2, FLOAT_LEN * sizeof(float)), f0(fdst0, fsrc0, FLOAT_LEN)),
+           (memcpy(fdst1, fsrc2, FLOAT_LEN * sizeof(float)), f1(fdst1, fsrc1, FLOAT_LEN)));
+    return 0;
+}
+
+static int check_ac3_downmix(CHECK_ARGS)
+{
+    DECL_FUNC(void, (float (*)[256], float (*)[2], int, int, int));
+    float (*s0)[256] = (float (*)[256])fdst0, (*s1)[256] = (float (*)[256])fdst1;
+    float matrix[6][2];
+    int in_ch, out_ch;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        /* the decoder only downmixes to fewer channels */
+        in_ch  = 2 + rnd() % 4;
+        out_ch = 1 + rnd() % FFMIN(2, in_ch - 1);
+        randomize_float(fdst0, 6 * 256, 1);
+        memcpy(fdst1, fdst0, 6 * 256 * sizeof(float));
+        randomize_float(&matrix[0][0], 12, 1);
+        f0(s0, matrix, out_ch, in_ch, 256);
+        f1(s1, matrix, out_ch, in_ch, 256);
+        emms_c();
+        if (fail_float(fdst0, fdst1, 6 * 256, 1e-6, in_ch))
+            return 1;
+    }
+    memcpy(fsrc0, fdst0, 6 * 256 * sizeof(float));
+    BENCH2((memcpy(fdst0, fsrc0, 6 * 256 * sizeof(float)), f0(s0, matrix, 2, 5, 256)),
+           (memcpy(fdst1, fsrc0, 6 * 256 * sizeof(float)), f1(s1, matrix, 2, 5, 256)));
+    return 0;
+}
+
+static int check_lpc_autocorr(CHECK_ARGS)
+{
+    DECL_FUNC(void, (const int32_t *, int, int, double *));
+    double a0[40], a1[40];
+    int32_t *data = (int32_t *)src0;
+    int len, lag, k;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        /* the SSE2 window is only correct for multiples of 4 */
+        len = 4 * (8 + rnd() % 128);
+        lag = 2 + rnd() % 32;
+        for (k = 0; k < len; k++)
+            data[k] = (int)(rnd() % 65536) - 32768;
+        f0(data, len, lag, a0);
+        f1(data, len, lag, a1);
+        emms_c();
+        for (k = 0; k <= lag; k++)
+            if (!(fabs(a0[k] - a1[k]) <= 1e-9 * (fabs(a0[0]) + 1))) {
+                printf("    mismatch at index %d: %.17g != %.17g\n", k, a0[k], a1[k]);
+                return 1;
+            }
+    }
+    BENCH2(f0(data, 512, 32, a0), f1(data, 512, 32, a1));
+    return 0;
+}
+
+#if CONFIG_H264DSP
+static int check_h264_weight(CHECK_ARGS)
+{
+    DECL(h264_weight_func);
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+    int log2_denom, weight, offset;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        log2_denom = rnd() & 7;
+        weight     = (int)(rnd() % 256) - 128;
+        offset     = (int)(rnd() % 256) - 128;
+        f0(d0, STRIDE, log2_denom, weight, offset);
+        f1(d1, STRIDE, log2_denom, weight, offset);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, STRIDE, 5, 40, 3), f1(d1, STRIDE, 5, 40, 3));
+    return 0;
+}
+
+static int check_h264_biweight(CHECK_ARGS)
+{
+    DECL(h264_biweight_func);
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+    uint8_t *src = src0 + 8 * STRIDE + 16;
+    int log2_denom, weightd, weights, offset;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize(src0, BUF_SIZE);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        /* the MMX version saturates the sum at 16 bits, which only
+         * changes the result for log2_denom 7 */
+        log2_denom = rnd() % 7;
+        weightd    = (int)(rnd() % 129) - 64;
+        weights    = (int)(rnd() % 129) - 64;
+        offset     = (int)(rnd() % 256) - 128;
+        f0(d0, src, STRIDE, log2_denom, weightd, weights, offset);
+        f1(d1, src, STRIDE, log2_denom, weightd, weights, offset);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, src, STRIDE, 5, 32, 32, 0), f1(d1, src, STRIDE, 5, 32, 32, 0));
+    return 0;
+}
+
+/**
+ * w 0 for the intra filters, 1 for luma and 2 for chroma with tc0.
+ * The ranges are those of the tables in h264_loopfilter.c, which does
+ * not call the filters if alpha or beta is 0.
+ */
+static int check_h264_loop_filter(CHECK_ARGS)
+{
+    void (*f0)(uint8_t *, int, int, int, int8_t *) = (void *)fref;
+    void (*f1)(uint8_t *, int, int, int, int8_t *) = (void *)fnew;
+    void (*g0)(uint8_t *, int, int, int) = (void *)fref;
+    void (*g1)(uint8_t *, int, int, int) = (void *)fnew;
+    uint8_t *d0 = dst0 + 16 * STRIDE + 16, *d1 = dst1 + 16 * STRIDE + 16;
+    int8_t tc0[4];
+    int n, k, alpha, beta;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_smooth(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        alpha = 1 + rnd() % 255;
+        beta  = 1 + rnd() % 18;
+        for (k = 0; k < 4; k++)
+            tc0[k] = (int)(rnd() % 27) - (W == 1);
+        if (W) {
+            f0(d0, STRIDE, alpha, beta, tc0);
+            f1(d1, STRIDE, alpha, beta, tc0);
+        } else {
+            g0(d0, STRIDE, alpha, beta);
+            g1(d1, STRIDE, alpha, beta);
+        }
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    if (W)
+        BENCH2(f0(d0, STRIDE, 40, 10, tc0), f1(d1, STRIDE, 40, 10, tc0));
+    else
+        BENCH2(g0(d0, STRIDE, 40, 10), g1(d1, STRIDE, 40, 10));
+    return 0;
+}
+
+/* The decoder transposes the coefficients if the 4x4 or 8x8 IDCT is not
+ * the C version, see init_scan_tables() in h264.c. */
+static void h264_transpose(DCTELEM *blk, int nb_blocks, int idct8)
+{
+    DCTELEM tmp[16];
+    int b, k;
+
+    for (b = 0; b < nb_blocks; b++) {
+        DCTELEM *s = blk + b * 16;
+        if (idct8) {
+            if (!(b & 3))
+                transpose8x8(s);
+        } else {
+            for (k = 0; k < 16; k++)
+                tmp[(k >> 2) | ((k << 2) & 0xF)] = s[k];
+            memcpy(s, tmp, 16 * sizeof(*s));
+        }
+    }
+}
+
+static int h264_transposed(Impl *m, int idct8)
+{
+    return idct8 ? m->h264.h264_idct8_add != ff_h264_idct8_add_c :
+                   m->h264.h264_idct_add  != ff_h264_idct_add_c;
+}
+
+/* single block IDCTs; w 1 for 8x8, h 1 for DC only */
+static int check_h264_idct(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, DCTELEM *, int));
+    uint8_t *d0 = dst0 + 8 * STRIDE + 16, *d1 = dst1 + 8 * STRIDE + 16;
+    int idct8 = t->w[0], dc = t->h[0];
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        if (dc) {
+            memset(blk0, 0, 64 * sizeof(DCTELEM));
+            blk0[0] = (int)(rnd() % 8192) - 4096;
+        } else
+            randomize_coeffs(blk0, 64, idct8 ? 64 : 128);
+        memcpy(blk1, blk0, 64 * sizeof(DCTELEM));
+        if (h264_transposed(new, idct8))
+            h264_transpose(blk1, 1, idct8);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        f0(d0, blk0, STRIDE);
+        f1(d1, blk1, STRIDE);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, blk0, STRIDE), f1(d1, blk1, STRIDE));
+    return 0;
+}
+
+/* same as in h264.h */
+static const uint8_t scan8[16 + 2 * 4] = {
+    4 + 1 * 8, 5 + 1 * 8, 4 + 2 * 8, 5 + 2 * 8,
+    6 + 1 * 8, 7 + 1 * 8, 6 + 2 * 8, 7 + 2 * 8,
+    4 + 3 * 8, 5 + 3 * 8, 4 + 4 * 8, 5 + 4 * 8,
+    6 + 3 * 8, 7 + 3 * 8, 6 + 4 * 8, 7 + 4 * 8,
+    1 + 1 * 8, 2 + 1 * 8,
+    1 + 2 * 8, 2 + 2 * 8,
+    1 + 4 * 8, 2 + 4 * 8,
+    1 + 5 * 8, 2 + 5 * 8,
+};
+
+/**
+ * idct_add16, idct_add16intra (h 1), idct8_add4 (w 1) and idct_add8 (w 2, h 1).
+ * The non zero counts are set like the decoder does, the DC is not counted
+ * for intra 16x16 and chroma blocks as it is coded separately.
+ */
+static int check_h264_idct_multi(CHECK_ARGS)
+{
+    void (*f0)(uint8_t *, const int *, DCTELEM *, int, const uint8_t *) = (void *)fref;
+    void (*f1)(uint8_t *, const int *, DCTELEM *, int, const uint8_t *) = (void *)fnew;
+    void (*g0)(uint8_t **, const int *, DCTELEM *, int, const uint8_t *) = (void *)fref;
+    void (*g1)(uint8_t **, const int *, DCTELEM *, int, const uint8_t *) = (void *)fnew;
+    uint8_t *d0[2] = { dst0 + 4 * STRIDE + 16, dst0 + 24 * STRIDE + 16 };
+    uint8_t *d1[2] = { dst1 + 4 * STRIDE + 16, dst1 + 24 * STRIDE + 16 };
+    uint8_t nnzc[6 * 8];
+    int block_offset[24];
+    int n, k, l, idct8 = t->w[0] == 1, chroma = t->w[0] == 2, no_dc = t->h[0];
+    int first = chroma ? 16 : 0, last = chroma ? 24 : 16;
+    int size  = idct8 ? 64 : 16;
+
+    for (k = 0; k < 16; k++)
+        block_offset[k] = 4 * ((scan8[k] - scan8[0]) & 7) + 4 * STRIDE * ((scan8[k] - scan8[0]) >> 3);
+    for (k = 16; k < 24; k++)
+        block_offset[k] = block_offset[k & 3];
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        memset(nnzc, 0, sizeof(nnzc));
+        for (k = first; k < last; k += idct8 ? 4 : 1) {
+            int type = rnd() % 3, nnz = 0;
+            DCTELEM *b = blk0 + 16 * k;
+            memset(b, 0, size * sizeof(DCTELEM));
+            if (type == 1)
+                b[0] = (int)(rnd() % 8192) - 4096;
+            else if (type == 2)
+                randomize_coeffs(b, size, idct8 ? 64 : 128);
+            for (l = no_dc; l < size; l++)
+                nnz += !!b[l];
+            nnzc[scan8[k]] = nnz;
+            if (idct8)
+                nnzc[scan8[k + 1]] = nnzc[scan8[k + 2]] = nnzc[scan8[k + 3]] = nnz;
+        }
+        memcpy(blk1, blk0, 24 * 16 * sizeof(DCTELEM));
+        memcpy(blk2, blk0, 24 * 16 * sizeof(DCTELEM));
+        if (h264_transposed(new, idct8))
+            h264_transpose(blk1, 24, idct8);
+        randomize(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        if (chroma) {
+            g0(d0, block_offset, blk0, STRIDE, nnzc);
+            g1(d1, block_offset, blk1, STRIDE, nnzc);
+        } else {
+            f0(d0[0], block_offset, blk0, STRIDE, nnzc);
+            f1(d1[0], block_offset, blk1, STRIDE, nnzc);
+        }
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    /* the blocks may be modified, all calls use the last input */
+    if (chroma)
+        BENCH2((memcpy(blk0, blk2, 24 * 16 * sizeof(DCTELEM)), g0(d0, block_offset, blk0, STRIDE, nnzc)),
+               (memcpy(blk0, blk1, 24 * 16 * sizeof(DCTELEM)), g1(d1, block_offset, blk0, STRIDE, nnzc)));
+    else
+        BENCH2((memcpy(blk0, blk2, 24 * 16 * sizeof(DCTELEM)), f0(d0[0], block_offset, blk0, STRIDE, nnzc)),
+               (memcpy(blk0, blk1, 24 * 16 * sizeof(DCTELEM)), f1(d1[0], block_offset, blk0, STRIDE, nnzc)));
+    return 0;
+}
+#endif /* CONFIG_H264DSP */
+
+static int check_vp56_edge_filter(CHECK_ARGS)
+{
+    DECL_FUNC(void, (uint8_t *, int, int));
+    uint8_t *d0 = dst0 + 16 * STRIDE + 16, *d1 = dst1 + 16 * STRIDE + 16;
+    int th;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_smooth(dst0, BUF_SIZE);
+        memcpy(dst1, dst0, BUF_SIZE);
+        th = 1 + rnd() % 32;
+        f0(d0, STRIDE, th);
+        f1(d1, STRIDE, th);
+        emms_c();
+        if (fail_u8(dst0, dst1, BUF_SIZE))
+            return 1;
+    }
+    BENCH2(f0(d0, STRIDE, 8), f1(d1, STRIDE, 8));
+    return 0;
+}
+
+#if CONFIG_FFT
+/* fft_permute followed by fft_calc; w is the index in fft_sizes */
+static int check_fft(CHECK_ARGS)
+{
+    FFTContext *s0 = &ref->fft[W], *s1 = &new->fft[W];
+    FFTComplex *z0 = (FFTComplex *)fdst0, *z1 = (FFTComplex *)fdst1;
+    int n, len = 1 << s0->nbits;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, 2 * len, 1);
+        memcpy(z0, fsrc0, len * sizeof(*z0));
+        memcpy(z1, fsrc0, len * sizeof(*z1));
+        s0->fft_permute(s0, z0);
+        s0->fft_calc(s0, z0);
+        s1->fft_permute(s1, z1);
+        s1->fft_calc(s1, z1);
+        emms_c();
+        if (fail_float(fdst0, fdst1, 2 * len, 1e-5, max_abs(fdst0, 2 * len)))
+            return 1;
+    }
+    /* the transform is done in place, so the input is restored each call */
+    BENCH2((memcpy(z0, fsrc0, len * sizeof(*z0)), s0->fft_permute(s0, z0), s0->fft_calc(s0, z0)),
+           (memcpy(z1, fsrc0, len * sizeof(*z1)), s1->fft_permute(s1, z1), s1->fft_calc(s1, z1)));
+    return 0;
+}
+#endif
+
+#if CONFIG_MDCT
+/* imdct_calc, imdct_half (h 1) and mdct_calc (h 2); w is the index in mdct_sizes */
+static int check_mdct(CHECK_ARGS)
+{
+    FFTContext *s0 = &ref->mdct[W], *s1 = &new->mdct[W];
+    void (*f0)(FFTContext *, FFTSample *, const FFTSample *) = (void *)fref;
+    void (*f1)(FFTContext *, FFTSample *, const FFTSample *) = (void *)fnew;
+    int n, len = 1 << s0->mdct_bits;
+    int in_len  = t->h[0] == 2 ? len : len / 2;
+    int out_len = t->h[0] == 0 ? len : len / 2;
+
+    for (n = 0; n < NB_CHECKS; n++) {
+        randomize_float(fsrc0, in_len, 1);
+        f0(s0, fdst0, fsrc0);
+        f1(s1, fdst1, fsrc0);
+        emms_c();
+        if (fail_float(fdst0, fdst1, out_len, 1e-5, max_abs(fdst0, out_len)))
+            return 1;
+    }
+    BENCH2(f0(s0, fdst0, fsrc0), f1(s1, fdst1, fsrc0));
+    return 0;
+}
+#endif
+
+/* start codes at random offsets, some of them at the end of the buffer,
+ * in data with many zeros */
+static int check_start_code(CHECK_ARGS)
+{
+    DECL_FUNC(const uint8_t *, (const uint8_t *, const uint8_t *));
+    const uint8_t *p, *end;
+    int k, len;
+
+    for (n = 0; n < NB_CHECKS * 8; n++) {
+        len = rnd() % 1024;
+        for (k = 0; k < len + 16; k++)
+            src0[k] = rnd() % 3 ? rnd() : 0;
+        for (k = rnd() % 4; k > 0 && len >= 3; k--) {
+            int pos = rnd() & 1 ? len - 3 - rnd() % FFMIN(len - 2, 40) : rnd() % (len - 2);
+            src0[pos] = src0[pos + 1] = 0;
+            src0[pos + 2] = 1;
+        }
+        p   = src0 + rnd() % 16;
+        end = src0 + FFMAX(len, p - src0);
+        if (fail_int(f0(p, end) - src0, f1(p, end) - src0))
+            return 1;
+    }
+    memset(src0, 0x80, BUF_SIZE);
+    BENCH2(f0(src0, src0 + BUF_SIZE), f1(src0, src0 + BUF_SIZE));
+    return 0;
+}
+
+#define DSP(name, n1, n2, check, ...) \
+    { #name, CTX_DSP,  offsetof(DSPContext,     name), n1, n2, check, __VA_ARGS__ }
+#define H264(name, n1, n2, check, ...) \
+    { #name, CTX_H264, offsetof(H264DSPContext, name), n1, n2, check, __VA_ARGS__ }
+#define VP56(codec, ctx, name, check) \
+    { codec " " #name, ctx, offsetof(VP56DSPContext, name), 1, 1, check, { 0 } }
+
+#define BLOCK_SIZES   { 16,  8,  4,  2 }
+#define QPEL_SIZES    { 16,  8,  4,  2 }
+#define CHROMA_SIZES  {  8,  4,  2 }
+#define CMP_SIZES     { 16,  8,  4,  2, 16, 8 }
+
+static const DSPTest tests[] = {
+    DSP(get_pixels,                   1,  1, check_get_pixels,        { 0 }),
+    DSP(diff_pixels,                  1,  1, check_diff_pixels,       { 0 }),
+    DSP(put_pixels_clamped,           1,  1, check_put_block,         { 512 }),
+    DSP(put_signed_pixels_clamped,    1,  1, check_put_block,         { 512 }),
+    DSP(put_pixels_nonclamped,        1,  1, check_put_block,         { 128 }),
+    DSP(add_pixels_clamped,           1,  1, check_put_block,         { 512 }),
+    DSP(add_pixels8,                  1,  1, check_add_pixels,        { 8 }),
+    DSP(add_pixels4,                  1,  1, check_add_pixels,        { 4 }),
+    DSP(sum_abs_dctelem,              1,  1, check_sum_abs,           { 0 }),
+    DSP(gmc1,                         1,  1, check_gmc1,              { 8 }),
+    DSP(clear_block,                  1,  1, check_clear,             { 1 }),
+    DSP(clear_blocks,                 1,  1, check_clear,             { 6 }),
+    DSP(pix_sum,                      1,  1, check_pix_sum,           { 16 }),
+    DSP(pix_norm1,                    1,  1, check_pix_sum,           { 16 }),
+    DSP(sad,                          6,  1, check_cmp,               CMP_SIZES),
+    DSP(sse,                          6,  1, check_cmp,               CMP_SIZES),
+    DSP(hadamard8_diff,               6,  1, check_cmp,               CMP_SIZES),
+    DSP(vsad,                         6,  1, check_cmp,               CMP_SIZES),
+    DSP(vsse,                         6,  1, check_cmp,               CMP_SIZES),
+    DSP(pix_abs,                      2,  4, check_cmp,               { 16, 8 }),
+    DSP(ssd_int8_vs_int16,            1,  1, check_ssd_int8,          { 0 }),
+    DSP(put_pixels_tab,               4,  4, check_pixels,            BLOCK_SIZES),
+    DSP(avg_pixels_tab,               4,  4, check_pixels,            BLOCK_SIZES),
+    DSP(put_no_rnd_pixels_tab,        4,  4, check_pixels,            BLOCK_SIZES),
+    DSP(avg_no_rnd_pixels_tab,        4,  4, check_pixels,            BLOCK_SIZES),
+    DSP(put_no_rnd_pixels_l2,         2,  1, check_pixels_l2,         { 16, 8 }),
+    DSP(put_qpel_pixels_tab,          2, 16, check_qpel,              { 16, 8 }),
+    DSP(avg_qpel_pixels_tab,          2, 16, check_qpel,              { 16, 8 }),
+    DSP(put_no_rnd_qpel_pixels_tab,   2, 16, check_qpel,              { 16, 8 }),
+    DSP(avg_no_rnd_qpel_pixels_tab,   2, 16, check_qpel,              { 16, 8 }),
+    DSP(put_mspel_pixels_tab,         8,  1, check_qpel,              { 8, 8, 8, 8, 8, 8, 8, 8 }),
+    DSP(put_h264_chroma_pixels_tab,   3,  1, check_chroma,            CHROMA_SIZES),
+    DSP(avg_h264_chroma_pixels_tab,   3,  1, check_chroma,            CHROMA_SIZES),
+    DSP(put_no_rnd_vc1_chroma_pixels_tab, 3, 1, check_chroma,         CHROMA_SIZES),
+    DSP(avg_no_rnd_vc1_chroma_pixels_tab, 3, 1, check_chroma,         CHROMA_SIZES),
+    DSP(put_h264_qpel_pixels_tab,     4, 16, check_qpel,              QPEL_SIZES),
+    DSP(avg_h264_qpel_pixels_tab,     4, 16, check_qpel,              QPEL_SIZES),
+    DSP(put_cavs_qpel_pixels_tab,     2, 16, check_cavs_qpel,         { 16, 8 }),
+    DSP(avg_cavs_qpel_pixels_tab,     2, 16, check_cavs_qpel,         { 16, 8 }),
+    DSP(cavs_idct8_add,               1,  1, check_idct_add,          { 128 }, { 1 }),
+    DSP(add_bytes,                    1,  1, check_bytes,             { 0 }),
+    DSP(add_bytes_l2,                 1,  1, check_bytes,             { 1 }),
+    DSP(diff_bytes,                   1,  1, check_bytes,             { 1 }),
+    DSP(sub_hfyu_median_prediction,   1,  1, check_hfyu_median,       { 0 }),
+    DSP(add_hfyu_median_prediction,   1,  1, check_hfyu_median,       { 0 }),
+    DSP(add_hfyu_left_prediction,     1,  1, check_hfyu_left,         { 0 }),
+    DSP(add_hfyu_left_prediction_bgr32, 1, 1, check_hfyu_left_bgr32,  { 0 }),
+    DSP(add_png_paeth_prediction,     1,  1, check_png_paeth,         { 0 }),
+    DSP(bswap_buf,                    1,  1, check_bswap_buf,         { 0 }),
+    DSP(h263_v_loop_filter,           1,  1, check_filter,            { 31 }),
+    DSP(h263_h_loop_filter,           1,  1, check_filter,            { 31 }),
+    DSP(x8_v_loop_filter,             1,  1, check_filter,            { 31 }),
+    DSP(x8_h_loop_filter,             1,  1, check_filter,            { 31 }),
+    DSP(vp3_idct_dc_add,              1,  1, check_trans_add,         { 2048 }),
+    DSP(vp3_v_loop_filter,            1,  1, check_vp3_filter,        { 0 }),
+    DSP(vp3_h_loop_filter,            1,  1, check_vp3_filter,        { 0 }),
+    DSP(vp6_filter_diag4,             1,  1, check_vp6_diag4,         { 0 }),
+    DSP(vorbis_inverse_coupling,      1,  1, check_vorbis_coupling,   { 0 }),
+    DSP(ac3_downmix,                  1,  1, check_ac3_downmix,       { 0 }),
+    DSP(lpc_compute_autocorr,         1,  1, check_lpc_autocorr,      { 0 }),
+    DSP(vector_fmul,                  1,  1, check_vector_fmul,       { 0 }),
+    DSP(vector_fmul_reverse,          1,  1, check_vector_fmul_reverse, { 0 }),
+    DSP(vector_fmul_add,              1,  1, check_vector_fmul_add,   { 0 }),
+    DSP(vector_fmul_window,           1,  1, check_vector_fmul_window, { 0 }),
+    DSP(int32_to_float_fmul_scalar,   1,  1, check_int32_to_float,    { 0 }),
+    DSP(vector_clipf,                 1,  1, check_vector_clipf,      { 0 }),
+    DSP(vector_fmul_scalar,           1,  1, check_vector_fmul_scalar, { 0 }),
+    DSP(vector_fmul_sv_scalar,        2,  1, check_sv_scalar,         { 1, 1 }),
+    DSP(sv_fmul_scalar,               2,  1, check_sv_scalar,         { 0, 0 }),
+    DSP(scalarproduct_float,          1,  1, check_scalarproduct_float, { 0 }),
+    DSP(butterflies_float,            1,  1, check_butterflies_float, { 0 }),
+    DSP(try_8x8basis,                 1,  1, check_8x8basis,          { 0 }),
+    DSP(add_8x8basis,                 1,  1, check_add_8x8basis,      { 0 }),
+    DSP(draw_edges,                   1,  1, check_draw_edges,        { 16 }),
+    DSP(vc1_inv_trans_8x8,            1,  1, check_trans_inplace,     { 256 }),
+    DSP(vc1_inv_trans_8x4,            1,  1, check_trans_add,         { 256 }),
+    DSP(vc1_inv_trans_4x8,            1,  1, check_trans_add,         { 256 }),
+    DSP(vc1_inv_trans_4x4,            1,  1, check_trans_add,         { 256 }),
+    DSP(vc1_inv_trans_8x8_dc,         1,  1, check_trans_add,         { 2048 }),
+    DSP(vc1_inv_trans_8x4_dc,         1,  1, check_trans_add,         { 2048 }),
+    DSP(vc1_inv_trans_4x8_dc,         1,  1, check_trans_add,         { 2048 }),
+    DSP(vc1_inv_trans_4x4_dc,         1,  1, check_trans_add,         { 2048 }),
+    DSP(vc1_v_overlap,                1,  1, check_filter,            { 0 }),
+    DSP(vc1_h_overlap,                1,  1, check_filter,            { 0 }),
+    DSP(vc1_v_loop_filter4,           1,  1, check_filter,            { 31 }),
+    DSP(vc1_h_loop_filter4,           1,  1, check_filter,            { 31 }),
+    DSP(vc1_v_loop_filter8,           1,  1, check_filter,            { 31 }),
+    DSP(vc1_h_loop_filter8,           1,  1, check_filter,            { 31 }),
+    DSP(vc1_v_loop_filter16,          1,  1, check_filter,            { 31 }),
+    DSP(vc1_h_loop_filter16,          1,  1, check_filter,            { 31 }),
+    DSP(put_vc1_mspel_pixels_tab,    16,  1, check_vc1_mspel,         { 0 }),
+    DSP(avg_vc1_mspel_pixels_tab,    16,  1, check_vc1_mspel,         { 0 }),
+    DSP(scalarproduct_int16,          1,  1, check_scalarproduct_int16, { 0 }),
+    DSP(scalarproduct_and_madd_int16, 1,  1, check_scalarproduct_madd, { 0 }),
+    DSP(put_rv30_tpel_pixels_tab,     4, 16, check_qpel,              QPEL_SIZES),
+    DSP(avg_rv30_tpel_pixels_tab,     4, 16, check_qpel,              QPEL_SIZES),
+    DSP(put_rv40_qpel_pixels_tab,     4, 16, check_qpel,              QPEL_SIZES),
+    DSP(avg_rv40_qpel_pixels_tab,     4, 16, check_qpel,              QPEL_SIZES),
+    DSP(put_rv40_chroma_pixels_tab,   3,  1, check_chroma,            CHROMA_SIZES),
+    DSP(avg_rv40_chroma_pixels_tab,   3,  1, check_chroma,            CHROMA_SIZES),
+    DSP(fill_block_tab,               2,  1, check_fill_block,        { 16, 8 }),
+    DSP(scale_block,                  1,  1, check_scale_block,       { 0 }),
+#if CONFIG_H264DSP
+    H264(weight_h264_pixels_tab,     10,  1, check_h264_weight,
+         { 16, 16, 8, 8, 8, 4, 4, 4, 2, 2 }, { 16, 8, 16, 8, 4, 8, 4, 2, 4, 2 }),
+    H264(biweight_h264_pixels_tab,   10,  1, check_h264_biweight,
+         { 16, 16, 8, 8, 8, 4, 4, 4, 2, 2 }, { 16, 8, 16, 8, 4, 8, 4, 2, 4, 2 }),
+    H264(h264_v_loop_filter_luma,     1,  1, check_h264_loop_filter,  { 1 }),
+    H264(h264_h_loop_filter_luma,     1,  1, check_h264_loop_filter,  { 1 }),
+    H264(h264_v_loop_filter_luma_intra,   1, 1, check_h264_loop_filter, { 0 }),
+    H264(h264_h_loop_filter_luma_intra,   1, 1, check_h264_loop_filter, { 0 }),
+    H264(h264_v_loop_filter_chroma,   1,  1, check_h264_loop_filter,  { 2 }),
+    H264(h264_h_loop_filter_chroma,   1,  1, check_h264_loop_filter,  { 2 }),
+    H264(h264_v_loop_filter_chroma_intra, 1, 1, check_h264_loop_filter, { 0 }),
+    H264(h264_h_loop_filter_chroma_intra, 1, 1, check_h264_loop_filter, { 0 }),
+    H264(h264_idct_add,               1,  1, check_h264_idct,         { 0 }, { 0 }),
+    H264(h264_idct8_add,              1,  1, check_h264_idct,         { 1 }, { 0 }),
+    H264(h264_idct_dc_add,            1,  1, check_h264_idct,         { 0 }, { 1 }),
+    H264(h264_idct8_dc_add,           1,  1, check_h264_idct,         { 1 }, { 1 }),
+    H264(h264_idct_add16,             1,  1, check_h264_idct_multi,   { 0 }, { 0 }),
+    H264(h264_idct_add16intra,        1,  1, check_h264_idct_multi,   { 0 }, { 1 }),
+    H264(h264_idct8_add4,             1,  1, check_h264_idct_multi,   { 1 }, { 0 }),
+    H264(h264_idct_add8,              1,  1, check_h264_idct_multi,   { 2 }, { 1 }),
+#endif
+    VP56("vp5", CTX_VP5, edge_filter_hor, check_vp56_edge_filter),
+    VP56("vp5", CTX_VP5, edge_filter_ver, check_vp56_edge_filter),
+    VP56("vp6", CTX_VP6, edge_filter_hor, check_vp56_edge_filter),
+    VP56("vp6", CTX_VP6, edge_filter_ver, check_vp56_edge_filter),
+#if CONFIG_FFT
+    { "fft_calc 16",      CTX_FFT,  offsetof(FFTContext, fft_calc),   1, 1, check_fft,  { 0 } },
+    { "fft_calc 64",      CTX_FFT,  offsetof(FFTContext, fft_calc),   1, 1, check_fft,  { 1 } },
+    { "fft_calc 256",     CTX_FFT,  offsetof(FFTContext, fft_calc),   1, 1, check_fft,  { 2 } },
+    { "fft_calc 1024",    CTX_FFT,  offsetof(FFTContext, fft_calc),   1, 1, check_fft,  { 3 } },
+    { "fft_calc 256 inv", CTX_FFT,  offsetof(FFTContext, fft_calc),   1, 1, check_fft,  { 4 } },
+#endif
+#if CONFIG_MDCT
+    { "imdct_calc 64",    CTX_MDCT, offsetof(FFTContext, imdct_calc), 1, 1, check_mdct, { 0 }, { 0 } },
+    { "imdct_calc 256",   CTX_MDCT, offsetof(FFTContext, imdct_calc), 1, 1, check_mdct, { 1 }, { 0 } },
+    { "imdct_calc 2048",  CTX_MDCT, offsetof(FFTContext, imdct_calc), 1, 1, check_mdct, { 2 }, { 0 } },
+    { "imdct_half 64",    CTX_MDCT, offsetof(FFTContext, imdct_half), 1, 1, check_mdct, { 0 }, { 1 } },
+    { "imdct_half 256",   CTX_MDCT, offsetof(FFTContext, imdct_half), 1, 1, check_mdct, { 1 }, { 1 } },
+    { "imdct_half 2048",  CTX_MDCT, offsetof(FFTContext, imdct_half), 1, 1, check_mdct, { 2 }, { 1 } },
+    { "mdct_calc 256",    CTX_MDCT, offsetof(FFTContext, mdct_calc),  1, 1, check_mdct, { 3 }, { 2 } },
+#endif
+    { "find_start_code_prefix", CTX_STARTCODE, 0, 1, 1, check_start_code, { 0 } },
+};
+
+static void init_impl(Impl *m, AVCodecContext *avctx, const char *name, int flags)
+{
+    int k;
+
+    av_set_cpu_flags_mask(flags);
+    m->name  = name;
+    m->flags = flags;
+    dsputil_init(&m->dsp, avctx);
+#if CONFIG_H264DSP
+    ff_h264dsp_init(&m->h264);
+#endif
+#if CONFIG_VP5_DECODER || CONFIG_VP6_DECODER
+    ff_vp56dsp_init(&m->vp5, CODEC_ID_VP5);
+    ff_vp56dsp_init(&m->vp6, CODEC_ID_VP6);
+#endif
+#if CONFIG_FFT
+    for (k = 0; k < FF_ARRAY_ELEMS(fft_sizes); k++)
+        ff_fft_init(&m->fft[k], fft_sizes[k].nbits, fft_sizes[k].inverse);
+#endif
+#if CONFIG_MDCT
+    for (k = 0; k < FF_ARRAY_ELEMS(mdct_sizes); k++)
+        ff_mdct_init(&m->mdct[k], mdct_sizes[k].nbits, mdct_sizes[k].inverse, 1.0);
+#endif
+    ff_startcode_init();
+    m->find_start_code_prefix = ff_find_start_code_prefix;
+    av_set_cpu_flags_mask(-1);
+    ff_startcode_init();
+}
+
+static void free_impl(Impl *m)
+{
+    int k;
+
+#if CONFIG_FFT
+    for (k = 0; k < FF_ARRAY_ELEMS(fft_sizes); k++)
+        ff_fft_end(&m->fft[k]);
+#endif
+#if CONFIG_MDCT
+    for (k = 0; k < FF_ARRAY_ELEMS(mdct_sizes); k++)
+        ff_mdct_end(&m->mdct[k]);
+#endif
+}
+
+static dsp_func get_func(Impl *m, const DSPTest *t, int i, int j)
+{
+    uint8_t *ctx = NULL;
+
+    switch (t->ctx) {
+    case CTX_DSP:  ctx = (uint8_t *)&m->dsp;          break;
+    case CTX_H264: ctx = (uint8_t *)&m->h264;         break;
+    case CTX_VP5:  ctx = (uint8_t *)&m->vp5;          break;
+    case CTX_VP6:  ctx = (uint8_t *)&m->vp6;          break;
+    case CTX_FFT:  ctx = (uint8_t *)&m->fft[t->w[0]]; break;
+    case CTX_MDCT: ctx = (uint8_t *)&m->mdct[t->w[0]]; break;
+    case CTX_STARTCODE: ctx = (uint8_t *)&m->find_start_code_prefix; break;
+    }
+    return ((dsp_func *)(ctx + t->offset))[i * t->n2 + j];
+}
+
+static void help(void)
+{
+    printf("dsp-test [-h] [-n] [-s seed] [pattern]\n"
+           "check the SIMD versions of the DSP functions against the C versions\n"
+           "-n         do not benchmark\n"
+           "-s seed    seed for the random input\n"
+           "pattern    only test functions whose name contains pattern\n");
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    AVCodecContext *avctx;
+    const char *pattern = NULL;
+    unsigned seed = 0;
+    int cpu_flags, flags = 0, prev_flags = -1;
+    int c, k, i, j, nb_tested = 0, nb_failed = 0;
+
+    for (;;) {
+        c = getopt(argc, argv, "hns:");
+        if (c == -1)
+            break;
+        switch (c) {
+        case 'n':
+            bench = 0;
+            break;
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            help();
+        }
+    }
+    if (optind < argc)
+        pattern = argv[optind];
+#ifndef AV_READ_TIME
+    bench = 0;
+#endif
+
+    avcodec_init();
+    avctx = avcodec_alloc_context();
+    /* the versions selected without it are approximations by design */
+    avctx->flags |= CODEC_FLAG_BITEXACT;
+    cpu_flags = av_get_cpu_flags();
+
+    /* each set adds one extension to the previous ones,
+     * sets which add nothing on this CPU are skipped */
+    for (k = 0; k < NB_FLAG_SETS; k++) {
+        flags |= cpu_flag_sets[k].flags & cpu_flags;
+        if (flags == prev_flags)
+            continue;
+        init_impl(&impls[nb_impls++], avctx, cpu_flag_sets[k].name, flags);
+        prev_flags = flags;
+    }
+
+    printf("%-38s %-9s %-7s", "function", "cpu", "result");
+    if (bench)
+        printf(" %9s %9s %8s", "c cycles", "cycles", "speedup");
+    printf("\n");
+
+    for (k = 0; k < FF_ARRAY_ELEMS(tests); k++) {
+        const DSPTest *t = &tests[k];
+
+        if (pattern && !strstr(t->name, pattern))
+            continue;
+        for (i = 0; i < t->n1; i++)
+            for (j = 0; j < t->n2; j++) {
+                dsp_func fref = get_func(&impls[0], t, i, j);
+                int m;
+
+                if (!fref)
+                    continue;
+                for (m = 1; m < nb_impls; m++) {
+                    dsp_func fnew = get_func(&impls[m], t, i, j);
+                    char name[64];
+                    int l, ret;
+
+                    if (!fnew || fnew == fref)
+                        continue;
+                    for (l = 1; l < m; l++)
+                        if (get_func(&impls[l], t, i, j) == fnew)
+                            break;
+                    if (l < m)
+                        continue;
+
+                    if (t->n2 > 1)
+                        snprintf(name, sizeof(name), "%s[%d][%d]", t->name, i, j);
+                    else if (t->n1 > 1)
+                        snprintf(name, sizeof(name), "%s[%d]", t->name, i);
+                    else
+                        snprintf(name, sizeof(name), "%s", t->name);
+
+                    av_lfg_init(&lfg, seed);
+                    cycles_ref = cycles_new = 0;
+                    ret = t->check(t, i, j, &impls[0], &impls[m], fref, fnew);
+                    emms_c();
+                    nb_tested++;
+                    nb_failed += !!ret;
+
+                    printf("%-38s %-9s %-7s", name, impls[m].name, ret ? "FAILED" : "ok");
+                    if (bench && !ret)
+                        printf(" %9.1f %9.1f %7.2fx", cycles_ref, cycles_new,
+                               cycles_ref / FFMAX(cycles_new, 0.1));
+                    printf("\n");
+                }
+            }
+    }
+
+    printf("%d implementations tested, %d failed\n", nb_tested, nb_failed);
+
+    for (k = 0; k < nb_impls; k++)
+        free_impl(&impls[k]);
+    av_free(avctx);
+
+    return !!nb_failed;
+}
@@ -28,6 +28,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "libavutil/bswap.h"
 #include "libavutil/common.h"
@@ -35,7 +36,13 @@
 #include "libavutil/log.h"
 #include "mathops.h"
 
-#if defined(ALT_BITSTREAM_READER_LE) && !defined(ALT_BITSTREAM_READER)
+/* the cached reader needs cheap 64-bit loads and shifts and only handles
+ * big-endian streams, fall back to the default reader everywhere else */
+#if defined(CACHED_BITSTREAM_READER) && (!HAVE_FAST_64BIT || !HAVE_FAST_UNALIGNED || defined(ALT_BITSTREAM_READER_LE))
+#   undef CACHED_BITSTREAM_READER
+#endif
+
+#if (defined(ALT_BITSTREAM_READER_LE) || defined(CACHED_BITSTREAM_READER)) && !defined(ALT_BITSTREAM_READER)
 #   define ALT_BITSTREAM_READER
 #endif
 
@@ -55,6 +62,8 @@ typedef struct GetBitContext {
     const uint8_t *buffer, *buffer_end;
 #ifdef ALT_BITSTREAM_READER
     int index;
+    uint64_t cache;     ///< 64 bits read at bit position cache_pos, only used by CACHED_BITSTREAM_READER
+    unsigned cache_pos;
 #elif defined LIBMPEG2_BITSTREAM_READER
     uint8_t *buffer_ptr;
     uint32_t cache;
@@ -82,6 +91,18 @@ typedef struct RL_VLC_ELEM {
     uint8_t run;
 } RL_VLC_ELEM;
 
+#define VLC_MULTI_MAX_SYMBOLS 6
+
+/**
+ * Multi-symbol VLC table entry, holds all the codes which fit completely in
+ * the bits of one table lookup. Only byte sized symbols can be stored.
+ */
+typedef struct VLC_MULTI_ELEM {
+    uint8_t val[VLC_MULTI_MAX_SYMBOLS];
+    int8_t len;     ///< total length of the num codes
+    uint8_t num;    ///< number of symbols, 0 if the first code does not fit
+} VLC_MULTI_ELEM;
+
 /* Bitstream reader API docs:
 name
     arbitrary name which is used as prefix for the internal variables
@@ -127,7 +148,85 @@ LAST_SKIP_BITS(name, gb, num)
 for examples see get_bits, show_bits, skip_bits, get_vlc
 */
 
-#ifdef ALT_BITSTREAM_READER
+#ifdef CACHED_BITSTREAM_READER
+/* Layout compatible with ALT_BITSTREAM_READER, so contexts can be shared with
+ * code using the alt reader. The 64-bit word read at cache_pos is kept in the
+ * context between calls and only reloaded once more than 32 bits of it have
+ * been consumed, or if index moved outside of it. */
+#   define MIN_CACHE_BITS 32
+
+/**
+ * Reads the 64 bits starting at byte pos of the buffer. Near the end of the
+ * buffer the bytes past buffer_end are read as 0 instead, a 64-bit load
+ * there could go beyond the FF_INPUT_BUFFER_PADDING_SIZE bytes of padding
+ * once the decoder has read past the end.
+ */
+static inline uint64_t cached_reader_load(const GetBitContext *s, unsigned int pos)
+{
+    int left = s->buffer_end - s->buffer - (int)pos;
+    uint64_t buf = 0;
+    int i;
+
+    if (left >= 8)
+        return AV_RB64(s->buffer + pos);
+    for (i = 0; i < left; i++)
+        buf |= (uint64_t)s->buffer[pos + i] << (56 - 8*i);
+    return buf;
+}
+
+#   define OPEN_READER(name, gb)\
+        unsigned int name##_index= (gb)->index;\
+        unsigned int name##_pos= (gb)->cache_pos;\
+        uint64_t name##_buf= (gb)->cache;\
+        uint64_t name##_cache= 0;\
+
+#   define CLOSE_READER(name, gb)\
+        (gb)->index= name##_index;\
+        (gb)->cache_pos= name##_pos;\
+        (gb)->cache= name##_buf;\
+
+#   define UPDATE_CACHE(name, gb)\
+    {\
+        if(name##_index - name##_pos > 64 - MIN_CACHE_BITS){\
+            name##_pos= name##_index & ~7;\
+            name##_buf= cached_reader_load(gb, name##_index>>3);\
+        }\
+        name##_cache= name##_buf << (name##_index - name##_pos);\
+    }\
+
+#   define SKIP_CACHE(name, gb, num)\
+        name##_cache <<= (num);
+
+#   define SKIP_COUNTER(name, gb, num)\
+        name##_index += (num);\
+
+#   define SKIP_BITS(name, gb, num)\
+        {\
+            SKIP_CACHE(name, gb, num)\
+            SKIP_COUNTER(name, gb, num)\
+        }\
+
+#   define LAST_SKIP_BITS(name, gb, num) SKIP_COUNTER(name, gb, num)
+#   define LAST_SKIP_CACHE(name, gb, num) ;
+
+#   define SHOW_UBITS(name, gb, num)\
+        ((uint32_t)(name##_cache >> (64 - (num))))
+
+#   define SHOW_SBITS(name, gb, num)\
+        ((int32_t)((int64_t)name##_cache >> (64 - (num))))
+
+#   define GET_CACHE(name, gb)\
+        ((uint32_t)(name##_cache >> 32))
+
+static inline int get_bits_count(const GetBitContext *s){
+    return s->index;
+}
+
+static inline void skip_bits_long(GetBitContext *s, int n){
+    s->index += n;
+}
+
+#elif defined ALT_BITSTREAM_READER
 #   define MIN_CACHE_BITS 25
 
 #   define OPEN_READER(name, gb)\
@@ -484,6 +583,7 @@ static inline void init_get_bits(GetBitContext *s,
     s->buffer_end= buffer + buffer_size;
 #ifdef ALT_BITSTREAM_READER
     s->index=0;
+    s->cache_pos= -64; // far enough from index that the first read reloads
 #elif defined LIBMPEG2_BITSTREAM_READER
     s->buffer_ptr = (uint8_t*)((intptr_t)buffer&(~1));
     s->bit_count = 16 + 8*((intptr_t)buffer&1);
@@ -519,6 +619,15 @@ int init_vlc_sparse(VLC *vlc, int nb_bits, int nb_codes,
 #define INIT_VLC_USE_NEW_STATIC 4
 void free_vlc(VLC *vlc);
 
+/**
+ * Builds a multi-symbol table from the first level of vlc.
+ * @param multi      table with 1 << vlc->bits entries
+ * @param max_symbols maximum number of symbols per entry, at most VLC_MULTI_MAX_SYMBOLS
+ * @param flags      INIT_VLC_LE if vlc was built with it
+ */
+void ff_init_vlc_multi(VLC_MULTI_ELEM *multi, const VLC *vlc,
+                       int max_symbols, int flags);
+
 #define INIT_VLC_STATIC(vlc, bits, a,b,c,d,e,f,g, static_size)\
 {\
     static VLC_TYPE table[static_size][2];\
@@ -591,6 +700,22 @@ void free_vlc(VLC *vlc);
     SKIP_BITS(name, gb, n)\
 }
 
+/**
+ * Parses up to VLC_MULTI_MAX_SYMBOLS vlc codes with one lookup in a table
+ * built by ff_init_vlc_multi().
+ * num is set to 0 and no bits are removed if the first code does not fit
+ * in the table, it has to be read with GET_VLC() then.
+ * @param dst must have room for VLC_MULTI_MAX_SYMBOLS symbols
+ */
+#define GET_VLC_MULTI(num, dst, name, gb, multi, bits)\
+{\
+    const VLC_MULTI_ELEM *e= &(multi)[SHOW_UBITS(name, gb, bits)];\
+\
+    num= e->num;\
+    memcpy(dst, e->val, VLC_MULTI_MAX_SYMBOLS);\
+    SKIP_BITS(name, gb, e->len)\
+}
+
 
 /**
  * parses a vlc code, faster then get_vlc()
@@ -614,6 +739,34 @@ static av_always_inline int get_vlc2(GetBitContext *s, VLC_TYPE (*table)[2],
     return code;
 }
 
+/**
+ * Parses between 1 and VLC_MULTI_MAX_SYMBOLS vlc codes.
+ * @param dst must have room for VLC_MULTI_MAX_SYMBOLS symbols
+ * @param multi table built by ff_init_vlc_multi() from table
+ * @return the number of symbols stored in dst
+ */
+static av_always_inline int get_vlc_multi(GetBitContext *s, uint8_t *dst,
+                                          const VLC_MULTI_ELEM *multi,
+                                          VLC_TYPE (*table)[2],
+                                          int bits, int max_depth)
+{
+    int num;
+
+    OPEN_READER(re, s)
+    UPDATE_CACHE(re, s)
+
+    GET_VLC_MULTI(num, dst, re, s, multi, bits)
+    if (!num) {
+        int code;
+        GET_VLC(code, re, s, table, bits, max_depth)
+        dst[0] = code;
+        num = 1;
+    }
+
+    CLOSE_READER(re, s)
+    return num;
+}
+
 //#define TRACE
 
 #ifdef TRACE
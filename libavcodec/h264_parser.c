@@ -29,6 +29,7 @@
 #include "h264_parser.h"
 #include "h264data.h"
 #include "golomb.h"
+#include "startcode.h"
 
 #include <assert.h>
 
@@ -46,18 +47,14 @@ int ff_h264_find_frame_end(H264Context *h, const uint8_t *buf, int buf_size)
 
     for(i=0; i<buf_size; i++){
         if(state==7){
-#if HAVE_FAST_UNALIGNED
-        /* we check i<buf_size instead of i+3/7 because its simpler
-         * and there should be FF_INPUT_BUFFER_PADDING_SIZE bytes at the end
-         */
-#    if HAVE_FAST_64BIT
-            while(i<buf_size && !((~*(const uint64_t*)(buf+i) & (*(const uint64_t*)(buf+i) - 0x0101010101010101ULL)) & 0x8080808080808080ULL))
-                i+=8;
-#    else
-            while(i<buf_size && !((~*(const uint32_t*)(buf+i) & (*(const uint32_t*)(buf+i) - 0x01010101U)) & 0x80808080U))
-                i+=4;
-#    endif
-#endif
+            /* skip to the zero run in front of the next start code prefix,
+             * or to the last bytes of the buffer which may begin one */
+            int next= ff_find_start_code_prefix(buf+i, buf+buf_size) - buf;
+            if(next == buf_size)
+                next= FFMAX(i, buf_size-4);
+            else if(next > i && !buf[next-1])
+                next--;
+            i= next;
             for(; i<buf_size; i++){
                 if(!buf[i]){
                     state=2;
@@ -75,6 +75,7 @@ typedef struct HYuvContext{
     uint32_t bits[3][256];
     uint32_t pix_bgr_map[1<<VLC_BITS];
     VLC vlc[6];                             //Y,U,V,YY,YU,YV
+    VLC_MULTI_ELEM vlc_multi[1<<VLC_BITS];  //Y, several symbols per lookup
     AVFrame picture;
     uint8_t *bitstream_buffer;
     unsigned int bitstream_buffer_size;
@@ -295,6 +296,7 @@ static void generate_joint_tables(HYuvContext *s){
             free_vlc(&s->vlc[3+p]);
             init_vlc_sparse(&s->vlc[3+p], VLC_BITS, i, len, 1, 1, bits, 2, 2, symbols, 2, 2, 0);
         }
+        ff_init_vlc_multi(s->vlc_multi, &s->vlc[0], VLC_MULTI_MAX_SYMBOLS, 0);
     }else{
         uint8_t (*map)[4] = (uint8_t(*)[4])s->pix_bgr_map;
         int i, b, g, r, code;
@@ -721,9 +723,14 @@ static void decode_gray_bitstream(HYuvContext *s, int count){
             READ_2PIX(s->temp[0][2*i  ], s->temp[0][2*i+1], 0);
         }
     }else{
-        for(i=0; i<count; i++){
-            READ_2PIX(s->temp[0][2*i  ], s->temp[0][2*i+1], 0);
-        }
+        uint8_t *dst = s->temp[0];
+
+        count *= 2;
+        /* stop early enough that no codes of the next line are read */
+        for(i=0; i<count - VLC_MULTI_MAX_SYMBOLS; )
+            i += get_vlc_multi(&s->gb, dst + i, s->vlc_multi, s->vlc[0].table, VLC_BITS, 3);
+        for(; i<count; i++)
+            dst[i] = get_vlc2(&s->gb, s->vlc[0].table, VLC_BITS, 3);
     }
 }
 
@@ -26,6 +26,7 @@
  */
 
 //#define DEBUG
+#define CACHED_BITSTREAM_READER
 #include "internal.h"
 #include "avcodec.h"
 #include "dsputil.h"
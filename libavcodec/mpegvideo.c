@@ -35,6 +35,7 @@
 #include "mpegvideo_common.h"
 #include "mjpegenc.h"
 #include "msmpeg4.h"
+#include "startcode.h"
 #include "faandct.h"
 #include "xvmc_internal.h"
 #include <limits.h>
@@ -134,16 +135,7 @@ const uint8_t *ff_find_start_code(const uint8_t * restrict p, const uint8_t *end
             return p;
     }
 
-    while(p<end){
-        if     (p[-1] > 1      ) p+= 3;
-        else if(p[-2]          ) p+= 2;
-        else if(p[-3]|(p[-1]-1)) p++;
-        else{
-            p++;
-            break;
-        }
-    }
-
+    p= ff_find_start_code_prefix(p-3, end) + 4;
     p= FFMIN(p, end)-4;
     *state= AV_RB32(p);
 
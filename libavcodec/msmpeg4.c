@@ -847,7 +847,7 @@ static inline int msmpeg4_pred_dc(MpegEncContext * s, int n,
 static void msmpeg4_encode_dc(MpegEncContext * s, int level, int n, int *dir_ptr)
 {
     int sign, code;
-    int pred, extquant;
+    int pred, extquant = 0;
     int extrabits = 0;
 
     if(s->msmpeg4_version==1){
@@ -21,6 +21,7 @@
  */
 
 #include "parser.h"
+#include "startcode.h"
 
 static AVCodecParser *av_first_parser = NULL;
 
@@ -58,6 +59,7 @@ AVCodecParserContext *av_parser_init(int codec_id)
     if (!s)
         return NULL;
     s->parser = parser;
+    ff_startcode_init();
     s->priv_data = av_mallocz(parser->priv_data_size);
     if (!s->priv_data) {
         av_free(s);
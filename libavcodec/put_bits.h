@@ -38,13 +38,29 @@
 //#define ALT_BITSTREAM_WRITER
 //#define ALIGNED_BITSTREAM_WRITER
 
+/* Bits are accumulated in a 64-bit word where 64-bit shifts are cheap, so
+ * the buffer only has to be written out every 64 bits. Code which depends on
+ * the buffer being written in 32-bit words can define BITSTREAM_WRITER_32,
+ * as long as its contexts are not shared with other files. */
+#if HAVE_FAST_64BIT && !defined(BITSTREAM_WRITER_32)
+typedef uint64_t BitBuf;
+#   define AV_WBBUF AV_WB64
+#   define AV_WLBUF AV_WL64
+#else
+typedef uint32_t BitBuf;
+#   define AV_WBBUF AV_WB32
+#   define AV_WLBUF AV_WL32
+#endif
+
+#define BUF_BITS (8 * (int)sizeof(BitBuf))
+
 /* buf and buf_end must be present and used by every alternative writer. */
 typedef struct PutBitContext {
 #ifdef ALT_BITSTREAM_WRITER
     uint8_t *buf, *buf_end;
     int index;
 #else
-    uint32_t bit_buf;
+    BitBuf bit_buf;
     int bit_left;
     uint8_t *buf, *buf_ptr, *buf_end;
 #endif
@@ -73,7 +89,7 @@ static inline void init_put_bits(PutBitContext *s, uint8_t *buffer, int buffer_s
 //    memset(buffer, 0, buffer_size);
 #else
     s->buf_ptr = s->buf;
-    s->bit_left=32;
+    s->bit_left=BUF_BITS;
     s->bit_buf=0;
 #endif
 }
@@ -86,7 +102,7 @@ static inline int put_bits_count(PutBitContext *s)
 #ifdef ALT_BITSTREAM_WRITER
     return s->index;
 #else
-    return (s->buf_ptr - s->buf) * 8 + 32 - s->bit_left;
+    return (s->buf_ptr - s->buf) * 8 + BUF_BITS - s->bit_left;
 #endif
 }
 
@@ -99,20 +115,21 @@ static inline void flush_put_bits(PutBitContext *s)
     align_put_bits(s);
 #else
 #ifndef BITSTREAM_WRITER_LE
-    s->bit_buf<<= s->bit_left;
+    if (s->bit_left < BUF_BITS)
+        s->bit_buf<<= s->bit_left;
 #endif
-    while (s->bit_left < 32) {
+    while (s->bit_left < BUF_BITS) {
         /* XXX: should test end of buffer */
 #ifdef BITSTREAM_WRITER_LE
         *s->buf_ptr++=s->bit_buf;
         s->bit_buf>>=8;
 #else
-        *s->buf_ptr++=s->bit_buf >> 24;
+        *s->buf_ptr++=s->bit_buf >> (BUF_BITS - 8);
         s->bit_buf<<=8;
 #endif
         s->bit_left+=8;
     }
-    s->bit_left=32;
+    s->bit_left=BUF_BITS;
     s->bit_buf=0;
 #endif
 }
@@ -142,36 +159,26 @@ void ff_put_string(PutBitContext *pb, const char *string, int terminate_string);
 void ff_copy_bits(PutBitContext *pb, const uint8_t *src, int length);
 #endif
 
+#ifndef ALT_BITSTREAM_WRITER
 /**
- * Writes up to 31 bits into a bitstream.
- * Use put_bits32 to write 32 bits.
+ * Writes up to 32 bits into a bitstream, without checking n and value.
+ * The buffer is only written to once BitBuf is full.
  */
-static inline void put_bits(PutBitContext *s, int n, unsigned int value)
-#ifndef ALT_BITSTREAM_WRITER
+static av_always_inline void put_bits_no_assert(PutBitContext *s, int n, unsigned int value)
 {
-    unsigned int bit_buf;
+    BitBuf bit_buf;
     int bit_left;
 
-    //    printf("put_bits=%d %x\n", n, value);
-    assert(n <= 31 && value < (1U << n));
-
     bit_buf = s->bit_buf;
     bit_left = s->bit_left;
 
-    //    printf("n=%d value=%x cnt=%d buf=%x\n", n, value, bit_cnt, bit_buf);
-    /* XXX: optimize */
 #ifdef BITSTREAM_WRITER_LE
-    bit_buf |= value << (32 - bit_left);
+    bit_buf |= (BitBuf)value << (BUF_BITS - bit_left);
     if (n >= bit_left) {
-#if !HAVE_FAST_UNALIGNED
-        if (3 & (intptr_t) s->buf_ptr) {
-            AV_WL32(s->buf_ptr, bit_buf);
-        } else
-#endif
-        *(uint32_t *)s->buf_ptr = le2me_32(bit_buf);
-        s->buf_ptr+=4;
-        bit_buf = (bit_left==32)?0:value >> bit_left;
-        bit_left+=32;
+        AV_WLBUF(s->buf_ptr, bit_buf);
+        s->buf_ptr += sizeof(BitBuf);
+        bit_buf = (bit_left==BUF_BITS)?0:value >> bit_left;
+        bit_left+=BUF_BITS;
     }
     bit_left-=n;
 #else
@@ -181,15 +188,9 @@ static inline void put_bits(PutBitContext *s, int n, unsigned int value)
     } else {
         bit_buf<<=bit_left;
         bit_buf |= value >> (n - bit_left);
-#if !HAVE_FAST_UNALIGNED
-        if (3 & (intptr_t) s->buf_ptr) {
-            AV_WB32(s->buf_ptr, bit_buf);
-        } else
-#endif
-        *(uint32_t *)s->buf_ptr = be2me_32(bit_buf);
-        //printf("bitbuf = %08x\n", bit_buf);
-        s->buf_ptr+=4;
-        bit_left+=32 - n;
+        AV_WBBUF(s->buf_ptr, bit_buf);
+        s->buf_ptr += sizeof(BitBuf);
+        bit_left+=BUF_BITS - n;
         bit_buf = value;
     }
 #endif
@@ -197,6 +198,18 @@ static inline void put_bits(PutBitContext *s, int n, unsigned int value)
     s->bit_buf = bit_buf;
     s->bit_left = bit_left;
 }
+#endif
+
+/**
+ * Writes up to 31 bits into a bitstream.
+ * Use put_bits32 to write 32 bits.
+ */
+static inline void put_bits(PutBitContext *s, int n, unsigned int value)
+#ifndef ALT_BITSTREAM_WRITER
+{
+    assert(n <= 31 && value < (1U << n));
+    put_bits_no_assert(s, n, value);
+}
 #else  /* ALT_BITSTREAM_WRITER defined */
 {
 #    ifdef ALIGNED_BITSTREAM_WRITER
@@ -274,6 +287,9 @@ static inline void put_sbits(PutBitContext *pb, int n, int32_t value)
  */
 static void av_unused put_bits32(PutBitContext *s, uint32_t value)
 {
+#if HAVE_FAST_64BIT && !defined(BITSTREAM_WRITER_32) && !defined(ALT_BITSTREAM_WRITER)
+    put_bits_no_assert(s, 32, value);
+#else
     int lo = value & 0xffff;
     int hi = value >> 16;
 #ifdef BITSTREAM_WRITER_LE
@@ -283,6 +299,37 @@ static void av_unused put_bits32(PutBitContext *s, uint32_t value)
     put_bits(s, 16, hi);
     put_bits(s, 16, lo);
 #endif
+#endif
+}
+
+/**
+ * Writes up to 64 bits into a bitstream.
+ */
+static inline void put_bits64(PutBitContext *s, int n, uint64_t value)
+{
+    assert((n == 64 || (n < 64 && value < (UINT64_C(1) << n))));
+
+    if (n < 32)
+        put_bits(s, n, value);
+    else if (n == 32)
+        put_bits32(s, value);
+    else {
+        uint32_t lo = value & 0xffffffff;
+        uint32_t hi = value >> 32;
+#ifdef BITSTREAM_WRITER_LE
+        put_bits32(s, lo);
+        if (n < 64)
+            put_bits(s, n - 32, hi);
+        else
+            put_bits32(s, hi);
+#else
+        if (n < 64)
+            put_bits(s, n - 32, hi);
+        else
+            put_bits32(s, hi);
+        put_bits32(s, lo);
+#endif
+    }
 }
 
 /**
@@ -309,7 +356,7 @@ static inline void skip_put_bytes(PutBitContext *s, int n)
         FIXME may need some cleaning of the buffer
         s->index += n<<3;
 #else
-        assert(s->bit_left==32);
+        assert(s->bit_left==BUF_BITS);
         s->buf_ptr += n;
 #endif
 }
@@ -325,8 +372,8 @@ static inline void skip_put_bits(PutBitContext *s, int n)
     s->index += n;
 #else
     s->bit_left -= n;
-    s->buf_ptr-= 4*(s->bit_left>>5);
-    s->bit_left &= 31;
+    s->buf_ptr-= sizeof(BitBuf)*(s->bit_left>>(BUF_BITS == 64 ? 6 : 5));
+    s->bit_left &= BUF_BITS - 1;
 #endif
 }
 
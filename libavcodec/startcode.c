@@ -0,0 +1,58 @@
+/*
+ * Start code prefix search
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Search for 0x000001 start code prefixes.
+ */
+
+#include "config.h"
+#include "libavutil/cpu.h"
+#include "startcode.h"
+
+const uint8_t *ff_find_start_code_prefix_c(const uint8_t *p, const uint8_t *end)
+{
+    /* p[-3], p[-2], p[-1] is the candidate; a byte > 1 at p[-1] rules out
+     * the next three candidates, a nonzero p[-2] the next two */
+    p += 3;
+    while (p < end) {
+        if      (p[-1] > 1             ) p += 3;
+        else if (p[-2]                 ) p += 2;
+        else if (p[-3] | (p[-1] - 1)   ) p++;
+        else
+            return p - 3;
+    }
+    return end;
+}
+
+const uint8_t *(*ff_find_start_code_prefix)(const uint8_t *p, const uint8_t *end) = ff_find_start_code_prefix_c;
+
+void ff_startcode_init(void)
+{
+    const uint8_t *(*f)(const uint8_t *p, const uint8_t *end) = ff_find_start_code_prefix_c;
+#if ARCH_X86 && HAVE_SSE
+    if (av_get_cpu_flags() & AV_CPU_FLAG_SSE2)
+        f = ff_find_start_code_prefix_sse2;
+#endif
+    /* racy, since av_parser_init() does not hold the codec lock, but
+     * idempotent: concurrent callers store the same pointer, and all the
+     * versions return the same result anyway */
+    ff_find_start_code_prefix = f;
+}
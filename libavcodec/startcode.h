@@ -0,0 +1,51 @@
+/*
+ * Start code prefix search
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Search for 0x000001 start code prefixes (MPEG-1/2/4, H.264, VC-1, CAVS).
+ */
+
+#ifndef AVCODEC_STARTCODE_H
+#define AVCODEC_STARTCODE_H
+
+#include <stdint.h>
+
+/**
+ * Find the first 00 00 01 sequence in [p, end) which is followed by at least
+ * one more byte, i.e. whose start code value is within the buffer too.
+ * Points to the version selected by the last ff_startcode_init() call, the
+ * C version until then.
+ * @return pointer to the first zero byte of the prefix, or end if none
+ */
+extern const uint8_t *(*ff_find_start_code_prefix)(const uint8_t *p, const uint8_t *end);
+
+/**
+ * Select the version of ff_find_start_code_prefix() for the CPU flags
+ * returned by av_get_cpu_flags(). Called by avcodec_open() and
+ * av_parser_init(), so that a mask set with av_set_cpu_flags_mask()
+ * before opening a codec or parser applies.
+ */
+void ff_startcode_init(void);
+
+const uint8_t *ff_find_start_code_prefix_c(const uint8_t *p, const uint8_t *end);
+const uint8_t *ff_find_start_code_prefix_sse2(const uint8_t *p, const uint8_t *end);
+
+#endif /* AVCODEC_STARTCODE_H */
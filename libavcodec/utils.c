@@ -32,6 +32,7 @@
 #include "libavutil/integer.h"
 #include "libavutil/crc.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/trace.h"
 #include "avcodec.h"
 #include "dsputil.h"
 #include "opt.h"
@@ -39,6 +40,7 @@
 #include "audioconvert.h"
 #include "libxvid_internal.h"
 #include "internal.h"
+#include "startcode.h"
 #include <stdlib.h>
 #include <stdarg.h>
 #include <limits.h>
@@ -512,6 +514,7 @@ int attribute_align_arg avcodec_open(AVCodecContext *avctx, AVCodec *codec)
         goto free_and_end;
     }
     avctx->frame_number = 0;
+    ff_startcode_init();
     if(avctx->codec->init){
         ret = avctx->codec->init(avctx);
         if (ret < 0) {
@@ -541,7 +544,10 @@ int attribute_align_arg avcodec_encode_audio(AVCodecContext *avctx, uint8_t *buf
         return -1;
     }
     if((avctx->codec->capabilities & CODEC_CAP_DELAY) || samples){
-        int ret = avctx->codec->encode(avctx, buf, buf_size, samples);
+        int ret;
+        START_TRACE
+        ret = avctx->codec->encode(avctx, buf, buf_size, samples);
+        STOP_TRACE("encode", avctx->codec->name)
         avctx->frame_number++;
         return ret;
     }else
@@ -558,7 +564,10 @@ int attribute_align_arg avcodec_encode_video(AVCodecContext *avctx, uint8_t *buf
     if(avcodec_check_dimensions(avctx,avctx->width,avctx->height))
         return -1;
     if((avctx->codec->capabilities & CODEC_CAP_DELAY) || pict){
-        int ret = avctx->codec->encode(avctx, buf, buf_size, pict);
+        int ret;
+        START_TRACE
+        ret = avctx->codec->encode(avctx, buf, buf_size, pict);
+        STOP_TRACE("encode", avctx->codec->name)
         avctx->frame_number++;
         emms_c(); //needed to avoid an emms_c() call before every return;
 
@@ -577,7 +586,9 @@ int avcodec_encode_subtitle(AVCodecContext *avctx, uint8_t *buf, int buf_size,
     }
     if(sub->num_rects == 0 || !sub->rects)
         return -1;
+    START_TRACE
     ret = avctx->codec->encode(avctx, buf, buf_size, sub);
+    STOP_TRACE("encode", avctx->codec->name)
     avctx->frame_number++;
     return ret;
 }
@@ -608,8 +619,10 @@ int attribute_align_arg avcodec_decode_video2(AVCodecContext *avctx, AVFrame *pi
     if((avctx->coded_width||avctx->coded_height) && avcodec_check_dimensions(avctx,avctx->coded_width,avctx->coded_height))
         return -1;
     if((avctx->codec->capabilities & CODEC_CAP_DELAY) || avpkt->size){
+        START_TRACE
         ret = avctx->codec->decode(avctx, picture, got_picture_ptr,
                                 avpkt);
+        STOP_TRACE("decode", avctx->codec->name)
 
         emms_c(); //needed to avoid an emms_c() call before every return;
 
@@ -653,7 +666,9 @@ int attribute_align_arg avcodec_decode_audio3(AVCodecContext *avctx, int16_t *sa
             return -1;
         }
 
+        START_TRACE
         ret = avctx->codec->decode(avctx, samples, frame_size_ptr, avpkt);
+        STOP_TRACE("decode", avctx->codec->name)
         avctx->frame_number++;
     }else{
         ret= 0;
@@ -683,7 +698,9 @@ int avcodec_decode_subtitle2(AVCodecContext *avctx, AVSubtitle *sub,
     int ret;
 
     *got_sub_ptr = 0;
+    START_TRACE
     ret = avctx->codec->decode(avctx, sub, got_sub_ptr, avpkt);
+    STOP_TRACE("decode", avctx->codec->name)
     if (*got_sub_ptr)
         avctx->frame_number++;
     return ret;
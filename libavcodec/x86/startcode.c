@@ -0,0 +1,60 @@
+/*
+ * SSE2 start code prefix search
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/x86_cpu.h"
+#include "libavcodec/startcode.h"
+
+#if HAVE_SSE
+/**
+ * Build a mask of the zero bytes in 32 bytes of input and test every pair
+ * of adjacent zeros for a following 0x01. Compressed data rarely contains
+ * 00 00, so almost all iterations end after the mask test.
+ */
+const uint8_t *ff_find_start_code_prefix_sse2(const uint8_t *p, const uint8_t *end)
+{
+    while (end - p >= 34) {
+        unsigned int lo, hi, zz;
+
+        __asm__ volatile(
+            "pxor          %%xmm2, %%xmm2   \n\t"
+            "movdqu          (%2), %%xmm0   \n\t"
+            "movdqu        16(%2), %%xmm1   \n\t"
+            "pcmpeqb       %%xmm2, %%xmm0   \n\t"
+            "pcmpeqb       %%xmm2, %%xmm1   \n\t"
+            "pmovmskb      %%xmm0, %0       \n\t"
+            "pmovmskb      %%xmm1, %1       \n\t"
+            : "=r"(lo), "=r"(hi)
+            : "r"(p)
+            : "memory"
+        );
+        zz  = lo | hi << 16;
+        zz &= zz >> 1;       /* bit i: p[i] == p[i+1] == 0, for i < 31 */
+        while (zz) {
+            int i = av_log2(zz & -zz);
+            if (p[i + 2] == 1)
+                return p + i;
+            zz &= zz - 1;
+        }
+        p += 31;
+    }
+    return ff_find_start_code_prefix_c(p, end);
+}
+#endif /* HAVE_SSE */
@@ -21,8 +21,14 @@
 
 /* #define DEBUG */
 
+#include <sys/time.h>
+#include "config.h"
+#if HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
 #include "libavcodec/imgconvert.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/trace.h"
 #include "avfilter.h"
 
 unsigned avfilter_version(void) {
@@ -193,6 +199,60 @@ static void dprintf_link(void *ctx, AVFilterLink *link, int end)
 
 #define DPRINTF_START(ctx, func) dprintf(NULL, "%-16s: ", #func)
 
+typedef struct {
+    int64_t wall, cpu;
+    int64_t trace;      ///< start of the trace event, 0 if not tracing
+} ProfileTime;
+
+static void get_profile_time(ProfileTime *t)
+{
+    struct timeval tv;
+#if HAVE_GETRUSAGE
+    struct rusage rusage;
+
+    getrusage(RUSAGE_SELF, &rusage);
+    t->cpu = (rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) * 1000000LL +
+              rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec;
+#else
+    t->cpu = 0;
+#endif
+    gettimeofday(&tv, NULL);
+    t->wall = tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void profile_start(AVFilterContext *callee, ProfileTime *t)
+{
+    t->trace = av_trace_enabled ? av_trace_begin() : 0;
+    if(!callee->profiling)
+        return;
+    callee->profiling_depth ++;
+    get_profile_time(t);
+}
+
+/**
+ * Charges the time elapsed since profile_start() to callee. If it was
+ * called from a profiled callback of caller, the time is removed from
+ * caller so that each filter is only charged for its own work.
+ */
+static void profile_stop(AVFilterContext *callee, AVFilterContext *caller,
+                         ProfileTime *t)
+{
+    ProfileTime end;
+
+    if(t->trace)
+        av_trace_end("filter", callee->filter->name, t->trace);
+    if(!callee->profiling || !callee->profiling_depth)
+        return;
+    get_profile_time(&end);
+    callee->profiling_depth --;
+    callee->stats.wall_time += end.wall - t->wall;
+    callee->stats.cpu_time  += end.cpu  - t->cpu;
+    if(caller && caller != callee && caller->profiling_depth) {
+        caller->stats.wall_time -= end.wall - t->wall;
+        caller->stats.cpu_time  -= end.cpu  - t->cpu;
+    }
+}
+
 AVFilterPicRef *avfilter_get_video_buffer(AVFilterLink *link, int perms, int w, int h)
 {
     AVFilterPicRef *ret = NULL;
@@ -212,13 +272,25 @@ AVFilterPicRef *avfilter_get_video_buffer(AVFilterLink *link, int perms, int w,
 
 int avfilter_request_frame(AVFilterLink *link)
 {
+    ProfileTime t;
+    int ret;
+
     DPRINTF_START(NULL, request_frame); dprintf_link(NULL, link, 1);
 
+    if(link->src->profiling) {
+        link->stats.request_count ++;
+        link->src->stats.request_count ++;
+    }
+
+    profile_start(link->src, &t);
     if(link_spad(link).request_frame)
-        return link_spad(link).request_frame(link);
+        ret = link_spad(link).request_frame(link);
     else if(link->src->inputs[0])
-        return avfilter_request_frame(link->src->inputs[0]);
-    else return -1;
+        ret = avfilter_request_frame(link->src->inputs[0]);
+    else ret = -1;
+    profile_stop(link->src, link->dst, &t);
+
+    return ret;
 }
 
 int avfilter_poll_frame(AVFilterLink *link)
@@ -245,9 +317,23 @@ void avfilter_start_frame(AVFilterLink *link, AVFilterPicRef *picref)
 {
     void (*start_frame)(AVFilterLink *, AVFilterPicRef *);
     AVFilterPad *dst = &link_dpad(link);
+    ProfileTime t;
+    int i;
 
     DPRINTF_START(NULL, start_frame); dprintf_link(NULL, link, 0); dprintf(NULL, " "); dprintf_picref(NULL, picref, 1);
 
+    if(link->dst->profiling) {
+        link->stats.frame_count ++;
+        link->dst->stats.frame_count ++;
+        link->stats.queued ++;
+        link->stats.max_queued = FFMAX(link->stats.max_queued, link->stats.queued);
+
+        /* the source filter passes on one of the frames it was sent */
+        for(i = 0; i < link->src->input_count; i ++)
+            if(link->src->inputs[i] && link->src->inputs[i]->stats.queued)
+                link->src->inputs[i]->stats.queued --;
+    }
+
     if(!(start_frame = dst->start_frame))
         start_frame = avfilter_default_start_frame;
 
@@ -263,6 +349,8 @@ void avfilter_start_frame(AVFilterLink *link, AVFilterPicRef *picref)
 
         link->cur_pic = avfilter_default_get_video_buffer(link, dst->min_perms, link->w, link->h);
         link->srcpic = picref;
+        if(link->dst->profiling)
+            link->stats.copy_count ++;
         link->cur_pic->pts = link->srcpic->pts;
         link->cur_pic->pos = link->srcpic->pos;
         link->cur_pic->pixel_aspect = link->srcpic->pixel_aspect;
@@ -272,17 +360,26 @@ void avfilter_start_frame(AVFilterLink *link, AVFilterPicRef *picref)
     else
         link->cur_pic = picref;
 
+    profile_start(link->dst, &t);
     start_frame(link, link->cur_pic);
+    profile_stop(link->dst, link->src, &t);
 }
 
 void avfilter_end_frame(AVFilterLink *link)
 {
     void (*end_frame)(AVFilterLink *);
+    ProfileTime t;
 
     if(!(end_frame = link_dpad(link).end_frame))
         end_frame = avfilter_default_end_frame;
 
+    /* sinks consume the frames they are sent */
+    if(link->dst->profiling && !link->dst->output_count && link->stats.queued)
+        link->stats.queued --;
+
+    profile_start(link->dst, &t);
     end_frame(link);
+    profile_stop(link->dst, link->src, &t);
 
     /* unreference the source picture if we're feeding the destination filter
      * a copied version dues to permission issues */
@@ -298,9 +395,15 @@ void avfilter_draw_slice(AVFilterLink *link, int y, int h, int slice_dir)
     uint8_t *src[4], *dst[4];
     int i, j, vsub;
     void (*draw_slice)(AVFilterLink *, int, int, int);
+    ProfileTime t;
 
     DPRINTF_START(NULL, draw_slice); dprintf_link(NULL, link, 0); dprintf(NULL, " y:%d h:%d dir:%d\n", y, h, slice_dir);
 
+    if(link->dst->profiling) {
+        link->stats.slice_count ++;
+        link->dst->stats.slice_count ++;
+    }
+
     /* copy the slice if needed for permission reasons */
     if(link->srcpic) {
         vsub = av_pix_fmt_descriptors[link->format].log2_chroma_h;
@@ -331,7 +434,10 @@ void avfilter_draw_slice(AVFilterLink *link, int y, int h, int slice_dir)
 
     if(!(draw_slice = link_dpad(link).draw_slice))
         draw_slice = avfilter_default_draw_slice;
+
+    profile_start(link->dst, &t);
     draw_slice(link, y, h, slice_dir);
+    profile_stop(link->dst, link->src, &t);
 }
 
 #define MAX_REGISTERED_AVFILTERS_NB 64
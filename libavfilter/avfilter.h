@@ -25,7 +25,7 @@
 #include "libavutil/avutil.h"
 
 #define LIBAVFILTER_VERSION_MAJOR  1
-#define LIBAVFILTER_VERSION_MINOR 20
+#define LIBAVFILTER_VERSION_MINOR 23
 #define LIBAVFILTER_VERSION_MICRO  0
 
 #define LIBAVFILTER_VERSION_INT AV_VERSION_INT(LIBAVFILTER_VERSION_MAJOR, \
@@ -456,6 +456,46 @@ typedef struct AVFilter
     const char *description;
 } AVFilter;
 
+/**
+ * Profiling statistics of a filter instance. They are only collected
+ * while profiling is enabled, see avfilter_graph_set_profiling().
+ */
+typedef struct AVFilterStats {
+    /**
+     * Wall clock and process CPU time spent in the callbacks of the filter,
+     * in microseconds. The time spent in the callbacks of the other filters
+     * called from them is not included.
+     */
+    int64_t wall_time;
+    int64_t cpu_time;
+
+    unsigned frame_count;       ///< number of frames received by the filter
+    unsigned slice_count;       ///< number of slices received by the filter
+    unsigned request_count;     ///< number of frames requested from the filter
+
+    /** bytes of picture buffers allocated on the output links of the filter */
+    int64_t buffer_bytes;
+} AVFilterStats;
+
+/**
+ * Statistics of the traffic across a link, collected along with the
+ * AVFilterStats of the filters.
+ */
+typedef struct AVFilterLinkStats {
+    unsigned frame_count;       ///< number of frames sent across the link
+    unsigned slice_count;       ///< number of slices sent across the link
+    unsigned request_count;     ///< number of frames requested on the link
+    unsigned copy_count;        ///< frames copied because of insufficient permissions
+    int64_t  buffer_bytes;      ///< bytes of picture buffers allocated on the link
+
+    /**
+     * Number of frames sent across the link which the destination filter
+     * has not passed on yet, and the maximum reached by this number.
+     */
+    unsigned queued;
+    unsigned max_queued;
+} AVFilterLinkStats;
+
 /** An instance of a filter */
 struct AVFilterContext
 {
@@ -474,6 +514,10 @@ struct AVFilterContext
     AVFilterLink **outputs;         ///< array of pointers to output links
 
     void *priv;                     ///< private data for use by the filter
+
+    int profiling;                  ///< collect profiling statistics if non-zero
+    AVFilterStats stats;            ///< profiling statistics
+    unsigned profiling_depth;       ///< number of profiled callbacks running, internal
 };
 
 /**
@@ -521,6 +565,8 @@ struct AVFilterLink
 
     AVFilterPicRef *cur_pic;
     AVFilterPicRef *outpic;
+
+    AVFilterLinkStats stats;    ///< statistics, collected if the filters are profiled
 };
 
 /**
@@ -23,6 +23,8 @@
 #include <ctype.h>
 #include <string.h>
 
+#include "libavutil/pixdesc.h"
+#include "libavcodec/avcodec.h"
 #include "avfilter.h"
 #include "avfiltergraph.h"
 
@@ -164,6 +166,228 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
     return 0;
 }
 
+/**
+ * Returns the cost of converting a picture from the format src to the
+ * format dst, 0 meaning no conversion at all. Lossy conversions always
+ * cost more than lossless ones, so that the graph keeps as much of the
+ * source precision as it can.
+ */
+static int get_conversion_cost(enum PixelFormat src, enum PixelFormat dst)
+{
+    const AVPixFmtDescriptor *s = &av_pix_fmt_descriptors[src];
+    const AVPixFmtDescriptor *d = &av_pix_fmt_descriptors[dst];
+    int loss, i, depth_loss = 0, cost = 1;
+
+    if(src == dst)
+        return 0;
+
+    loss = avcodec_get_pix_fmt_loss(dst, src, 1);
+    if(loss & FF_LOSS_COLORQUANT) cost += 64;
+    if(loss & FF_LOSS_CHROMA)     cost += 32;
+    if(loss & FF_LOSS_COLORSPACE) cost += 16;
+    if(loss & FF_LOSS_ALPHA)      cost += 16;
+    if(loss & FF_LOSS_RESOLUTION) cost += 8;
+
+    for(i = 0; i < FFMIN(s->nb_components, d->nb_components); i ++)
+        depth_loss += FFMAX(s->comp[i].depth_minus1 - d->comp[i].depth_minus1, 0);
+    if(!depth_loss && (loss & FF_LOSS_DEPTH))
+        depth_loss = 1;
+    cost += 4 * depth_loss;
+
+    /* lossless changes still need a pass over the whole picture */
+    if(s->log2_chroma_w != d->log2_chroma_w ||
+       s->log2_chroma_h != d->log2_chroma_h)
+        cost += 2;
+
+    return cost;
+}
+
+typedef struct {
+    int src, dst;           ///< indexes of the format lists on both sides of a filter
+} FormatEdge;
+
+typedef struct {
+    AVFilterFormats **lists;    ///< distinct format lists still to be resolved
+    int *choice;                ///< chosen index in each list, -1 if not chosen yet
+    int list_count;
+    FormatEdge *edges;          ///< filters across which a conversion may happen
+    int edge_count;
+} FormatGraph;
+
+static int find_list(FormatGraph *fg, AVFilterFormats *list)
+{
+    int i;
+
+    for(i = 0; i < fg->list_count; i ++)
+        if(fg->lists[i] == list)
+            return i;
+    return -1;
+}
+
+/**
+ * Returns the cost of choosing the format at index idx of list l, given
+ * the choices made so far. For lists not resolved yet, the cheapest of
+ * their candidates is assumed.
+ */
+static int get_choice_cost(FormatGraph *fg, int l, int idx)
+{
+    enum PixelFormat fmt = fg->lists[l]->formats[idx];
+    int i, j, cost = 0;
+
+    for(i = 0; i < fg->edge_count; i ++) {
+        FormatEdge *e = &fg->edges[i];
+        int other = e->src == l ? e->dst : e->dst == l ? e->src : -1;
+        AVFilterFormats *ol;
+        int best = INT_MAX;
+
+        if(other < 0)
+            continue;
+        ol = fg->lists[other];
+        for(j = 0; j < ol->format_count; j ++) {
+            int c;
+            if(fg->choice[other] >= 0 && j != fg->choice[other])
+                continue;
+            c = e->src == l ? get_conversion_cost(fmt, ol->formats[j])
+                            : get_conversion_cost(ol->formats[j], fmt);
+            best = FFMIN(best, c);
+        }
+        if(best != INT_MAX)
+            cost += best;
+    }
+
+    return cost;
+}
+
+static int get_best_choice(FormatGraph *fg, int l, int *cost)
+{
+    int i, best = 0, best_cost = INT_MAX;
+
+    /* on equal cost, the order of preference of the filters is kept */
+    for(i = 0; i < fg->lists[l]->format_count; i ++) {
+        int c = get_choice_cost(fg, l, i);
+        if(c < best_cost) {
+            best      = i;
+            best_cost = c;
+        }
+    }
+
+    if(cost)
+        *cost = best_cost;
+    return best;
+}
+
+static int add_list(FormatGraph *fg, AVFilterLink *link)
+{
+    int l;
+
+    if(!link || !link->in_formats)
+        return -1;
+    if((l = find_list(fg, link->in_formats)) >= 0)
+        return l;
+
+    fg->lists[fg->list_count]  = link->in_formats;
+    fg->choice[fg->list_count] = link->in_formats->format_count > 1 ? -1 : 0;
+    return fg->list_count ++;
+}
+
+static int build_format_graph(AVFilterGraph *graph, FormatGraph *fg)
+{
+    int i, j, k, link_count = 0, edge_count = 0;
+
+    for(i = 0; i < graph->filter_count; i ++) {
+        AVFilterContext *filter = graph->filters[i];
+        link_count += filter->input_count + filter->output_count;
+        edge_count += filter->input_count * filter->output_count;
+    }
+
+    fg->lists  = av_malloc(link_count * sizeof(*fg->lists));
+    fg->choice = av_malloc(link_count * sizeof(*fg->choice));
+    fg->edges  = av_malloc(edge_count * sizeof(*fg->edges));
+    if((link_count && (!fg->lists || !fg->choice)) || (edge_count && !fg->edges))
+        return AVERROR(ENOMEM);
+
+    for(i = 0; i < graph->filter_count; i ++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        for(j = 0; j < filter->input_count; j ++) {
+            int src = add_list(fg, filter->inputs[j]);
+            if(src < 0)
+                continue;
+            for(k = 0; k < filter->output_count; k ++) {
+                int dst = add_list(fg, filter->outputs[k]);
+                /* lists shared by both sides mean the filter keeps the format */
+                if(dst < 0 || dst == src)
+                    continue;
+                fg->edges[fg->edge_count].src = src;
+                fg->edges[fg->edge_count].dst = dst;
+                fg->edge_count ++;
+            }
+        }
+        for(j = 0; j < filter->output_count; j ++)
+            add_list(fg, filter->outputs[j]);
+    }
+
+    return 0;
+}
+
+/**
+ * Chooses one format for each list of candidates left after merging, so
+ * that the total cost of the conversions done by the filters which do not
+ * pass their input format through (the scalers mostly) is minimal.
+ *
+ * The lists are first resolved greedily, starting from the ones next to
+ * already fixed formats, then each choice is revised against its
+ * neighbours until the total cost stops decreasing.
+ */
+static void choose_formats(FormatGraph *fg)
+{
+    int i, pass, changed;
+
+    for(;;) {
+        int l = -1;
+
+        for(i = 0; i < fg->list_count; i ++) {
+            int j;
+            if(fg->choice[i] >= 0)
+                continue;
+            if(l < 0)
+                l = i;
+            for(j = 0; j < fg->edge_count; j ++) {
+                FormatEdge *e = &fg->edges[j];
+                if((e->src == i && fg->choice[e->dst] >= 0) ||
+                   (e->dst == i && fg->choice[e->src] >= 0))
+                    break;
+            }
+            if(j < fg->edge_count) {
+                l = i;
+                break;
+            }
+        }
+        if(l < 0)
+            break;
+        fg->choice[l] = get_best_choice(fg, l, NULL);
+    }
+
+    /* every change strictly lowers the total cost, the bound is only a
+     * safeguard against pathological graphs */
+    for(pass = 0; pass < 16; pass ++) {
+        changed = 0;
+        for(i = 0; i < fg->list_count; i ++) {
+            int cur, best, best_cost;
+            if(fg->lists[i]->format_count < 2)
+                continue;
+            cur  = get_choice_cost(fg, i, fg->choice[i]);
+            best = get_best_choice(fg, i, &best_cost);
+            if(best_cost < cur) {
+                fg->choice[i] = best;
+                changed = 1;
+            }
+        }
+        if(!changed)
+            break;
+    }
+}
+
 static void pick_format(AVFilterLink *link)
 {
     if(!link || !link->in_formats)
@@ -176,9 +400,26 @@ static void pick_format(AVFilterLink *link)
     avfilter_formats_unref(&link->out_formats);
 }
 
-static void pick_formats(AVFilterGraph *graph)
+static int pick_formats(AVFilterGraph *graph, AVClass *log_ctx)
 {
-    int i, j;
+    FormatGraph fg = { 0 };
+    int i, j, ret, cost = 0;
+
+    if((ret = build_format_graph(graph, &fg)) < 0)
+        goto end;
+
+    choose_formats(&fg);
+
+    for(i = 0; i < fg.edge_count; i ++) {
+        FormatEdge *e = &fg.edges[i];
+        cost += get_conversion_cost(fg.lists[e->src]->formats[fg.choice[e->src]],
+                                    fg.lists[e->dst]->formats[fg.choice[e->dst]]);
+    }
+    av_log(log_ctx, AV_LOG_DEBUG, "format conversion cost of the graph: %d\n", cost);
+
+    /* move the chosen format in front, pick_format() takes the first one */
+    for(i = 0; i < fg.list_count; i ++)
+        fg.lists[i]->formats[0] = fg.lists[i]->formats[fg.choice[i]];
 
     for(i = 0; i < graph->filter_count; i ++) {
         AVFilterContext *filter = graph->filters[i];
@@ -188,6 +429,12 @@ static void pick_formats(AVFilterGraph *graph)
         for(j = 0; j < filter->output_count; j ++)
             pick_format(filter->outputs[j]);
     }
+
+end:
+    av_free(fg.lists);
+    av_free(fg.choice);
+    av_free(fg.edges);
+    return ret;
 }
 
 int avfilter_graph_config_formats(AVFilterGraph *graph, AVClass *log_ctx)
@@ -197,9 +444,76 @@ int avfilter_graph_config_formats(AVFilterGraph *graph, AVClass *log_ctx)
         return -1;
 
     /* Once everything is merged, it's possible that we'll still have
-     * multiple valid colorspace choices. We pick the first one. */
-    pick_formats(graph);
+     * multiple valid colorspace choices. We pick the ones which make the
+     * conversions through the graph the cheapest. */
+    if(pick_formats(graph, log_ctx) < 0)
+        return -1;
 
     return 0;
 }
 
+
+void avfilter_graph_set_profiling(AVFilterGraph *graph, int enable)
+{
+    int i, j;
+
+    for(i = 0; i < graph->filter_count; i ++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        filter->profiling = enable;
+        if(!enable)
+            continue;
+        memset(&filter->stats, 0, sizeof(filter->stats));
+        for(j = 0; j < filter->output_count; j ++)
+            if(filter->outputs[j])
+                memset(&filter->outputs[j]->stats, 0, sizeof(filter->outputs[j]->stats));
+    }
+}
+
+void avfilter_graph_dump_stats(AVFilterGraph *graph, void *log_ctx)
+{
+    int64_t total = 0;
+    int i, j;
+
+    for(i = 0; i < graph->filter_count; i ++)
+        total += graph->filters[i]->stats.wall_time;
+
+    av_log(log_ctx, AV_LOG_INFO,
+           "%-24s %10s %6s %10s %7s %7s %7s %9s\n", "filter", "wall(ms)", "%",
+           "cpu(ms)", "frames", "slices", "reqs", "alloc(kB)");
+    for(i = 0; i < graph->filter_count; i ++) {
+        AVFilterContext *filter = graph->filters[i];
+        AVFilterStats   *s      = &filter->stats;
+
+        av_log(log_ctx, AV_LOG_INFO,
+               "%-24.24s %10.3f %6.2f %10.3f %7u %7u %7u %9"PRId64"\n",
+               filter->name ? filter->name : filter->filter->name,
+               s->wall_time / 1000.0, total ? 100.0 * s->wall_time / total : 0.0,
+               s->cpu_time / 1000.0, s->frame_count, s->slice_count,
+               s->request_count, s->buffer_bytes >> 10);
+    }
+
+    av_log(log_ctx, AV_LOG_INFO,
+           "%-40s %7s %7s %7s %7s %9s %6s\n", "link", "frames", "slices",
+           "reqs", "copies", "alloc(kB)", "queue");
+    for(i = 0; i < graph->filter_count; i ++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        for(j = 0; j < filter->output_count; j ++) {
+            AVFilterLink      *link = filter->outputs[j];
+            AVFilterLinkStats *s;
+            char name[64];
+
+            if(!link || !link->dst)
+                continue;
+            s = &link->stats;
+            snprintf(name, sizeof(name), "%s -> %s",
+                     filter->name    ? filter->name    : filter->filter->name,
+                     link->dst->name ? link->dst->name : link->dst->filter->name);
+            av_log(log_ctx, AV_LOG_INFO,
+                   "%-40.40s %7u %7u %7u %7u %9"PRId64" %6u\n",
+                   name, s->frame_count, s->slice_count, s->request_count,
+                   s->copy_count, s->buffer_bytes >> 10, s->max_queued);
+        }
+    }
+}
@@ -66,9 +66,28 @@ int avfilter_graph_config_links(AVFilterGraph *graphctx, AVClass *log_ctx);
 
 /**
  * Configures the formats of all the links in the graph.
+ *
+ * Where several formats are acceptable for a link, the one minimizing
+ * the cost of the format conversions done through the whole graph is
+ * chosen, taking into account colorspace changes, bit depth loss and
+ * chroma subsampling changes.
  */
 int avfilter_graph_config_formats(AVFilterGraph *graphctx, AVClass *log_ctx);
 
+/**
+ * Enables or disables the collection of profiling statistics for all the
+ * filters of the graph and their links. Enabling it resets the
+ * statistics, see AVFilterStats and AVFilterLinkStats.
+ * Filters added to the graph afterwards are not profiled.
+ */
+void avfilter_graph_set_profiling(AVFilterGraph *graph, int enable);
+
+/**
+ * Prints the profiling statistics of the filters of the graph and of
+ * their links, with the share of the total time spent in each filter.
+ */
+void avfilter_graph_dump_stats(AVFilterGraph *graph, void *log_ctx);
+
 /**
  * Frees a graph and destroys its links.
  */
@@ -55,6 +55,10 @@ AVFilterPicRef *avfilter_default_get_video_buffer(AVFilterLink *link, int perms,
         pic->linesize[i] = FFALIGN(pic->linesize[i], 16);
 
     tempsize = ff_fill_pointer((AVPicture *)pic, NULL, pic->format, ref->h);
+    if(link->src && link->src->profiling) {
+        link->stats.buffer_bytes      += tempsize;
+        link->src->stats.buffer_bytes += tempsize;
+    }
     buf = av_malloc(tempsize + 16); // +2 is needed for swscaler, +16 to be
                                     // SIMD-friendly
     ff_fill_pointer((AVPicture *)pic, buf, pic->format, ref->h);
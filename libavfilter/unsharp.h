@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2002 Remi Guyomarch <rguyom@pobox.com>
+ * Copyright (C) 2010 Daniel G. Taylor <dan@programmer-art.org>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_UNSHARP_H
+#define AVFILTER_UNSHARP_H
+
+#include <stdint.h>
+
+#define MIN_SIZE 3
+#define MAX_SIZE 13
+
+/** number of extra elements allocated past the end of each line buffer,
+ *  so that SIMD code may process whole vectors */
+#define UNSHARP_PADDING 8
+
+typedef struct FilterParam {
+    int msize_x;                             ///< matrix width
+    int msize_y;                             ///< matrix height
+    int amount;                              ///< effect amount
+    int steps_x;                             ///< horizontal step count
+    int steps_y;                             ///< vertical step count
+    int scalebits;                           ///< bits to shift pixel
+    uint32_t *sc[(MAX_SIZE * MAX_SIZE) - 1]; ///< finite state machine storage
+    uint32_t *line;                          ///< horizontal pass line buffer
+} FilterParam;
+
+typedef struct UnsharpContext {
+    FilterParam luma;   ///< luma parameters (width, height, amount)
+    FilterParam chroma; ///< chroma parameters (width, height, amount)
+
+    /**
+     * One stage of the horizontal blur: buf[x] += buf[x + 1] for 0 <= x < len.
+     * buf must be 16-byte aligned and padded by UNSHARP_PADDING elements.
+     */
+    void (*hsum)(uint32_t *buf, int len);
+
+    /**
+     * Vertical blur: push one horizontally blurred line through the state
+     * machine, i.e. for each 0 <= z < nb_states and 0 <= x < width:
+     * tmp = state[z][x] + sum[x]; state[z][x] = sum[x]; sum[x] = tmp.
+     * All buffers must be 16-byte aligned and padded by UNSHARP_PADDING
+     * elements.
+     */
+    void (*vsum)(uint32_t *sum, uint32_t **state, int nb_states, int width);
+
+    /**
+     * Blend a line of blurred sums with the source pixels.
+     * @param blur      blurred line, scaled by 1 << scalebits, 16-byte aligned
+     * @param amount    effect amount in 16.16 fixed point
+     */
+    void (*sharpen)(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                    int width, int amount, int scalebits);
+} UnsharpContext;
+
+void ff_unsharp_init_x86(UnsharpContext *unsharp);
+
+#endif /* AVFILTER_UNSHARP_H */
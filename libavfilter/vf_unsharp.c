@@ -37,38 +37,64 @@
  */
 
 #include "avfilter.h"
+#include "unsharp.h"
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
 #include "libavutil/pixdesc.h"
 
-#define MIN_SIZE 3
-#define MAX_SIZE 13
-
 #define CHROMA_WIDTH(link)  -((-link->w) >> av_pix_fmt_descriptors[link->format].log2_chroma_w)
 #define CHROMA_HEIGHT(link) -((-link->h) >> av_pix_fmt_descriptors[link->format].log2_chroma_h)
 
-typedef struct FilterParam {
-    int msize_x;                             ///< matrix width
-    int msize_y;                             ///< matrix height
-    int amount;                              ///< effect amount
-    int steps_x;                             ///< horizontal step count
-    int steps_y;                             ///< vertical step count
-    int scalebits;                           ///< bits to shift pixel
-    int32_t halfscale;                       ///< amount to add to pixel
-    uint32_t *sc[(MAX_SIZE * MAX_SIZE) - 1]; ///< finite state machine storage
-} FilterParam;
-
-typedef struct {
-    FilterParam luma;   ///< luma parameters (width, height, amount)
-    FilterParam chroma; ///< chroma parameters (width, height, amount)
-} UnsharpContext;
-
-static void unsharpen(uint8_t *dst, uint8_t *src, int dst_stride, int src_stride, int width, int height, FilterParam *fp)
+static void hsum_c(uint32_t *buf, int len)
+{
+    int x;
+
+    for (x = 0; x < len; x++)
+        buf[x] += buf[x + 1];
+}
+
+static void vsum_c(uint32_t *sum, uint32_t **state, int nb_states, int width)
 {
-    uint32_t **sc = fp->sc;
-    uint32_t sr[(MAX_SIZE * MAX_SIZE) - 1], tmp1, tmp2;
+    uint32_t tmp;
+    int x, z;
+
+    for (z = 0; z < nb_states; z++) {
+        for (x = 0; x < width; x++) {
+            tmp         = state[z][x] + sum[x];
+            state[z][x] = sum[x];
+            sum[x]      = tmp;
+        }
+    }
+}
 
+static void sharpen_c(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                      int width, int amount, int scalebits)
+{
+    const uint32_t halfscale = 1 << (scalebits - 1);
     int32_t res;
+    int x;
+
+    for (x = 0; x < width; x++) {
+        res = (int32_t)src[x] + ((((int32_t)src[x] - (int32_t)((blur[x] + halfscale) >> scalebits)) * amount) >> 16);
+        dst[x] = av_clip_uint8(res);
+    }
+}
+
+/**
+ * Apply the blur / sharpen matrix to one plane.
+ *
+ * The finite state machine is run separably: each source line is first
+ * blurred horizontally into fp->line by 2 * steps_x passes of pairwise sums
+ * over the edge-replicated line, then pushed through the 2 * steps_y vertical
+ * state rows fp->sc[], which hold the partial sums of the preceding lines.
+ * Once steps_y lines of lookahead have been consumed, fp->line holds the
+ * fully blurred line and is blended with the source.
+ */
+static void unsharpen(UnsharpContext *unsharp, uint8_t *dst, uint8_t *src,
+                      int dst_stride, int src_stride, int width, int height, FilterParam *fp)
+{
+    uint32_t *line = fp->line;
+    uint8_t *srx;
     int x, y, z;
 
     if (!fp->amount) {
@@ -80,33 +106,27 @@ static void unsharpen(uint8_t *dst, uint8_t *src, int dst_stride, int src_stride
         return;
     }
 
-    for (y = 0; y < 2 * fp->steps_y; y++)
-        memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * fp->steps_x));
-
-    for (y =- fp->steps_y; y < height + fp->steps_y; y++) {
-        memset(sr, 0, sizeof(sr[0]) * (2 * fp->steps_x - 1));
-        for (x =- fp->steps_x; x < width + fp->steps_x; x++) {
-            tmp1 = x <= 0 ? src[0] : x >= width ? src[width-1] : src[x];
-            for (z = 0; z < fp->steps_x * 2; z += 2) {
-                tmp2 = sr[z + 0] + tmp1; sr[z + 0] = tmp1;
-                tmp1 = sr[z + 1] + tmp2; sr[z + 1] = tmp2;
-            }
-            for (z = 0; z < fp->steps_y * 2; z += 2) {
-                tmp2 = sc[z + 0][x + fp->steps_x] + tmp1; sc[z + 0][x + fp->steps_x] = tmp1;
-                tmp1 = sc[z + 1][x + fp->steps_x] + tmp2; sc[z + 1][x + fp->steps_x] = tmp2;
-            }
-            if (x >= fp->steps_x && y >= fp->steps_y) {
-                uint8_t* srx = src - fp->steps_y * src_stride + x - fp->steps_x;
-                uint8_t* dsx = dst - fp->steps_y * dst_stride + x - fp->steps_x;
-
-                res = (int32_t)*srx + ((((int32_t) * srx - (int32_t)((tmp1 + fp->halfscale) >> fp->scalebits)) * fp->amount) >> 16);
-                *dsx = av_clip_uint8(res);
-            }
-        }
-        if (y >= 0) {
-            dst += dst_stride;
-            src += src_stride;
+    for (z = 0; z < 2 * fp->steps_y; z++)
+        memset(fp->sc[z], 0, sizeof(fp->sc[z][0]) * width);
+
+    for (y = -fp->steps_y; y < height + fp->steps_y; y++) {
+        srx = src + av_clip(y, 0, height - 1) * src_stride;
+
+        for (x = 0; x < fp->steps_x; x++) {
+            line[x]                       = srx[0];
+            line[x + width + fp->steps_x] = srx[width - 1];
         }
+        for (x = 0; x < width; x++)
+            line[x + fp->steps_x] = srx[x];
+
+        for (z = 0; z < 2 * fp->steps_x; z++)
+            unsharp->hsum(line, width + 2 * fp->steps_x - 1 - z);
+        unsharp->vsum(line, fp->sc, 2 * fp->steps_y, width);
+
+        if (y >= fp->steps_y)
+            unsharp->sharpen(dst + (y - fp->steps_y) * dst_stride,
+                             src + (y - fp->steps_y) * src_stride,
+                             line, width, fp->amount, fp->scalebits);
     }
 }
 
@@ -119,7 +139,6 @@ static void set_filter_param(FilterParam *fp, int msize_x, int msize_y, double a
     fp->steps_x = msize_x / 2;
     fp->steps_y = msize_y / 2;
     fp->scalebits = (fp->steps_x + fp->steps_y) * 2;
-    fp->halfscale = 1 << (fp->scalebits - 1);
 }
 
 static av_cold int init(AVFilterContext *ctx, const char *args, void *opaque)
@@ -136,6 +155,12 @@ static av_cold int init(AVFilterContext *ctx, const char *args, void *opaque)
     set_filter_param(&unsharp->luma,   lmsize_x, lmsize_y, lamount);
     set_filter_param(&unsharp->chroma, cmsize_x, cmsize_y, camount);
 
+    unsharp->hsum    = hsum_c;
+    unsharp->vsum    = vsum_c;
+    unsharp->sharpen = sharpen_c;
+    if (HAVE_MMX)
+        ff_unsharp_init_x86(unsharp);
+
     return 0;
 }
 
@@ -163,7 +188,8 @@ static void init_filter_param(AVFilterContext *ctx, FilterParam *fp, const char
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
     for (z = 0; z < 2 * fp->steps_y; z++)
-        fp->sc[z] = av_malloc(sizeof(*(fp->sc[z])) * (width + 2 * fp->steps_x));
+        fp->sc[z] = av_malloc(sizeof(*(fp->sc[z])) * (width + UNSHARP_PADDING));
+    fp->line = av_mallocz(sizeof(*fp->line) * (width + 2 * fp->steps_x + UNSHARP_PADDING));
 }
 
 static int config_props(AVFilterLink *link)
@@ -182,6 +208,7 @@ static void free_filter_param(FilterParam *fp)
 
     for (z = 0; z < 2 * fp->steps_y; z++)
         av_free(fp->sc[z]);
+    av_free(fp->line);
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -198,9 +225,9 @@ static void end_frame(AVFilterLink *link)
     AVFilterPicRef *in  = link->cur_pic;
     AVFilterPicRef *out = link->dst->outputs[0]->outpic;
 
-    unsharpen(out->data[0], in->data[0], out->linesize[0], in->linesize[0], link->w,            link->h,             &unsharp->luma);
-    unsharpen(out->data[1], in->data[1], out->linesize[1], in->linesize[1], CHROMA_WIDTH(link), CHROMA_HEIGHT(link), &unsharp->chroma);
-    unsharpen(out->data[2], in->data[2], out->linesize[2], in->linesize[2], CHROMA_WIDTH(link), CHROMA_HEIGHT(link), &unsharp->chroma);
+    unsharpen(unsharp, out->data[0], in->data[0], out->linesize[0], in->linesize[0], link->w,            link->h,             &unsharp->luma);
+    unsharpen(unsharp, out->data[1], in->data[1], out->linesize[1], in->linesize[1], CHROMA_WIDTH(link), CHROMA_HEIGHT(link), &unsharp->chroma);
+    unsharpen(unsharp, out->data[2], in->data[2], out->linesize[2], in->linesize[2], CHROMA_WIDTH(link), CHROMA_HEIGHT(link), &unsharp->chroma);
 
     avfilter_unref_pic(in);
     avfilter_draw_slice(link->dst->outputs[0], 0, link->h, 1);
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2006-2010 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * @file
+ * yadif (yet another deinterlacing filter)
+ * motion adaptive deinterlacer, interpolating the missing lines of each
+ * field from a spatial prediction clamped by the temporal neighbours
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "yadif.h"
+
+typedef struct ThreadData {
+    YADIFContext *yadif;
+    AVFilterPicRef *dstpic;
+    int parity;
+    int tff;
+} ThreadData;
+
+#define CHECK(j)\
+    {   int score = FFABS(cur[mrefs-1+(j)] - cur[prefs-1-(j)])\
+                  + FFABS(cur[mrefs  +(j)] - cur[prefs  -(j)])\
+                  + FFABS(cur[mrefs+1+(j)] - cur[prefs+1-(j)]);\
+        if (score < spatial_score) {\
+            spatial_score= score;\
+            spatial_pred= (cur[mrefs  +(j)] + cur[prefs  -(j)])>>1;\
+
+/* The spatial check reads 3 pixels left and right of the current one,
+ * so it is skipped for the pixels at the edges of the line. */
+#define FILTER(start, end, is_not_edge) \
+    for (x = start; x < end; x++) { \
+        int c = cur[mrefs]; \
+        int d = (prev2[0] + next2[0])>>1; \
+        int e = cur[prefs]; \
+        int temporal_diff0 = FFABS(prev2[0] - next2[0]); \
+        int temporal_diff1 =(FFABS(prev[mrefs] - c) + FFABS(prev[prefs] - e) )>>1; \
+        int temporal_diff2 =(FFABS(next[mrefs] - c) + FFABS(next[prefs] - e) )>>1; \
+        int diff = FFMAX3(temporal_diff0>>1, temporal_diff1, temporal_diff2); \
+        int spatial_pred = (c+e)>>1; \
+ \
+        if (is_not_edge) { \
+            int spatial_score = FFABS(cur[mrefs-1] - cur[prefs-1]) + FFABS(c-e) \
+                              + FFABS(cur[mrefs+1] - cur[prefs+1]) - 1; \
+            CHECK(-1) CHECK(-2) }} }} \
+            CHECK( 1) CHECK( 2) }} }} \
+        } \
+ \
+        if (mode < 2) { \
+            int b = (prev2[2*mrefs] + next2[2*mrefs])>>1; \
+            int f = (prev2[2*prefs] + next2[2*prefs])>>1; \
+            int max = FFMAX3(d-e, d-c, FFMIN(b-c, f-e)); \
+            int min = FFMIN3(d-e, d-c, FFMAX(b-c, f-e)); \
+ \
+            diff = FFMAX3(diff, min, -max); \
+        } \
+ \
+        if (spatial_pred > d + diff) \
+           spatial_pred = d + diff; \
+        else if (spatial_pred < d - diff) \
+           spatial_pred = d - diff; \
+ \
+        dst[0] = spatial_pred; \
+ \
+        dst++; \
+        cur++; \
+        prev++; \
+        next++; \
+        prev2++; \
+        next2++; \
+    }
+
+void ff_yadif_filter_line_c(uint8_t *dst,
+                            uint8_t *prev, uint8_t *cur, uint8_t *next,
+                            int w, int prefs, int mrefs, int parity, int mode)
+{
+    uint8_t *prev2 = parity ? prev : cur ;
+    uint8_t *next2 = parity ? cur  : next;
+    int x;
+
+    FILTER(0, w, 1)
+}
+
+static void filter_edges(uint8_t *dst,
+                         uint8_t *prev, uint8_t *cur, uint8_t *next,
+                         int w, int prefs, int mrefs, int parity, int mode)
+{
+    uint8_t *prev2 = parity ? prev : cur ;
+    uint8_t *next2 = parity ? cur  : next;
+    int x, skip;
+
+    FILTER(0, FFMIN(3, w), 0)
+
+    skip = w - 6;
+    if (skip > 0) {
+        dst   += skip;
+        prev  += skip;
+        cur   += skip;
+        next  += skip;
+        prev2 += skip;
+        next2 += skip;
+    }
+
+    FILTER(FFMAX(3, w - 3), w, 0)
+}
+
+static int filter_slice(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    ThreadData *td = arg;
+    YADIFContext *yadif = td->yadif;
+    AVFilterPicRef *dstpic = td->dstpic;
+    int y, i;
+
+    for (i = 0; i < 3 && dstpic->data[i]; i++) {
+        int w = i ? -((-dstpic->w) >> yadif->hsub) : dstpic->w;
+        int h = i ? -((-dstpic->h) >> yadif->vsub) : dstpic->h;
+        int refs = yadif->cur->linesize[i];
+        int slice_start = h *  jobnr      / yadif->thread_count;
+        int slice_end   = h * (jobnr + 1) / yadif->thread_count;
+
+        for (y = slice_start; y < slice_end; y++) {
+            uint8_t *dst = &dstpic->data[i][y * dstpic->linesize[i]];
+            uint8_t *cur = &yadif->cur->data[i][y * refs];
+
+            if ((y ^ td->parity) & 1) {
+                uint8_t *prev = &yadif->prev->data[i][y * refs];
+                uint8_t *next = &yadif->next->data[i][y * refs];
+                /* mirror at the top and bottom edges, a single line
+                 * plane has no neighbour to mirror to */
+                int prefs = y + 1 < h ? refs : y ? -refs : 0;
+                int mrefs = y         ? -refs : h > 1 ? refs : 0;
+                int mode  = y == 1 || y + 2 == h ? 2 : yadif->mode;
+                int parity = td->parity ^ td->tff;
+
+                filter_edges(dst, prev, cur, next, w, prefs, mrefs, parity, mode);
+                if (w > 6)
+                    yadif->filter_line(dst + 3, prev + 3, cur + 3, next + 3,
+                                       w - 6, prefs, mrefs, parity, mode);
+            } else {
+                memcpy(dst, cur, w);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static void filter(AVFilterContext *ctx, AVFilterPicRef *dstpic,
+                   int parity, int tff)
+{
+    YADIFContext *yadif = ctx->priv;
+    ThreadData td = { yadif, dstpic, parity, tff };
+
+    yadif->avctx->execute2(yadif->avctx, filter_slice, &td, NULL,
+                           yadif->thread_count);
+}
+
+static void return_frame(AVFilterContext *ctx, int is_second)
+{
+    YADIFContext *yadif = ctx->priv;
+    AVFilterLink *link  = ctx->outputs[0];
+    int tff;
+
+    if (yadif->parity == -1) {
+        tff = yadif->cur->interlaced ?
+              yadif->cur->top_field_first : 1;
+    } else {
+        tff = yadif->parity ^ 1;
+    }
+
+    if (is_second) {
+        yadif->out = avfilter_get_video_buffer(link, AV_PERM_WRITE | AV_PERM_PRESERVE |
+                                               AV_PERM_REUSE, link->w, link->h);
+        yadif->out->pixel_aspect    = yadif->cur->pixel_aspect;
+        yadif->out->pos             = -1;
+        yadif->out->interlaced      = 0;
+        yadif->out->top_field_first = 0;
+    }
+
+    filter(ctx, yadif->out, tff ^ !is_second, tff);
+
+    if (is_second) {
+        if (yadif->next->pts != AV_NOPTS_VALUE &&
+            yadif->cur ->pts != AV_NOPTS_VALUE) {
+            yadif->out->pts =
+                (yadif->next->pts & yadif->cur->pts) +
+                ((yadif->next->pts ^ yadif->cur->pts) >> 1);
+        } else {
+            yadif->out->pts = AV_NOPTS_VALUE;
+        }
+        avfilter_start_frame(link, avfilter_ref_pic(yadif->out, ~0));
+    }
+    avfilter_draw_slice(link, 0, link->h, 1);
+    avfilter_end_frame(link);
+
+    avfilter_unref_pic(yadif->out);
+    yadif->out = NULL;
+
+    yadif->frame_pending = (yadif->mode & 1) && !is_second;
+}
+
+static void start_frame(AVFilterLink *link, AVFilterPicRef *picref)
+{
+    AVFilterContext *ctx = link->dst;
+    YADIFContext *yadif = ctx->priv;
+
+    if (yadif->frame_pending)
+        return_frame(ctx, 1);
+
+    if (yadif->prev)
+        avfilter_unref_pic(yadif->prev);
+    yadif->prev = yadif->cur;
+    yadif->cur  = yadif->next;
+    yadif->next = picref;
+
+    if (!yadif->cur)
+        return;
+
+    if (!yadif->prev)
+        yadif->prev = avfilter_ref_pic(yadif->cur, AV_PERM_READ);
+
+    yadif->out = avfilter_get_video_buffer(ctx->outputs[0], AV_PERM_WRITE | AV_PERM_PRESERVE |
+                                           AV_PERM_REUSE, link->w, link->h);
+
+    yadif->out->pts             = yadif->cur->pts;
+    yadif->out->pos             = yadif->cur->pos;
+    yadif->out->pixel_aspect    = yadif->cur->pixel_aspect;
+    yadif->out->interlaced      = 0;
+    yadif->out->top_field_first = 0;
+    avfilter_start_frame(ctx->outputs[0], avfilter_ref_pic(yadif->out, ~0));
+}
+
+static void end_frame(AVFilterLink *link)
+{
+    AVFilterContext *ctx = link->dst;
+    YADIFContext *yadif = ctx->priv;
+
+    if (!yadif->out)
+        return;
+
+    return_frame(ctx, 0);
+}
+
+static int request_frame(AVFilterLink *link)
+{
+    AVFilterContext *ctx = link->src;
+    YADIFContext *yadif = ctx->priv;
+
+    if (yadif->frame_pending) {
+        return_frame(ctx, 1);
+        return 0;
+    }
+
+    do {
+        int ret;
+
+        if ((ret = avfilter_request_frame(link->src->inputs[0])))
+            return ret;
+    } while (!yadif->cur);
+
+    return 0;
+}
+
+static int poll_frame(AVFilterLink *link)
+{
+    YADIFContext *yadif = link->src->priv;
+    int ret, val;
+
+    if (yadif->frame_pending)
+        return 1;
+
+    val = avfilter_poll_frame(link->src->inputs[0]);
+
+    if (val == 1 && !yadif->next) {
+        /* the first frame is only buffered, ask for the next one */
+        if ((ret = avfilter_request_frame(link->src->inputs[0])) < 0)
+            return ret;
+        val = avfilter_poll_frame(link->src->inputs[0]);
+    }
+
+    return val * ((yadif->mode & 1) + 1);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    YADIFContext *yadif = ctx->priv;
+
+    if (yadif->prev) avfilter_unref_pic(yadif->prev);
+    if (yadif->cur ) avfilter_unref_pic(yadif->cur );
+    if (yadif->next) avfilter_unref_pic(yadif->next);
+
+    if (yadif->avctx) {
+        if (HAVE_THREADS && yadif->avctx->thread_opaque)
+            avcodec_thread_free(yadif->avctx);
+        av_freep(&yadif->avctx);
+    }
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum PixelFormat pix_fmts[] = {
+        PIX_FMT_YUV420P,
+        PIX_FMT_YUV422P,
+        PIX_FMT_YUV444P,
+        PIX_FMT_YUV410P,
+        PIX_FMT_YUV411P,
+        PIX_FMT_GRAY8,
+        PIX_FMT_YUVJ420P,
+        PIX_FMT_YUVJ422P,
+        PIX_FMT_YUVJ444P,
+        PIX_FMT_YUV440P,
+        PIX_FMT_YUVJ440P,
+        PIX_FMT_NONE
+    };
+
+    avfilter_set_common_formats(ctx, avfilter_make_format_list(pix_fmts));
+
+    return 0;
+}
+
+static av_cold int init(AVFilterContext *ctx, const char *args, void *opaque)
+{
+    YADIFContext *yadif = ctx->priv;
+
+    yadif->mode         = 0;
+    yadif->parity       = -1;
+    yadif->thread_count = 1;
+
+    if (args)
+        sscanf(args, "%d:%d:%d", &yadif->mode, &yadif->parity, &yadif->thread_count);
+
+    if (yadif->mode < 0 || yadif->mode > 3 ||
+        yadif->parity < -1 || yadif->parity > 1 || yadif->thread_count < 1) {
+        av_log(ctx, AV_LOG_ERROR, "Invalid arguments '%s'\n", args);
+        return AVERROR(EINVAL);
+    }
+
+    yadif->avctx = avcodec_alloc_context();
+    if (!yadif->avctx)
+        return AVERROR(ENOMEM);
+    if (yadif->thread_count > 1 &&
+        avcodec_thread_init(yadif->avctx, yadif->thread_count) < 0) {
+        av_log(ctx, AV_LOG_WARNING,
+               "Slice threading is not available, using a single thread\n");
+        yadif->thread_count = 1;
+    }
+
+    yadif->filter_line = ff_yadif_filter_line_c;
+    if (HAVE_MMX)
+        ff_yadif_init_x86(yadif);
+
+    av_log(ctx, AV_LOG_INFO, "mode:%d parity:%d threads:%d\n",
+           yadif->mode, yadif->parity, yadif->thread_count);
+
+    return 0;
+}
+
+static int config_props(AVFilterLink *link)
+{
+    YADIFContext *yadif = link->dst->priv;
+
+    yadif->hsub = av_pix_fmt_descriptors[link->format].log2_chroma_w;
+    yadif->vsub = av_pix_fmt_descriptors[link->format].log2_chroma_h;
+
+    return 0;
+}
+
+static void null_draw_slice(AVFilterLink *link, int y, int h, int slice_dir) { }
+
+AVFilter avfilter_vf_yadif = {
+    .name          = "yadif",
+    .description   = NULL_IF_CONFIG_SMALL("Deinterlace the input image."),
+
+    .priv_size     = sizeof(YADIFContext),
+    .init          = init,
+    .uninit        = uninit,
+    .query_formats = query_formats,
+
+    .inputs    = (AVFilterPad[]) {{ .name             = "default",
+                                    .type             = AVMEDIA_TYPE_VIDEO,
+                                    .start_frame      = start_frame,
+                                    .draw_slice       = null_draw_slice,
+                                    .end_frame        = end_frame,
+                                    .config_props     = config_props,
+                                    .min_perms        = AV_PERM_READ | AV_PERM_PRESERVE,
+                                    .rej_perms        = AV_PERM_REUSE2, },
+                                  { .name = NULL}},
+
+    .outputs   = (AVFilterPad[]) {{ .name             = "default",
+                                    .type             = AVMEDIA_TYPE_VIDEO,
+                                    .poll_frame       = poll_frame,
+                                    .request_frame    = request_frame, },
+                                  { .name = NULL}},
+};
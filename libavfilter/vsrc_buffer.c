@@ -19,22 +19,150 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "libavutil/pixdesc.h"
 #include "avfilter.h"
 #include "vsrc_buffer.h"
 
+#define MAX_DR1_BUFFERS 32
+
 typedef struct {
     int64_t           pts;
     AVFrame           frame;
     int               has_frame;
     int               h, w, pix_fmt;
     AVRational        pixel_aspect;
+    int               use_dr1;      ///< the decoder renders into our buffers
+    AVFilterPicRef   *picref;       ///< directly rendered picture to pass on
+    AVFilterPicRef   *dr1_refs[MAX_DR1_BUFFERS]; ///< buffers held by the decoder
+    /** extra reference to the latest buffer given to the decoder, some
+     * decoders (e.g. ffv1) release it before the frame is output */
+    AVFilterPicRef   *last_ref;
 } BufferSourceContext;
 
+static int dr1_get_buffer(AVCodecContext *codec, AVFrame *pic)
+{
+    AVFilterContext *ctx  = codec->opaque;
+    AVFilterLink    *link = ctx->outputs[0];
+    BufferSourceContext *c = ctx->priv;
+    AVFilterPicRef  *ref;
+    int perms = AV_PERM_WRITE;
+    int i, slot, w, h, stride[4];
+    unsigned edge;
+
+    for(slot = 0; slot < MAX_DR1_BUFFERS && c->dr1_refs[slot]; slot++);
+
+    /* the graph has been configured for other picture properties, let
+     * libavcodec allocate the frame and copy it in av_vsrc_buffer_add_frame() */
+    if(codec->width != link->w || codec->height != link->h ||
+       codec->pix_fmt != link->format || slot == MAX_DR1_BUFFERS)
+        return avcodec_default_get_buffer(codec, pic);
+
+    if(pic->buffer_hints & FF_BUFFER_HINTS_VALID) {
+        if(pic->buffer_hints & FF_BUFFER_HINTS_READABLE) perms |= AV_PERM_READ;
+        if(pic->buffer_hints & FF_BUFFER_HINTS_PRESERVE) perms |= AV_PERM_PRESERVE;
+        if(pic->buffer_hints & FF_BUFFER_HINTS_REUSABLE) perms |= AV_PERM_REUSE2;
+    }
+    /* the decoder does not write into a picture anymore once it has been
+     * output, unless it reuses the buffer */
+    if(!(perms & AV_PERM_REUSE2)) perms |= AV_PERM_PRESERVE;
+    if(pic->reference) perms |= AV_PERM_READ | AV_PERM_PRESERVE;
+
+    w = codec->width;
+    h = codec->height;
+    avcodec_align_dimensions2(codec, &w, &h, stride);
+    edge = codec->flags & CODEC_FLAG_EMU_EDGE ? 0 : avcodec_get_edge_width();
+    w += edge << 1;
+    h += edge << 1;
+
+    if(!(ref = avfilter_get_video_buffer(link, perms, w, h)))
+        return -1;
+
+    ref->w = codec->width;
+    ref->h = codec->height;
+    for(i = 0; i < 4; i ++) {
+        unsigned hshift = i == 0 ? 0 : av_pix_fmt_descriptors[ref->pic->format].log2_chroma_w;
+        unsigned vshift = i == 0 ? 0 : av_pix_fmt_descriptors[ref->pic->format].log2_chroma_h;
+
+        if(ref->data[i])
+            ref->data[i] += (edge >> hshift) + ((edge * ref->linesize[i]) >> vshift);
+        pic->data[i]     = ref->data[i];
+        pic->linesize[i] = ref->linesize[i];
+    }
+    c->dr1_refs[slot] = ref;
+    if(c->last_ref)
+        avfilter_unref_pic(c->last_ref);
+    c->last_ref = avfilter_ref_pic(ref, ~0);
+
+    pic->opaque = ref;
+    pic->age    = INT_MAX;
+    pic->type   = FF_BUFFER_TYPE_USER;
+    pic->reordered_opaque = codec->reordered_opaque;
+    return 0;
+}
+
+static void dr1_release_buffer(AVCodecContext *codec, AVFrame *pic)
+{
+    AVFilterContext *ctx = codec->opaque;
+    BufferSourceContext *c = ctx->priv;
+    int i;
+
+    if(pic->type != FF_BUFFER_TYPE_USER) {
+        avcodec_default_release_buffer(codec, pic);
+        return;
+    }
+
+    for(i = 0; i < MAX_DR1_BUFFERS; i++)
+        if(c->dr1_refs[i] == pic->opaque)
+            c->dr1_refs[i] = NULL;
+    memset(pic->data, 0, sizeof(pic->data));
+    avfilter_unref_pic(pic->opaque);
+}
+
+static int dr1_reget_buffer(AVCodecContext *codec, AVFrame *pic)
+{
+    AVFilterPicRef *ref = pic->opaque;
+
+    if(pic->data[0] == NULL) {
+        pic->buffer_hints |= FF_BUFFER_HINTS_READABLE;
+        return codec->get_buffer(codec, pic);
+    }
+
+    if(pic->type != FF_BUFFER_TYPE_USER)
+        return avcodec_default_reget_buffer(codec, pic);
+
+    if(codec->width != ref->w || codec->height != ref->h ||
+       codec->pix_fmt != ref->pic->format) {
+        av_log(codec, AV_LOG_ERROR, "Picture properties changed.\n");
+        return -1;
+    }
+
+    pic->reordered_opaque = codec->reordered_opaque;
+    return 0;
+}
+
+int av_vsrc_buffer_set_codec(AVFilterContext *buffer_filter, AVCodecContext *codec)
+{
+    BufferSourceContext *c = buffer_filter->priv;
+
+    if(!codec->codec || !(codec->codec->capabilities & CODEC_CAP_DR1))
+        return 0;
+
+    codec->opaque         = buffer_filter;
+    codec->get_buffer     = dr1_get_buffer;
+    codec->release_buffer = dr1_release_buffer;
+    codec->reget_buffer   = dr1_reget_buffer;
+    c->use_dr1 = 1;
+
+    return 1;
+}
+
 
 int av_vsrc_buffer_add_frame(AVFilterContext *buffer_filter, AVFrame *frame,
                              int64_t pts, AVRational pixel_aspect)
 {
     BufferSourceContext *c = buffer_filter->priv;
+    AVFilterPicRef *ref = NULL;
+    int i;
 
     if (c->has_frame) {
         av_log(buffer_filter, AV_LOG_ERROR,
@@ -44,6 +172,27 @@ int av_vsrc_buffer_add_frame(AVFilterContext *buffer_filter, AVFrame *frame,
         //return -1;
     }
 
+    if (c->picref)
+        avfilter_unref_pic(c->picref);
+    c->picref = NULL;
+
+    /* hand the picture over if the decoder rendered it into one of our
+     * buffers; it may still be used as a reference, so it must not be
+     * modified in place. frame->opaque is not used for the lookup, as the
+     * decoder may already have released the buffer it points to. */
+    if (c->use_dr1 && frame->type == FF_BUFFER_TYPE_USER) {
+        if (c->last_ref && c->last_ref->data[0] == frame->data[0])
+            ref = c->last_ref;
+        for (i = 0; !ref && i < MAX_DR1_BUFFERS; i++)
+            if (c->dr1_refs[i] && c->dr1_refs[i]->data[0] == frame->data[0])
+                ref = c->dr1_refs[i];
+        if (ref)
+            c->picref = avfilter_ref_pic(ref, frame->reference ? ~AV_PERM_WRITE : ~0);
+    }
+    if (c->last_ref)
+        avfilter_unref_pic(c->last_ref);
+    c->last_ref = NULL;
+
     memcpy(c->frame.data    , frame->data    , sizeof(frame->data));
     memcpy(c->frame.linesize, frame->linesize, sizeof(frame->linesize));
     c->frame.interlaced_frame= frame->interlaced_frame;
@@ -66,6 +215,18 @@ static av_cold int init(AVFilterContext *ctx, const char *args, void *opaque)
     return -1;
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    BufferSourceContext *c = ctx->priv;
+
+    if (c->picref)
+        avfilter_unref_pic(c->picref);
+    c->picref = NULL;
+    if (c->last_ref)
+        avfilter_unref_pic(c->last_ref);
+    c->last_ref = NULL;
+}
+
 static int query_formats(AVFilterContext *ctx)
 {
     BufferSourceContext *c = ctx->priv;
@@ -97,14 +258,19 @@ static int request_frame(AVFilterLink *link)
         //return -1;
     }
 
-    /* This picture will be needed unmodified later for decoding the next
-     * frame */
-    picref = avfilter_get_video_buffer(link, AV_PERM_WRITE | AV_PERM_PRESERVE |
-                                       AV_PERM_REUSE2,
-                                       link->w, link->h);
+    if (c->picref) {
+        picref    = c->picref;
+        c->picref = NULL;
+    } else {
+        /* This picture will be needed unmodified later for decoding the next
+         * frame */
+        picref = avfilter_get_video_buffer(link, AV_PERM_WRITE | AV_PERM_PRESERVE |
+                                           AV_PERM_REUSE2,
+                                           link->w, link->h);
 
-    av_picture_copy((AVPicture *)&picref->data, (AVPicture *)&c->frame,
-                    picref->pic->format, link->w, link->h);
+        av_picture_copy((AVPicture *)&picref->data, (AVPicture *)&c->frame,
+                        picref->pic->format, link->w, link->h);
+    }
 
     picref->pts = c->pts;
     picref->pixel_aspect = c->pixel_aspect;
@@ -133,6 +299,7 @@ AVFilter avfilter_vsrc_buffer =
     .query_formats = query_formats,
 
     .init      = init,
+    .uninit    = uninit,
 
     .inputs    = (AVFilterPad[]) {{ .name = NULL }},
     .outputs   = (AVFilterPad[]) {{ .name            = "default",
@@ -19,6 +19,30 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#ifndef AVFILTER_VSRC_BUFFER_H
+#define AVFILTER_VSRC_BUFFER_H
+
+#include "libavcodec/avcodec.h"
+#include "avfilter.h"
+
+/**
+ * Adds a frame to the buffer source. If the frame was rendered by a
+ * decoder set up with av_vsrc_buffer_set_codec(), a new reference to
+ * its buffer is passed to the graph, otherwise the picture data is
+ * copied when the frame is requested.
+ */
 int av_vsrc_buffer_add_frame(AVFilterContext *buffer_filter, AVFrame *frame,
                              int64_t pts, AVRational pixel_aspect);
 
+/**
+ * Makes the decoder of codec render its frames directly into buffers
+ * allocated from the graph fed by buffer_filter, so that they can be
+ * added without copying. The output link of buffer_filter must have been
+ * configured. codec->opaque is used by the installed callbacks.
+ *
+ * @return 1 if direct rendering has been set up, 0 if the decoder lacks
+ *         CODEC_CAP_DR1, in which case added frames will be copied
+ */
+int av_vsrc_buffer_set_codec(AVFilterContext *buffer_filter, AVCodecContext *codec);
+
+#endif /* AVFILTER_VSRC_BUFFER_H */
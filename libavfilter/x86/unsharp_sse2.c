@@ -0,0 +1,152 @@
+/*
+ * SSE2-optimized functions for the unsharp filter
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/x86_cpu.h"
+#include "libavcodec/dsputil.h"
+#include "libavfilter/unsharp.h"
+
+#if HAVE_SSE
+static void hsum_sse2(uint32_t *buf, int len)
+{
+    x86_reg x = 0;
+
+    __asm__ volatile(
+        "1:                                 \n\t"
+        "movdqa     (%1,%0,4), %%xmm0       \n\t"
+        "movdqu    4(%1,%0,4), %%xmm1       \n\t"
+        "paddd         %%xmm1, %%xmm0       \n\t"
+        "movdqa        %%xmm0, (%1,%0,4)    \n\t"
+        "add               $4, %0           \n\t"
+        "cmp               %2, %0           \n\t"
+        "jl                1b               \n\t"
+        : "+r"(x)
+        : "r"(buf), "r"((x86_reg)len)
+        : "memory");
+}
+
+static void vsum_sse2(uint32_t *sum, uint32_t **state, int nb_states, int width)
+{
+    uint32_t **state_end = state + nb_states;
+    x86_reg x = 0, w = width, tmp;
+    const uint32_t *row;
+
+    if (!nb_states)
+        return;
+
+    /* run all the vertical stages on 4 columns while they are in a register */
+    __asm__ volatile(
+        "1:                                 \n\t"
+        "movdqa     (%3,%0,4), %%xmm0       \n\t"
+        "mov               %4, %1           \n\t"
+        "2:                                 \n\t"
+        "mov             (%1), %2           \n\t"
+        "movdqa     (%2,%0,4), %%xmm1       \n\t"
+        "movdqa        %%xmm0, (%2,%0,4)    \n\t"
+        "paddd         %%xmm1, %%xmm0       \n\t"
+        "add   $"PTR_SIZE", %1              \n\t"
+        "cmp               %5, %1           \n\t"
+        "jb                2b               \n\t"
+        "movdqa        %%xmm0, (%3,%0,4)    \n\t"
+        "add               $4, %0           \n\t"
+        "cmp               %6, %0           \n\t"
+        "jl                1b               \n\t"
+        : "+r"(x), "=&r"(tmp), "=&r"(row)
+        : "r"(sum), "m"(state), "m"(state_end), "m"(w)
+        : "memory");
+}
+
+/* Multiply the four dwords of reg by the four identical dwords of %%xmm5,
+ * keeping the low 32 bits of each product (SSE2 lacks pmulld). */
+#define PMULLD(reg, tmp)                                                \
+        "movdqa       "#reg", "#tmp"        \n\t"                       \
+        "psrlq            $32, "#tmp"       \n\t"                       \
+        "pmuludq       %%xmm5, "#reg"       \n\t"                       \
+        "pmuludq       %%xmm5, "#tmp"       \n\t"                       \
+        "pshufd     $8, "#reg", "#reg"      \n\t"                       \
+        "pshufd     $8, "#tmp", "#tmp"      \n\t"                       \
+        "punpckldq    "#tmp", "#reg"        \n\t"
+
+/* res = src + (((src - blur) * amount) >> 16), computed as
+ * src + (((blur - src) * -amount) >> 16) to keep src in place. */
+#define SHARPEN4(off, srcreg)                                           \
+        "movdqa "#off"(%2,%0,4), %%xmm2     \n\t"                       \
+        "paddd         %%xmm6, %%xmm2       \n\t"                       \
+        "psrld         %%xmm4, %%xmm2       \n\t"                       \
+        "psubd      "#srcreg", %%xmm2       \n\t"                       \
+        PMULLD(%%xmm2, %%xmm3)                                          \
+        "psrad            $16, %%xmm2       \n\t"                       \
+        "paddd         %%xmm2, "#srcreg"    \n\t"
+
+static void sharpen_sse2(uint8_t *dst, const uint8_t *src, const uint32_t *blur,
+                         int width, int amount, int scalebits)
+{
+    const int halfscale = 1 << (scalebits - 1);
+    const int neg_amount = -amount;
+    int w8 = width & ~7;
+    x86_reg x = -w8;
+    int32_t res;
+
+    if (w8) {
+        __asm__ volatile(
+            "pxor          %%xmm7, %%xmm7       \n\t"
+            "movd              %4, %%xmm6       \n\t"
+            "pshufd  $0, %%xmm6, %%xmm6         \n\t"
+            "movd              %5, %%xmm5       \n\t"
+            "pshufd  $0, %%xmm5, %%xmm5         \n\t"
+            "movd              %6, %%xmm4       \n\t"
+            "1:                                 \n\t"
+            "movq       (%3,%0), %%xmm0         \n\t"
+            "punpcklbw     %%xmm7, %%xmm0       \n\t"
+            "movdqa        %%xmm0, %%xmm1       \n\t"
+            "punpcklwd     %%xmm7, %%xmm0       \n\t"
+            "punpckhwd     %%xmm7, %%xmm1       \n\t"
+            SHARPEN4( 0, %%xmm0)
+            SHARPEN4(16, %%xmm1)
+            "packssdw      %%xmm1, %%xmm0       \n\t"
+            "packuswb      %%xmm0, %%xmm0       \n\t"
+            "movq          %%xmm0, (%1,%0)      \n\t"
+            "add               $8, %0           \n\t"
+            "js                1b               \n\t"
+            : "+r"(x)
+            : "r"(dst + w8), "r"(blur + w8), "r"(src + w8),
+              "m"(halfscale), "m"(neg_amount), "m"(scalebits)
+            : "memory");
+    }
+
+    for (x = w8; x < width; x++) {
+        res = (int32_t)src[x] + ((((int32_t)src[x] - (int32_t)((blur[x] + halfscale) >> scalebits)) * amount) >> 16);
+        dst[x] = av_clip_uint8(res);
+    }
+}
+#endif /* HAVE_SSE */
+
+void ff_unsharp_init_x86(UnsharpContext *unsharp)
+{
+    int mm_flags = mm_support();
+
+#if HAVE_SSE
+    if (mm_flags & FF_MM_SSE2) {
+        unsharp->hsum    = hsum_sse2;
+        unsharp->vsum    = vsum_sse2;
+        unsharp->sharpen = sharpen_sse2;
+    }
+#endif
+}
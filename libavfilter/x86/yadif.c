@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2006-2010 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "libavutil/x86_cpu.h"
+#include "libavcodec/dsputil.h"
+#include "libavcodec/x86/dsputil_mmx.h"
+#include "libavfilter/yadif.h"
+
+#if HAVE_7REGS
+
+#if HAVE_SSE
+#define ABSDIFF(a, b, t) \
+            "movdqa    "b", "t"             \n\t"\
+            "psubusw   "a", "t"             \n\t"\
+            "psubusw   "b", "a"             \n\t"\
+            "por       "t", "a"             \n\t"
+#define RENAME(a) a ## _sse2
+#include "yadif_template.c"
+#undef ABSDIFF
+#undef RENAME
+#endif
+
+#if HAVE_SSSE3
+#define ABSDIFF(a, b, t) \
+            "psubw     "b", "a"             \n\t"\
+            "pabsw     "a", "a"             \n\t"
+#define RENAME(a) a ## _ssse3
+#include "yadif_template.c"
+#undef ABSDIFF
+#undef RENAME
+#endif
+
+#endif /* HAVE_7REGS */
+
+av_cold void ff_yadif_init_x86(YADIFContext *yadif)
+{
+    int mm_flags = mm_support();
+
+#if HAVE_7REGS
+#if HAVE_SSE
+    if (mm_flags & FF_MM_SSE2)
+        yadif->filter_line = filter_line_sse2;
+#endif
+#if HAVE_SSSE3
+    if (mm_flags & FF_MM_SSSE3)
+        yadif->filter_line = filter_line_ssse3;
+#endif
+#endif
+}
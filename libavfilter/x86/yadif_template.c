@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2006-2010 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Loads 8 pixels and widens them to words; %%xmm7 must be zero. */
+#define LOAD8(mem, dst) \
+            "movq      "mem", "dst"         \n\t"\
+            "punpcklbw %%xmm7, "dst"        \n\t"
+
+#define CUR_M(off) #off"(%[cur],%[mrefs])"
+#define CUR_P(off) #off"(%[cur],%[prefs])"
+
+/* Scores the edge direction given by j (and mj == -j) in %%xmm4, with the
+ * matching prediction in %%xmm0 and the mask of the pixels where it beats
+ * the spatial score in %%xmm1, then updates the prediction in %%xmm2 and
+ * the spatial score in %%xmm3. The mask is ANDed with mask_in first, to
+ * nest the check for j = +-2 inside the one for j = +-1. */
+#define CHECK(j, mj, mask_in) \
+            LOAD8(CUR_M(j), "%%xmm5")\
+            LOAD8(CUR_P(mj), "%%xmm6")\
+            "movdqa    %%xmm5, %%xmm0       \n\t"\
+            "paddw     %%xmm6, %%xmm0       \n\t"\
+            "psrlw        $1, %%xmm0        \n\t"\
+            ABSDIFF("%%xmm5", "%%xmm6", "%%xmm1")\
+            "movdqa    %%xmm5, %%xmm4       \n\t"\
+            LOAD8(CUR_M(j-1), "%%xmm5")\
+            LOAD8(CUR_P(mj-1), "%%xmm6")\
+            ABSDIFF("%%xmm5", "%%xmm6", "%%xmm1")\
+            "paddw     %%xmm5, %%xmm4       \n\t"\
+            LOAD8(CUR_M(j+1), "%%xmm5")\
+            LOAD8(CUR_P(mj+1), "%%xmm6")\
+            ABSDIFF("%%xmm5", "%%xmm6", "%%xmm1")\
+            "paddw     %%xmm5, %%xmm4       \n\t"\
+            "movdqa    %%xmm3, %%xmm1       \n\t"\
+            "pcmpgtw   %%xmm4, %%xmm1       \n\t"\
+            mask_in\
+            "pxor      %%xmm2, %%xmm0       \n\t"\
+            "pand      %%xmm1, %%xmm0       \n\t"\
+            "pxor      %%xmm0, %%xmm2       \n\t"\
+            "pxor      %%xmm3, %%xmm4       \n\t"\
+            "pand      %%xmm1, %%xmm4       \n\t"\
+            "pxor      %%xmm4, %%xmm3       \n\t"
+
+#define SAVE_MASK "movdqu    %%xmm1, %[mask]      \n\t"
+#define AND_MASK  "pand      %[mask], %%xmm1      \n\t"
+
+/* Widens the temporal limit in %[diff] with the spatial interlacing check,
+ * leaving d in %%xmm4 and the limit in %%xmm6. */
+#define SPATIAL_INTERLACING_CHECK(prev2, next2) \
+            LOAD8("(%["prev2"],%[mrefs],2)", "%%xmm5")\
+            LOAD8("(%["next2"],%[mrefs],2)", "%%xmm0")\
+            "paddw     %%xmm0, %%xmm5       \n\t"\
+            "psrlw        $1, %%xmm5        \n\t" /* b */\
+            LOAD8("(%["prev2"],%[prefs],2)", "%%xmm6")\
+            LOAD8("(%["next2"],%[prefs],2)", "%%xmm0")\
+            "paddw     %%xmm0, %%xmm6       \n\t"\
+            "psrlw        $1, %%xmm6        \n\t" /* f */\
+            LOAD8("(%[cur],%[mrefs])", "%%xmm0") /* c */\
+            LOAD8("(%[cur],%[prefs])", "%%xmm1") /* e */\
+            "psubw     %%xmm0, %%xmm5       \n\t" /* b - c */\
+            "psubw     %%xmm1, %%xmm6       \n\t" /* f - e */\
+            "movdqu    %[d], %%xmm4         \n\t"\
+            "movdqa    %%xmm4, %%xmm3       \n\t"\
+            "psubw     %%xmm1, %%xmm3       \n\t" /* d - e */\
+            "movdqa    %%xmm4, %%xmm1       \n\t"\
+            "psubw     %%xmm0, %%xmm1       \n\t" /* d - c */\
+            "movdqa    %%xmm5, %%xmm0       \n\t"\
+            "pminsw    %%xmm6, %%xmm0       \n\t"\
+            "pmaxsw    %%xmm6, %%xmm5       \n\t"\
+            "pmaxsw    %%xmm3, %%xmm0       \n\t"\
+            "pmaxsw    %%xmm1, %%xmm0       \n\t" /* max */\
+            "pminsw    %%xmm3, %%xmm5       \n\t"\
+            "pminsw    %%xmm1, %%xmm5       \n\t" /* min */\
+            "movdqu    %[diff], %%xmm6      \n\t"\
+            "pmaxsw    %%xmm5, %%xmm6       \n\t"\
+            "pxor      %%xmm1, %%xmm1       \n\t"\
+            "psubw     %%xmm0, %%xmm1       \n\t"\
+            "pmaxsw    %%xmm1, %%xmm6       \n\t"
+
+#define NO_SPATIAL_INTERLACING_CHECK(prev2, next2) \
+            "movdqu    %[d], %%xmm4         \n\t"\
+            "movdqu    %[diff], %%xmm6      \n\t"
+
+#define FILTER(prev2, next2, mode_check) \
+    __asm__ volatile(\
+            "pxor      %%xmm7, %%xmm7       \n\t"\
+            "1:                             \n\t"\
+            /* temporal prediction d and limit diff */\
+            LOAD8("(%[cur],%[mrefs])", "%%xmm0") /* c */\
+            LOAD8("(%[cur],%[prefs])", "%%xmm1") /* e */\
+            LOAD8("(%["prev2"])", "%%xmm2")\
+            LOAD8("(%["next2"])", "%%xmm3")\
+            "movdqa    %%xmm2, %%xmm4       \n\t"\
+            ABSDIFF("%%xmm4", "%%xmm3", "%%xmm5")\
+            "psrlw        $1, %%xmm4        \n\t" /* temporal_diff0 >> 1 */\
+            "paddw     %%xmm3, %%xmm2       \n\t"\
+            "psrlw        $1, %%xmm2        \n\t"\
+            "movdqu    %%xmm2, %[d]         \n\t"\
+            LOAD8("(%[prev],%[mrefs])", "%%xmm3")\
+            ABSDIFF("%%xmm3", "%%xmm0", "%%xmm5")\
+            LOAD8("(%[prev],%[prefs])", "%%xmm5")\
+            ABSDIFF("%%xmm5", "%%xmm1", "%%xmm6")\
+            "paddw     %%xmm5, %%xmm3       \n\t"\
+            "psrlw        $1, %%xmm3        \n\t" /* temporal_diff1 */\
+            "pmaxsw    %%xmm3, %%xmm4       \n\t"\
+            LOAD8("(%[next],%[mrefs])", "%%xmm3")\
+            ABSDIFF("%%xmm3", "%%xmm0", "%%xmm5")\
+            LOAD8("(%[next],%[prefs])", "%%xmm5")\
+            ABSDIFF("%%xmm5", "%%xmm1", "%%xmm6")\
+            "paddw     %%xmm5, %%xmm3       \n\t"\
+            "psrlw        $1, %%xmm3        \n\t" /* temporal_diff2 */\
+            "pmaxsw    %%xmm3, %%xmm4       \n\t"\
+            "movdqu    %%xmm4, %[diff]      \n\t"\
+            /* spatial prediction and score */\
+            "movdqa    %%xmm0, %%xmm2       \n\t"\
+            "paddw     %%xmm1, %%xmm2       \n\t"\
+            "psrlw        $1, %%xmm2        \n\t"\
+            "movdqa    %%xmm0, %%xmm3       \n\t"\
+            ABSDIFF("%%xmm3", "%%xmm1", "%%xmm4")\
+            LOAD8(CUR_M(-1), "%%xmm4")\
+            LOAD8(CUR_P(-1), "%%xmm5")\
+            ABSDIFF("%%xmm4", "%%xmm5", "%%xmm6")\
+            "paddw     %%xmm4, %%xmm3       \n\t"\
+            LOAD8(CUR_M(1), "%%xmm4")\
+            LOAD8(CUR_P(1), "%%xmm5")\
+            ABSDIFF("%%xmm4", "%%xmm5", "%%xmm6")\
+            "paddw     %%xmm4, %%xmm3       \n\t"\
+            "pcmpeqw   %%xmm6, %%xmm6       \n\t"\
+            "paddw     %%xmm6, %%xmm3       \n\t"\
+            CHECK(-1, 1, "") SAVE_MASK\
+            CHECK(-2, 2, AND_MASK)\
+            CHECK(1, -1, "") SAVE_MASK\
+            CHECK(2, -2, AND_MASK)\
+            /* clip the spatial prediction to d +- diff */\
+            mode_check(prev2, next2)\
+            "movdqa    %%xmm4, %%xmm0       \n\t"\
+            "psubw     %%xmm6, %%xmm0       \n\t"\
+            "paddw     %%xmm6, %%xmm4       \n\t"\
+            "pmaxsw    %%xmm0, %%xmm2       \n\t"\
+            "pminsw    %%xmm4, %%xmm2       \n\t"\
+            "packuswb  %%xmm2, %%xmm2       \n\t"\
+            "movq      %%xmm2, (%[dst])     \n\t"\
+            "add          $8, %[dst]        \n\t"\
+            "add          $8, %[prev]       \n\t"\
+            "add          $8, %[cur]        \n\t"\
+            "add          $8, %[next]       \n\t"\
+            "sub          $8, %[count]      \n\t"\
+            "jg           1b                \n\t"\
+            : [dst]   "+r"(dst),\
+              [prev]  "+r"(prev),\
+              [cur]   "+r"(cur),\
+              [next]  "+r"(next),\
+              [count] "+r"(count),\
+              [d]     "+m"(tmp_d),\
+              [diff]  "+m"(tmp_diff),\
+              [mask]  "+m"(tmp_mask)\
+            : [mrefs] "r"((x86_reg)mrefs),\
+              [prefs] "r"((x86_reg)prefs)\
+            : "memory"\
+    );
+
+static void RENAME(filter_line)(uint8_t *dst,
+                                uint8_t *prev, uint8_t *cur, uint8_t *next,
+                                int w, int prefs, int mrefs, int parity, int mode)
+{
+    xmm_reg tmp_d, tmp_diff, tmp_mask;
+    x86_reg count = w & ~7;
+
+    if (count) {
+        if (parity) {
+            if (mode < 2) FILTER("prev", "cur",  SPATIAL_INTERLACING_CHECK)
+            else          FILTER("prev", "cur",  NO_SPATIAL_INTERLACING_CHECK)
+        } else {
+            if (mode < 2) FILTER("cur",  "next", SPATIAL_INTERLACING_CHECK)
+            else          FILTER("cur",  "next", NO_SPATIAL_INTERLACING_CHECK)
+        }
+    }
+
+    ff_yadif_filter_line_c(dst, prev, cur, next, w & 7, prefs, mrefs, parity, mode);
+}
+
+#undef LOAD8
+#undef CUR_M
+#undef CUR_P
+#undef CHECK
+#undef SAVE_MASK
+#undef AND_MASK
+#undef SPATIAL_INTERLACING_CHECK
+#undef NO_SPATIAL_INTERLACING_CHECK
+#undef FILTER
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2006-2010 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_YADIF_H
+#define AVFILTER_YADIF_H
+
+#include "avfilter.h"
+
+typedef struct YADIFContext {
+    /**
+     * 0: send 1 frame for each frame
+     * 1: send 1 frame for each field
+     * 2: like 0 but skips spatial interlacing check
+     * 3: like 1 but skips spatial interlacing check
+     */
+    int mode;
+
+    /**
+     * 0: top field first
+     * 1: bottom field first
+     * -1: auto-detection
+     */
+    int parity;
+
+    int frame_pending;
+
+    AVFilterPicRef *cur;
+    AVFilterPicRef *next;
+    AVFilterPicRef *prev;
+    AVFilterPicRef *out;
+
+    /**
+     * Deinterlace the w pixels of one missing line.
+     * prefs and mrefs are the byte offsets of the lines below and above,
+     * the 3 pixels left and right of the line must be readable.
+     */
+    void (*filter_line)(uint8_t *dst,
+                        uint8_t *prev, uint8_t *cur, uint8_t *next,
+                        int w, int prefs, int mrefs, int parity, int mode);
+
+    int hsub, vsub;         ///< chroma subsampling shifts
+    int thread_count;       ///< number of slice threads
+    AVCodecContext *avctx;  ///< used only for its execute2() slice threading
+} YADIFContext;
+
+void ff_yadif_filter_line_c(uint8_t *dst,
+                            uint8_t *prev, uint8_t *cur, uint8_t *next,
+                            int w, int prefs, int mrefs, int parity, int mode);
+
+void ff_yadif_init_x86(YADIFContext *yadif);
+
+#endif /* AVFILTER_YADIF_H */
@@ -518,6 +518,15 @@ void init_checksum(ByteIOContext *s,
 /* udp.c */
 int udp_set_remote_url(URLContext *h, const char *uri);
 int udp_get_local_port(URLContext *h);
+/**
+ * Send several packets to the remote address of a UDP context, with a
+ * single system call when the platform supports it.
+ *
+ * @param bufs  packets to send
+ * @param sizes sizes of the packets
+ * @return the number of packets sent, or a negative AVERROR code
+ */
+int udp_write_packets(URLContext *h, uint8_t **bufs, int *sizes, int nb_packets);
 #if (LIBAVFORMAT_VERSION_MAJOR <= 52)
 int udp_get_file_handle(URLContext *h);
 #endif
@@ -52,6 +52,7 @@ typedef struct FFMContext {
     int frame_offset;
     int64_t dts;
     uint8_t *packet_ptr, *packet_end;
+    uint8_t *page;    /* payload of the current packet, in packet or in the I/O buffer */
     uint8_t packet[FFM_PACKET_SIZE];
 } FFMContext;
 
@@ -106,7 +106,7 @@ static int ffm_read_data(AVFormatContext *s,
 {
     FFMContext *ffm = s->priv_data;
     ByteIOContext *pb = s->pb;
-    int len, fill_size, size1, frame_offset, id;
+    int len, fill_size, size1, frame_offset, id, page_size;
 
     size1 = size;
     while (size > 0) {
@@ -127,9 +127,18 @@ static int ffm_read_data(AVFormatContext *s,
             fill_size = get_be16(pb);
             ffm->dts = get_be64(pb);
             frame_offset = get_be16(pb);
-            get_buffer(pb, ffm->packet, ffm->packet_size - FFM_HEADER_SIZE);
-            ffm->packet_end = ffm->packet + (ffm->packet_size - FFM_HEADER_SIZE - fill_size);
-            if (ffm->packet_end < ffm->packet || frame_offset < 0)
+            page_size = ffm->packet_size - FFM_HEADER_SIZE;
+            if (pb->buf_end - pb->buf_ptr >= page_size) {
+                /* the whole packet is in the I/O buffer, which is not
+                   refilled before it has been consumed: use it in place */
+                ffm->page = pb->buf_ptr;
+                pb->buf_ptr += page_size;
+            } else {
+                get_buffer(pb, ffm->packet, page_size);
+                ffm->page = ffm->packet;
+            }
+            ffm->packet_end = ffm->page + (page_size - fill_size);
+            if (ffm->packet_end < ffm->page || frame_offset < 0)
                 return -1;
             /* if first packet or resynchronization packet, we must
                handle it specifically */
@@ -146,11 +155,11 @@ static int ffm_read_data(AVFormatContext *s,
                 ffm->first_packet = 0;
                 if ((frame_offset & 0x7fff) < FFM_HEADER_SIZE)
                     return -1;
-                ffm->packet_ptr = ffm->packet + (frame_offset & 0x7fff) - FFM_HEADER_SIZE;
+                ffm->packet_ptr = ffm->page + (frame_offset & 0x7fff) - FFM_HEADER_SIZE;
                 if (!header)
                     break;
             } else {
-                ffm->packet_ptr = ffm->packet;
+                ffm->packet_ptr = ffm->page;
             }
             goto redo;
         }
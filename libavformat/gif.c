@@ -44,6 +44,8 @@
 /* The GIF format uses reversed order for bitstreams... */
 /* at least they don't use PDP_ENDIAN :) */
 #define BITSTREAM_WRITER_LE
+/* the data sub-blocks are cut at whatever the bit writer has written out */
+#define BITSTREAM_WRITER_32
 
 #include "libavcodec/put_bits.h"
 
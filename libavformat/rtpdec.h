@@ -74,6 +74,13 @@ int rtp_get_local_rtp_port(URLContext *h);
 int rtp_get_local_rtcp_port(URLContext *h);
 
 int rtp_set_remote_url(URLContext *h, const char *uri);
+/**
+ * Send several RTP and RTCP packets, each kind of packet being sent
+ * with udp_write_packets() on its socket.
+ *
+ * @return the number of packets sent, or a negative AVERROR code
+ */
+int rtp_write_packets(URLContext *h, uint8_t **bufs, int *sizes, int nb_packets);
 #if (LIBAVFORMAT_VERSION_MAJOR <= 52)
 void rtp_get_file_handles(URLContext *h, int *prtp_fd, int *prtcp_fd);
 #endif
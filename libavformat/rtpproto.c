@@ -305,6 +305,25 @@ static int rtp_write(URLContext *h, uint8_t *buf, int size)
     return ret;
 }
 
+int rtp_write_packets(URLContext *h, uint8_t **bufs, int *sizes, int nb_packets)
+{
+    RTPContext *s = h->priv_data;
+    int i, n, rtcp, ret;
+
+    for (i = 0; i < nb_packets; i += n) {
+        /* send the packets going to the same socket together */
+        rtcp = bufs[i][1] >= 200 && bufs[i][1] <= 204;
+        for (n = 1; i + n < nb_packets; n++)
+            if ((bufs[i + n][1] >= 200 && bufs[i + n][1] <= 204) != rtcp)
+                break;
+        ret = udp_write_packets(rtcp ? s->rtcp_hd : s->rtp_hd,
+                                bufs + i, sizes + i, n);
+        if (ret < 0)
+            return ret;
+    }
+    return nb_packets;
+}
+
 static int rtp_close(URLContext *h)
 {
     RTPContext *s = h->priv_data;
@@ -25,6 +25,7 @@
  */
 
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for sendmmsg() */
 #include "avformat.h"
 #include <unistd.h>
 #include "internal.h"
@@ -476,6 +477,49 @@ static int udp_write(URLContext *h, uint8_t *buf, int size)
     return size;
 }
 
+#define UDP_MAX_BATCH 64
+
+int udp_write_packets(URLContext *h, uint8_t **bufs, int *sizes, int nb_packets)
+{
+#if HAVE_SENDMMSG
+    UDPContext *s = h->priv_data;
+    struct mmsghdr msgs[UDP_MAX_BATCH];
+    struct iovec iov[UDP_MAX_BATCH];
+    int i, n, ret, sent = 0;
+
+    while (sent < nb_packets) {
+        n = FFMIN(nb_packets - sent, UDP_MAX_BATCH);
+        memset(msgs, 0, n * sizeof(*msgs));
+        for (i = 0; i < n; i++) {
+            iov[i].iov_base = bufs[sent + i];
+            iov[i].iov_len  = sizes[sent + i];
+            msgs[i].msg_hdr.msg_name    = &s->dest_addr;
+            msgs[i].msg_hdr.msg_namelen = s->dest_addr_len;
+            msgs[i].msg_hdr.msg_iov     = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen  = 1;
+        }
+        ret = sendmmsg(s->udp_fd, msgs, n, 0);
+        if (ret < 0) {
+            if (ff_neterrno() != FF_NETERROR(EINTR) &&
+                ff_neterrno() != FF_NETERROR(EAGAIN))
+                return AVERROR(EIO);
+        } else {
+            sent += ret;
+        }
+    }
+    return sent;
+#else
+    int i, ret;
+
+    for (i = 0; i < nb_packets; i++) {
+        ret = udp_write(h, bufs[i], sizes[i]);
+        if (ret < 0)
+            return ret;
+    }
+    return nb_packets;
+#endif
+}
+
 static int udp_close(URLContext *h)
 {
     UDPContext *s = h->priv_data;
@@ -24,6 +24,7 @@
 #include "libavcodec/opt.h"
 #include "metadata.h"
 #include "libavutil/avstring.h"
+#include "libavutil/trace.h"
 #include "riff.h"
 #include "audiointerleave.h"
 #include <sys/time.h>
@@ -631,7 +632,9 @@ int av_read_packet(AVFormatContext *s, AVPacket *pkt)
         }
 
         av_init_packet(pkt);
+        START_TRACE
         ret= s->iformat->read_packet(s, pkt);
+        STOP_TRACE("demux", s->iformat->name)
         if (ret < 0) {
             if (!pktl || ret == AVERROR(EAGAIN))
                 return ret;
@@ -2804,7 +2807,9 @@ int av_write_frame(AVFormatContext *s, AVPacket *pkt)
     if(ret<0 && !(s->oformat->flags & AVFMT_NOTIMESTAMPS))
         return ret;
 
+    START_TRACE
     ret= s->oformat->write_packet(s, pkt);
+    STOP_TRACE("mux", s->oformat->name)
     if(!ret)
         ret= url_ferror(s->pb);
     return ret;
@@ -2921,7 +2926,9 @@ int av_interleaved_write_frame(AVFormatContext *s, AVPacket *pkt){
         if(ret<=0) //FIXME cleanup needed for ret<0 ?
             return ret;
 
+        START_TRACE
         ret= s->oformat->write_packet(s, &opkt);
+        STOP_TRACE("mux", s->oformat->name)
 
         av_free_packet(&opkt);
         pkt= NULL;
@@ -2945,7 +2952,9 @@ int av_write_trailer(AVFormatContext *s)
         if(!ret)
             break;
 
+        START_TRACE
         ret= s->oformat->write_packet(s, &pkt);
+        STOP_TRACE("mux", s->oformat->name)
 
         av_free_packet(&pkt);
 
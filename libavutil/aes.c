@@ -22,14 +22,7 @@
 
 #include "common.h"
 #include "aes.h"
-
-typedef struct AVAES{
-    // Note: round_key[16] is accessed in the init code, but this only
-    // overwrites state, which does not matter (see also r7471).
-    uint8_t round_key[15][4][4];
-    uint8_t state[2][4][4];
-    int rounds;
-}AVAES;
+#include "aes_internal.h"
 
 const int av_aes_size= sizeof(AVAES);
 
@@ -87,7 +80,7 @@ static inline void crypt(AVAES *a, int s, const uint8_t *sbox, const uint32_t *m
     subshift(a->state[0][0], s, sbox);
 }
 
-void av_aes_crypt(AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *iv, int decrypt){
+static void aes_crypt_c(AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *iv, int decrypt){
     while(count--){
         addkey(a->state[1], src, a->round_key[a->rounds]);
         if(decrypt) {
@@ -108,6 +101,38 @@ void av_aes_crypt(AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t
     }
 }
 
+static void aes_ctr_crypt_c(AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *ctr){
+    uint64_t keystream[2];
+
+    while(count--){
+        aes_crypt_c(a, (uint8_t*)keystream, ctr, 1, NULL, 0);
+        addkey(dst, src, keystream);
+        ff_aes_ctr_increment(ctr);
+        src+=16;
+        dst+=16;
+    }
+}
+
+void av_aes_crypt(AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *iv, int decrypt){
+    a->crypt(a, dst, src, count, iv, decrypt);
+}
+
+void av_aes_ctr_crypt(AVAES *a, uint8_t *dst, const uint8_t *src, int size, uint8_t *ctr){
+    uint8_t keystream[16];
+    int i;
+
+    a->ctr_crypt(a, dst, src, size>>4, ctr);
+    src += size & ~15;
+    dst += size & ~15;
+    size &= 15;
+    if(size){
+        a->crypt(a, keystream, ctr, 1, NULL, 0);
+        for(i=0; i<size; i++)
+            dst[i]= src[i] ^ keystream[i];
+        ff_aes_ctr_increment(ctr);
+    }
+}
+
 static void init_multbl2(uint8_t tbl[1024], const int c[4], const uint8_t *log8, const uint8_t *alog8, const uint8_t *sbox){
     int i, j;
     for(i=0; i<1024; i++){
@@ -154,6 +179,8 @@ int av_aes_init(AVAES *a, const uint8_t *key, int key_bits, int decrypt) {
         return -1;
 
     a->rounds= rounds;
+    a->crypt= aes_crypt_c;
+    a->ctr_crypt= aes_ctr_crypt_c;
 
     memcpy(tk, key, KC*4);
 
@@ -187,6 +214,9 @@ int av_aes_init(AVAES *a, const uint8_t *key, int key_bits, int decrypt) {
                 FFSWAP(int, a->round_key[i][0][j], a->round_key[rounds-i][0][j]);
         }
     }
+#if ARCH_X86 && HAVE_AESNI
+    ff_aes_init_x86(a);
+#endif
 
     return 0;
 }
@@ -223,6 +253,27 @@ int main(void){
                 av_log(NULL, AV_LOG_ERROR, "%d %02X %02X\n", j, rpt[i][j], temp[j]);
     }
 
+    {
+        // test vector from NIST SP 800-38A F.5.1, CTR-AES128.Encrypt
+        static const uint8_t ctr_key[16]= {
+            0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+        static const uint8_t ctr_pt[20]= {
+            0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+            0xae, 0x2d, 0x8a, 0x57};
+        static const uint8_t ctr_ct[20]= {
+            0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+            0x98, 0x06, 0xf6, 0x6b};
+        uint8_t ctr[16], out[20];
+
+        for(j=0; j<16; j++)
+            ctr[j]= 0xf0 + j;
+        av_aes_init(&b, ctr_key, 128, 0);
+        av_aes_ctr_crypt(&b, out, ctr_pt, 20, ctr);
+        for(j=0; j<20; j++)
+            if(ctr_ct[j] != out[j])
+                av_log(NULL, AV_LOG_ERROR, "ctr %d %02X %02X\n", j, ctr_ct[j], out[j]);
+    }
+
     for(i=0; i<10000; i++){
         for(j=0; j<16; j++){
             pt[j] = av_lfg_get(&prng);
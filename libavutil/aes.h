@@ -44,4 +44,16 @@ int av_aes_init(struct AVAES *a, const uint8_t *key, int key_bits, int decrypt);
  */
 void av_aes_crypt(struct AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *iv, int decrypt);
 
+/**
+ * Encrypts / decrypts in counter (CTR) mode, the context must have been
+ * initialized for encryption in both cases.
+ * @param size number of bytes, if it is not a multiple of 16 the last
+ *             partial block still uses up a whole counter value
+ * @param dst destination array, can be equal to src
+ * @param src source array, can be equal to dst
+ * @param ctr 16 byte counter block, incremented as a 128-bit big-endian
+ *            number after each block and updated on return
+ */
+void av_aes_ctr_crypt(struct AVAES *a, uint8_t *dst, const uint8_t *src, int size, uint8_t *ctr);
+
 #endif /* AVUTIL_AES_H */
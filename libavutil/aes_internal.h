@@ -0,0 +1,52 @@
+/*
+ * copyright (c) 2007 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_AES_INTERNAL_H
+#define AVUTIL_AES_INTERNAL_H
+
+#include <stdint.h>
+
+typedef struct AVAES{
+    // Note: round_key[16] is accessed in the init code, but this only
+    // overwrites state, which does not matter (see also r7471).
+    // The round keys are stored in the order they are applied in, from
+    // round_key[rounds] down to round_key[0], for both directions, with
+    // InvMixColumns applied to the inner ones of a decryption context.
+    uint8_t round_key[15][4][4];
+    uint8_t state[2][4][4];
+    int rounds;
+    /** av_aes_crypt() */
+    void (*crypt)(struct AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *iv, int decrypt);
+    /** av_aes_ctr_crypt() for count whole blocks */
+    void (*ctr_crypt)(struct AVAES *a, uint8_t *dst, const uint8_t *src, int count, uint8_t *ctr);
+}AVAES;
+
+/**
+ * Increments a 128-bit big-endian counter block.
+ */
+static inline void ff_aes_ctr_increment(uint8_t *ctr)
+{
+    int i;
+    for (i = 15; i >= 0 && !++ctr[i]; i--);
+}
+
+void ff_aes_init_x86(AVAES *a);
+
+#endif /* AVUTIL_AES_INTERNAL_H */
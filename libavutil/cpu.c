@@ -0,0 +1,41 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "cpu.h"
+
+static int cpu_flags_mask = -1;
+
+int av_get_cpu_flags(void)
+{
+    static int flags, checked;
+
+    if (checked)
+        return flags & cpu_flags_mask;
+
+#if ARCH_X86 && HAVE_MMX
+    flags = ff_get_cpu_flags_x86();
+#endif
+    checked = 1;
+    return flags & cpu_flags_mask;
+}
+
+void av_set_cpu_flags_mask(int mask)
+{
+    cpu_flags_mask = mask;
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_CPU_H
+#define AVUTIL_CPU_H
+
+/* The values of the flags up to AV_CPU_FLAG_SSE42 are the same as the
+   FF_MM_* flags of libavcodec. */
+#define AV_CPU_FLAG_MMX      0x0001 ///< standard MMX
+#define AV_CPU_FLAG_MMX2     0x0002 ///< SSE integer functions or AMD MMX ext
+#define AV_CPU_FLAG_3DNOW    0x0004 ///< AMD 3DNOW
+#define AV_CPU_FLAG_SSE      0x0008 ///< SSE functions
+#define AV_CPU_FLAG_SSE2     0x0010 ///< PIV SSE2 functions
+#define AV_CPU_FLAG_3DNOWEXT 0x0020 ///< AMD 3DNowExt
+#define AV_CPU_FLAG_SSE3     0x0040 ///< Prescott SSE3 functions
+#define AV_CPU_FLAG_SSSE3    0x0080 ///< Conroe SSSE3 functions
+#define AV_CPU_FLAG_SSE4     0x0100 ///< Penryn SSE4.1 functions
+#define AV_CPU_FLAG_SSE42    0x0200 ///< Nehalem SSE4.2 functions
+#define AV_CPU_FLAG_PCLMUL   0x0400 ///< Westmere carry-less multiplication (PCLMULQDQ)
+#define AV_CPU_FLAG_AESNI    0x0800 ///< Westmere AES instructions
+
+/**
+ * Returns the flags which specify extensions supported by the CPU and
+ * usable by the code of this build.
+ */
+int av_get_cpu_flags(void);
+
+/**
+ * Restricts the flags returned by av_get_cpu_flags() to mask.
+ * Code which has already selected its implementations is not affected,
+ * so this must be called before the contexts of interest are initialized.
+ * Meant for testing and benchmarking the C and SIMD versions against each
+ * other; -1 restores the detected flags.
+ */
+void av_set_cpu_flags_mask(int mask);
+
+/* The following CPU-specific functions shall not be called directly. */
+int ff_get_cpu_flags_x86(void);
+
+#endif /* AVUTIL_CPU_H */
@@ -21,12 +21,12 @@
 #include "config.h"
 #include "common.h"
 #include "bswap.h"
+#include "intreadwrite.h"
 #include "crc.h"
+#include "crc_internal.h"
 
-#if CONFIG_HARDCODED_TABLES
-#include "crc_data.h"
-#else
-static struct {
+#if !CONFIG_HARDCODED_TABLES || !CONFIG_SMALL
+static const struct {
     uint8_t  le;
     uint8_t  bits;
     uint32_t poly;
@@ -37,9 +37,86 @@ static struct {
     [AV_CRC_32_IEEE]    = { 0, 32, 0x04C11DB7 },
     [AV_CRC_32_IEEE_LE] = { 1, 32, 0xEDB88320 },
 };
+#endif
+
+#if CONFIG_HARDCODED_TABLES
+#include "crc_data.h"
+#else
 static AVCRC av_crc_table[AV_CRC_MAX][257];
 #endif
 
+#if !CONFIG_SMALL
+/* Faster implementations used for the standard tables: slicing by 8
+   bytes, and folding of long buffers where the CPU supports it. */
+static struct {
+    AVCRC slice[8][256];
+    CRCFoldContext fold;
+    int ready;
+} crc_fast[AV_CRC_MAX];
+
+static void crc_fast_init(AVCRCId crc_id)
+{
+    const AVCRC *ctx = av_crc_table[crc_id];
+    int i, j;
+
+    for (i = 0; i < 256; i++) {
+        crc_fast[crc_id].slice[0][i] = ctx[i];
+        for (j = 1; j < 8; j++)
+            crc_fast[crc_id].slice[j][i] = (crc_fast[crc_id].slice[j-1][i] >> 8) ^
+                                           ctx[crc_fast[crc_id].slice[j-1][i] & 0xFF];
+    }
+#if ARCH_X86 && HAVE_MMX
+    ff_crc_fold_init_x86(&crc_fast[crc_id].fold,
+                         av_crc_table_params[crc_id].le,
+                         av_crc_table_params[crc_id].bits,
+                         av_crc_table_params[crc_id].poly);
+#endif
+    crc_fast[crc_id].ready = 1;
+}
+
+static uint32_t crc_slice8(const AVCRC (*t)[256], uint32_t crc,
+                           const uint8_t *buffer, const uint8_t *end)
+{
+    while (((intptr_t) buffer & 7) && buffer < end)
+        crc = t[0][((uint8_t)crc) ^ *buffer++] ^ (crc >> 8);
+
+    while (end - buffer >= 8) {
+        uint32_t hi = AV_RL32(buffer + 4);
+        crc ^= AV_RL32(buffer);
+        crc =  t[7][ crc      & 0xFF] ^ t[6][(crc >>  8) & 0xFF]
+             ^ t[5][(crc >> 16) & 0xFF] ^ t[4][ crc >> 24        ]
+             ^ t[3][ hi       & 0xFF] ^ t[2][(hi  >>  8) & 0xFF]
+             ^ t[1][(hi  >> 16) & 0xFF] ^ t[0][ hi  >> 24        ];
+        buffer += 8;
+    }
+
+    while (buffer < end)
+        crc = t[0][((uint8_t)crc) ^ *buffer++] ^ (crc >> 8);
+
+    return crc;
+}
+
+/* below this size folding does not pay off */
+#define CRC_FOLD_MIN_SIZE 64
+
+static uint32_t crc_fast_calc(AVCRCId crc_id, uint32_t crc,
+                              const uint8_t *buffer, size_t length)
+{
+    const AVCRC (*t)[256] = crc_fast[crc_id].slice;
+
+    if (crc_fast[crc_id].fold.fold && length >= CRC_FOLD_MIN_SIZE) {
+        DECLARE_ALIGNED(16, uint8_t, folded)[16];
+        size_t size = length & ~15;
+
+        crc_fast[crc_id].fold.fold(folded, buffer, size, crc, crc_fast[crc_id].fold.k);
+        crc = crc_slice8(t, 0, folded, folded + 16);
+        buffer += size;
+        length -= size;
+    }
+    return crc_slice8(t, crc, buffer, buffer + length);
+}
+#endif
+
 /**
  * Initializes a CRC table.
  * @param ctx must be an array of size sizeof(AVCRC)*257 or sizeof(AVCRC)*1024
@@ -101,6 +178,10 @@ const AVCRC *av_crc_get_table(AVCRCId crc_id){
                         av_crc_table_params[crc_id].poly,
                         sizeof(av_crc_table[crc_id])) < 0)
             return NULL;
+#endif
+#if !CONFIG_SMALL
+    if (!crc_fast[crc_id].ready)
+        crc_fast_init(crc_id);
 #endif
     return av_crc_table[crc_id];
 }
@@ -116,6 +197,11 @@ uint32_t av_crc(const AVCRC *ctx, uint32_t crc, const uint8_t *buffer, size_t le
     const uint8_t *end= buffer+length;
 
 #if !CONFIG_SMALL
+    /* tables returned by av_crc_get_table() */
+    size_t crc_id = ((uintptr_t)ctx - (uintptr_t)av_crc_table) / sizeof(av_crc_table[0]);
+    if (crc_id < AV_CRC_MAX && ctx == av_crc_table[crc_id] && crc_fast[crc_id].ready)
+        return crc_fast_calc(crc_id, crc, buffer, length);
+
     if(!ctx[256]) {
         while(((intptr_t) buffer & 3) && buffer < end)
             crc = ctx[((uint8_t)crc) ^ *buffer++] ^ (crc >> 8);
@@ -0,0 +1,49 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_CRC_INTERNAL_H
+#define AVUTIL_CRC_INTERNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mem.h"
+
+/**
+ * Reduction of long buffers to 16 bytes with the same CRC, by folding
+ * 16 byte blocks into the following ones with carry-less multiplications.
+ */
+typedef struct CRCFoldContext {
+    /** constants for folding 64 bytes apart, then 16 bytes apart */
+    DECLARE_ALIGNED(16, uint64_t, k)[4];
+
+    /**
+     * Folds len bytes of buf, with crc xored into their first 4 bytes
+     * (as av_crc() does), into 16 bytes with the same CRC.
+     * @param len multiple of 16, at least 64
+     */
+    void (*fold)(uint8_t *out, const uint8_t *buf, size_t len, uint32_t crc,
+                 const uint64_t *k);
+} CRCFoldContext;
+
+/**
+ * Sets up folding for a CRC with the parameters of av_crc_init(), leaves
+ * fold NULL if it is not supported by the CPU or for this CRC.
+ */
+void ff_crc_fold_init_x86(CRCFoldContext *c, int le, int bits, uint32_t poly);
+
+#endif /* AVUTIL_CRC_INTERNAL_H */
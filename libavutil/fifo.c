@@ -19,8 +19,15 @@
  * License along with FFmpeg; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
+#include "config.h"
 #include "common.h"
 #include "fifo.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+#if ARCH_X86
+#include "x86_cpu.h"
+#endif
 
 AVFifoBuffer *av_fifo_alloc(unsigned int size)
 {
@@ -127,3 +134,249 @@ void av_fifo_drain(AVFifoBuffer *f, int size)
         f->rptr -= f->end - f->buffer;
     f->rndx += size;
 }
+
+#define CACHE_LINE_SIZE 64
+
+/* bits of AVRing.waiting */
+#define WAIT_READER 1
+#define WAIT_WRITER 2
+
+struct AVRing {
+    uint8_t *buffer;
+    unsigned int elem_size;
+    unsigned int nb_elems;              ///< power of 2
+    volatile int abort;
+    volatile int waiting;               ///< WAIT_* of the waiting threads, changed under mutex
+#if HAVE_PTHREADS
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+    /* keep the indices on separate cache lines so that the two threads
+       do not invalidate each other's line on every access */
+    uint8_t pad0[CACHE_LINE_SIZE];
+    volatile unsigned int wndx;         ///< free running, changed by the producer only
+    uint8_t pad1[CACHE_LINE_SIZE];
+    volatile unsigned int rndx;         ///< free running, changed by the consumer only
+    uint8_t pad2[CACHE_LINE_SIZE];
+};
+
+/* Orders the accesses to the elements with the index updates; x86 does
+   not reorder loads with loads or stores with older loads and stores. */
+#if ARCH_X86 && HAVE_INLINE_ASM
+#define ring_barrier() __asm__ volatile("" ::: "memory")
+#elif HAVE_SYNC_SYNCHRONIZE
+#define ring_barrier() __sync_synchronize()
+#else
+#define ring_barrier()
+#endif
+
+/* Orders a store with a following load, needed before deciding whether the
+   other thread has to be woken up. */
+#if HAVE_SYNC_SYNCHRONIZE
+#define ring_full_barrier() __sync_synchronize()
+#elif ARCH_X86 && HAVE_INLINE_ASM
+#define ring_full_barrier() __asm__ volatile("lock; addl $0, (%%"REG_SP")" ::: "memory")
+#else
+#define ring_full_barrier()
+#endif
+
+AVRing *av_ring_alloc(unsigned int nb_elems, unsigned int elem_size)
+{
+    AVRing *r;
+    unsigned int size = 1;
+
+    while (size < nb_elems && size <= INT_MAX / 2)
+        size <<= 1;
+    if (!elem_size || size < nb_elems || size > INT_MAX / elem_size)
+        return NULL;
+
+    r = av_mallocz(sizeof(AVRing));
+    if (!r)
+        return NULL;
+    r->buffer = av_malloc(size * elem_size);
+    if (!r->buffer) {
+        av_free(r);
+        return NULL;
+    }
+    r->elem_size = elem_size;
+    r->nb_elems  = size;
+#if HAVE_PTHREADS
+    pthread_mutex_init(&r->mutex, NULL);
+    pthread_cond_init(&r->cond, NULL);
+#endif
+    return r;
+}
+
+void av_ring_free(AVRing *r)
+{
+    if (r) {
+#if HAVE_PTHREADS
+        pthread_cond_destroy(&r->cond);
+        pthread_mutex_destroy(&r->mutex);
+#endif
+        av_free(r->buffer);
+        av_free(r);
+    }
+}
+
+int av_ring_size(AVRing *r)
+{
+    return r->wndx - r->rndx;
+}
+
+int av_ring_space(AVRing *r)
+{
+    return r->nb_elems - av_ring_size(r);
+}
+
+static void ring_wake(AVRing *r, int who)
+{
+#if HAVE_PTHREADS
+    ring_full_barrier();
+    if (r->waiting & who) {
+        pthread_mutex_lock(&r->mutex);
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->mutex);
+    }
+#endif
+}
+
+static void ring_wait(AVRing *r, int who)
+{
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&r->mutex);
+    r->waiting |= who;
+    ring_full_barrier();
+    while (!r->abort && !(who == WAIT_READER ? av_ring_size(r) : av_ring_space(r)))
+        pthread_cond_wait(&r->cond, &r->mutex);
+    r->waiting &= ~who;
+    pthread_mutex_unlock(&r->mutex);
+#endif
+}
+
+/* copy nb elements to / from ring position ndx, wrapping around the end */
+static void ring_copy_in(AVRing *r, unsigned int ndx, const uint8_t *src, int nb)
+{
+    unsigned int pos = ndx & (r->nb_elems - 1);
+    int len = FFMIN(nb, r->nb_elems - pos);
+
+    memcpy(r->buffer + pos * r->elem_size, src, len * r->elem_size);
+    memcpy(r->buffer, src + len * r->elem_size, (nb - len) * r->elem_size);
+}
+
+static void ring_copy_out(AVRing *r, unsigned int ndx, uint8_t *dst, int nb)
+{
+    unsigned int pos = ndx & (r->nb_elems - 1);
+    int len = FFMIN(nb, r->nb_elems - pos);
+
+    memcpy(dst, r->buffer + pos * r->elem_size, len * r->elem_size);
+    memcpy(dst + len * r->elem_size, r->buffer, (nb - len) * r->elem_size);
+}
+
+int av_ring_write(AVRing *r, const void *src, int nb_elems, int flags)
+{
+    int done = 0;
+
+    for (;;) {
+        unsigned int wndx = r->wndx;
+        int n = FFMIN(nb_elems - done, (int)(r->nb_elems - (wndx - r->rndx)));
+
+        if (n > 0) {
+            ring_barrier();
+            ring_copy_in(r, wndx, (const uint8_t*)src + done * r->elem_size, n);
+            ring_barrier();
+            r->wndx = wndx + n;
+            done += n;
+            ring_wake(r, WAIT_READER);
+        }
+        if (done >= nb_elems || !(flags & AV_RING_BLOCK) || r->abort)
+            return done;
+        ring_wait(r, WAIT_WRITER);
+    }
+}
+
+int av_ring_read(AVRing *r, void *dst, int nb_elems, int flags)
+{
+    for (;;) {
+        unsigned int rndx = r->rndx;
+        int n = FFMIN(nb_elems, (int)(r->wndx - rndx));
+
+        if (n > 0) {
+            ring_barrier();
+            ring_copy_out(r, rndx, dst, n);
+            ring_barrier();
+            r->rndx = rndx + n;
+            ring_wake(r, WAIT_WRITER);
+            return n;
+        }
+        if (nb_elems <= 0 || !(flags & AV_RING_BLOCK) || r->abort)
+            return 0;
+        ring_wait(r, WAIT_READER);
+    }
+}
+
+void av_ring_abort(AVRing *r)
+{
+    r->abort = 1;
+    ring_wake(r, WAIT_READER | WAIT_WRITER);
+}
+
+#ifdef TEST
+#include <stdio.h>
+#undef printf
+
+#if HAVE_PTHREADS
+#define TEST_COUNT 1000000
+
+static void *producer(void *arg)
+{
+    AVRing *r = arg;
+    uint32_t buf[37];
+    int i, j;
+
+    for (i = 0; i < TEST_COUNT; i += FF_ARRAY_ELEMS(buf)) {
+        int n = FFMIN(FF_ARRAY_ELEMS(buf), TEST_COUNT - i);
+        for (j = 0; j < n; j++)
+            buf[j] = i + j;
+        av_ring_write(r, buf, n, AV_RING_BLOCK);
+    }
+    return NULL;
+}
+#endif
+
+int main(void)
+{
+    AVRing *r = av_ring_alloc(1000, sizeof(uint32_t));
+    uint32_t buf[64];
+    int i, n, errors = 0;
+
+    printf("size %d space %d\n", av_ring_size(r), av_ring_space(r));
+    for (i = 0; i < 64; i++)
+        buf[i] = i;
+    n = av_ring_write(r, buf, 64, 0);
+    printf("wrote %d, size %d\n", n, av_ring_size(r));
+    n = av_ring_read(r, buf, 100, 0);
+    printf("read %d, size %d\n", n, av_ring_size(r));
+
+#if HAVE_PTHREADS
+    {
+        pthread_t thread;
+        uint32_t expected = 0;
+
+        pthread_create(&thread, NULL, producer, r);
+        while (expected < TEST_COUNT) {
+            n = av_ring_read(r, buf, FF_ARRAY_ELEMS(buf), AV_RING_BLOCK);
+            for (i = 0; i < n; i++)
+                if (buf[i] != expected++)
+                    errors++;
+        }
+        pthread_join(thread, NULL);
+        printf("threaded transfer of %d elements, %d errors\n", TEST_COUNT, errors);
+    }
+#endif
+    av_ring_abort(r);
+    printf("aborted read %d\n", av_ring_read(r, buf, 1, AV_RING_BLOCK));
+    av_ring_free(r);
+    return !!errors;
+}
+#endif
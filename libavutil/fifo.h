@@ -113,4 +113,61 @@ static inline uint8_t av_fifo_peek(AVFifoBuffer *f, int offs)
         ptr -= f->end - f->buffer;
     return *ptr;
 }
+
+/**
+ * Lock-free ring buffer for handing fixed size elements (or bytes, with an
+ * element size of 1) from one producer thread to one consumer thread.
+ * Only one thread may write and only one thread may read at a time, the
+ * threads synchronize only when they have to wait for data or space.
+ */
+typedef struct AVRing AVRing;
+
+/** Wait for data or space instead of returning early, needs pthreads. */
+#define AV_RING_BLOCK 1
+
+/**
+ * Allocates an AVRing.
+ * @param nb_elems minimum number of elements, rounded up to a power of 2
+ * @param elem_size size of an element in bytes
+ * @return AVRing or NULL in case of failure
+ */
+AVRing *av_ring_alloc(unsigned int nb_elems, unsigned int elem_size);
+
+/**
+ * Frees an AVRing, no thread may be using it anymore.
+ */
+void av_ring_free(AVRing *r);
+
+/**
+ * Writes up to nb_elems elements, called by the producer only.
+ * @param flags AV_RING_BLOCK to wait until all elements are written or
+ *              the ring is aborted
+ * @return number of elements written
+ */
+int av_ring_write(AVRing *r, const void *src, int nb_elems, int flags);
+
+/**
+ * Reads up to nb_elems elements, called by the consumer only.
+ * @param flags AV_RING_BLOCK to wait until at least one element is
+ *              available or the ring is aborted
+ * @return number of elements read
+ */
+int av_ring_read(AVRing *r, void *dst, int nb_elems, int flags);
+
+/**
+ * Returns the number of elements that can be read.
+ */
+int av_ring_size(AVRing *r);
+
+/**
+ * Returns the number of elements that can be written.
+ */
+int av_ring_space(AVRing *r);
+
+/**
+ * Makes all current and future blocking reads and writes return
+ * without waiting.
+ */
+void av_ring_abort(AVRing *r);
+
 #endif /* AVUTIL_FIFO_H */
@@ -31,8 +31,12 @@
  */
 
 #include <string.h>
+#include "config.h"
+#include "common.h"
 #include "bswap.h"
+#include "intreadwrite.h"
 #include "md5.h"
+#include "md5_internal.h"
 
 typedef struct AVMD5{
     uint64_t len;
@@ -71,20 +75,22 @@ static const uint32_t T[64] = { // T[i]= fabs(sin(i+1)<<32)
     0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
 };
 
+#define X(i) AV_RL32(src + 4*(i))
+
 #define CORE(i, a, b, c, d) \
         t = S[i>>4][i&3];\
         a += T[i];\
 \
         if(i<32){\
-            if(i<16) a += (d ^ (b&(c^d))) + X[      i &15 ];\
-            else     a += (c ^ (d&(c^b))) + X[ (1+5*i)&15 ];\
+            if(i<16) a += (d ^ (b&(c^d))) + X(      i &15);\
+            else     a += (c ^ (d&(c^b))) + X( (1+5*i)&15);\
         }else{\
-            if(i<48) a += (b^c^d)         + X[ (5+3*i)&15 ];\
-            else     a += (c^(b|~d))      + X[ (  7*i)&15 ];\
+            if(i<48) a += (b^c^d)         + X( (5+3*i)&15);\
+            else     a += (c^(b|~d))      + X( (  7*i)&15);\
         }\
         a = b + (( a << t ) | ( a >> (32 - t) ));
 
-static void body(uint32_t ABCD[4], uint32_t X[16]){
+static void body(uint32_t ABCD[4], const uint8_t *src){
 
     int t;
     int i av_unused;
@@ -93,11 +99,6 @@ static void body(uint32_t ABCD[4], uint32_t X[16]){
     unsigned int c= ABCD[1];
     unsigned int d= ABCD[0];
 
-#if HAVE_BIGENDIAN
-    for(i=0; i<16; i++)
-        X[i]= bswap_32(X[i]);
-#endif
-
 #if CONFIG_SMALL
     for( i = 0; i < 64; i++ ){
         CORE(i,a,b,c,d)
@@ -125,28 +126,31 @@ void av_md5_init(AVMD5 *ctx){
 }
 
 void av_md5_update(AVMD5 *ctx, const uint8_t *src, const int len){
-    int i, j;
+    const uint8_t *end= src + len;
+    int j= ctx->len & 63;
 
-    j= ctx->len & 63;
     ctx->len += len;
 
-    for( i = 0; i < len; i++ ){
-        ctx->block[j++] = src[i];
-        if( 64 == j ){
-            body(ctx->ABCD, (uint32_t*) ctx->block);
-            j = 0;
-        }
+    if(j){
+        int n= FFMIN(len, 64 - j);
+        memcpy(ctx->block + j, src, n);
+        src += n;
+        if(j + n < 64)
+            return;
+        body(ctx->ABCD, ctx->block);
     }
+    /* whole blocks are hashed in place */
+    for(; end - src >= 64; src += 64)
+        body(ctx->ABCD, src);
+    memcpy(ctx->block, src, end - src);
 }
 
 void av_md5_final(AVMD5 *ctx, uint8_t *dst){
+    static const uint8_t pad[64]= { 0x80 };
     int i;
     uint64_t finalcount= le2me_64(ctx->len<<3);
 
-    av_md5_update(ctx, "\200", 1);
-    while((ctx->len & 63)!=56)
-        av_md5_update(ctx, "", 1);
-
+    av_md5_update(ctx, pad, 1 + ((55 - ctx->len) & 63));
     av_md5_update(ctx, (uint8_t*)&finalcount, 8);
 
     for(i=0; i<4; i++)
@@ -161,6 +165,47 @@ void av_md5_sum(uint8_t *dst, const uint8_t *src, const int len){
     av_md5_final(ctx, dst);
 }
 
+void av_md5_sum_multi(uint8_t **dst, const uint8_t **src, const int *len, int count){
+    AVMD5 ctx[4];
+    int i, j, n;
+#if ARCH_X86 && HAVE_SSE
+    static MD5DSPContext dsp;
+    static int dsp_ready;
+
+    if(!dsp_ready){
+        ff_md5_init_x86(&dsp);
+        dsp_ready= 1;
+    }
+#endif
+
+    for(i= 0; i < count; i += n){
+        n= FFMIN(count - i, 4);
+        for(j= 0; j < n; j++)
+            av_md5_init(&ctx[j]);
+
+#if ARCH_X86 && HAVE_SSE
+        if(n == 4 && dsp.blocks_x4){
+            uint32_t ABCD[4][4];
+            int nb_blocks= FFMIN(FFMIN(len[i], len[i+1]), FFMIN(len[i+2], len[i+3])) >> 6;
+
+            if(nb_blocks){
+                for(j= 0; j < 4; j++)
+                    memcpy(ABCD[j], ctx[j].ABCD, sizeof(ABCD[j]));
+                dsp.blocks_x4(ABCD, src + i, nb_blocks);
+                for(j= 0; j < 4; j++){
+                    memcpy(ctx[j].ABCD, ABCD[j], sizeof(ABCD[j]));
+                    ctx[j].len= 64 * nb_blocks;
+                }
+            }
+        }
+#endif
+        for(j= 0; j < n; j++){
+            av_md5_update(&ctx[j], src[i+j] + ctx[j].len, len[i+j] - ctx[j].len);
+            av_md5_final(&ctx[j], dst[i+j]);
+        }
+    }
+}
+
 #ifdef TEST
 #include <stdio.h>
 #include <inttypes.h>
@@ -178,6 +223,22 @@ int main(void){
     for(i=0; i<1000; i++) in[i]= i % 127;
     av_md5_sum( (uint8_t*)&md5val, in,  999); printf("%"PRId64"\n", md5val);
 
+    {
+        uint8_t md5s[6][16];
+        uint8_t *dst[6];
+        const uint8_t *src[6]= { in, in, in + 1, in, in + 3, in };
+        const int len[6]= { 1000, 999, 998, 640, 900, 65 };
+
+        for(i=0; i<6; i++)
+            dst[i]= md5s[i];
+        av_md5_sum_multi(dst, src, len, 6);
+        for(i=0; i<6; i++){
+            uint8_t md5[16];
+            av_md5_sum(md5, src[i], len[i]);
+            printf("%d %s\n", len[i], memcmp(md5, md5s[i], 16) ? "mismatch" : "ok");
+        }
+    }
+
     return 0;
 }
 #endif
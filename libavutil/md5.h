@@ -32,5 +32,17 @@ void av_md5_update(struct AVMD5 *ctx, const uint8_t *src, const int len);
 void av_md5_final(struct AVMD5 *ctx, uint8_t *dst);
 void av_md5_sum(uint8_t *dst, const uint8_t *src, const int len);
 
+/**
+ * Computes the MD5 sums of several independent buffers, hashing several
+ * of them at once where the CPU allows it. Consecutive buffers of similar
+ * length are processed fastest.
+ *
+ * @param dst   count destinations for the 16 byte digests
+ * @param src   count input buffers
+ * @param len   length of each input buffer
+ * @param count number of buffers
+ */
+void av_md5_sum_multi(uint8_t **dst, const uint8_t **src, const int *len, int count);
+
 #endif /* AVUTIL_MD5_H */
 
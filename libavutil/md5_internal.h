@@ -0,0 +1,34 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_MD5_INTERNAL_H
+#define AVUTIL_MD5_INTERNAL_H
+
+#include <stdint.h>
+
+typedef struct MD5DSPContext {
+    /**
+     * Hashes nb_blocks 64 byte blocks of 4 independent streams.
+     * @param ABCD state of each stream, as in AVMD5
+     */
+    void (*blocks_x4)(uint32_t ABCD[4][4], const uint8_t *src[4], int nb_blocks);
+} MD5DSPContext;
+
+void ff_md5_init_x86(MD5DSPContext *c);
+
+#endif /* AVUTIL_MD5_INTERNAL_H */
@@ -313,12 +313,11 @@ void av_sha_update(AVSHA* ctx, const uint8_t* data, unsigned int len)
 
 void av_sha_final(AVSHA* ctx, uint8_t *digest)
 {
+    static const uint8_t pad[64] = { 0x80 };
     int i;
     uint64_t finalcount = be2me_64(ctx->count << 3);
 
-    av_sha_update(ctx, "\200", 1);
-    while ((ctx->count & 63) != 56)
-        av_sha_update(ctx, "", 1);
+    av_sha_update(ctx, pad, 1 + ((55 - ctx->count) & 63));
     av_sha_update(ctx, (uint8_t *)&finalcount, 8); /* Should cause a transform() */
     for (i = 0; i < ctx->digest_len; i++)
         AV_WB32(digest + i*4, ctx->state[i]);
@@ -0,0 +1,202 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "config.h"
+#if HAVE_PTHREADS
+#include <pthread.h>
+#endif
+#include "common.h"
+#include "error.h"
+#include "trace.h"
+
+#define TRACE_BUFFER_SIZE 1024
+
+typedef struct TraceEvent {
+    const char *cat, *name;
+    int64_t ts, dur;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+    int tid;
+    int nb_events;
+    TraceEvent events[TRACE_BUFFER_SIZE];
+    struct TraceBuffer *next;
+} TraceBuffer;
+
+int av_trace_enabled;
+
+static FILE *trace_file;
+static int64_t trace_epoch;
+static int trace_nb_written;
+static int trace_nb_threads;
+static TraceBuffer *trace_buffers;      ///< buffers of all threads
+
+#if HAVE_PTHREADS
+static pthread_mutex_t trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t  trace_once  = PTHREAD_ONCE_INIT;
+static pthread_key_t   trace_key;
+#define trace_lock()   pthread_mutex_lock(&trace_mutex)
+#define trace_unlock() pthread_mutex_unlock(&trace_mutex)
+#else
+static TraceBuffer *trace_buffer;
+#define trace_lock()
+#define trace_unlock()
+#endif
+
+static int64_t trace_time(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+#undef fprintf
+/* must be called with the lock held */
+static void flush_buffer(TraceBuffer *b)
+{
+    int i;
+
+    if (trace_file) {
+        for (i = 0; i < b->nb_events; i++) {
+            TraceEvent *e = &b->events[i];
+            fprintf(trace_file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                    "\"ts\":%"PRId64",\"dur\":%"PRId64",\"pid\":0,\"tid\":%d}",
+                    trace_nb_written++ ? ",\n" : "",
+                    e->name, e->cat, e->ts - trace_epoch, e->dur, b->tid);
+        }
+    }
+    b->nb_events = 0;
+}
+
+#if HAVE_PTHREADS
+static void free_buffer(void *opaque)
+{
+    TraceBuffer *b = opaque, **p;
+
+    trace_lock();
+    flush_buffer(b);
+    for (p = &trace_buffers; *p; p = &(*p)->next) {
+        if (*p == b) {
+            *p = b->next;
+            break;
+        }
+    }
+    trace_unlock();
+    av_free(b);
+}
+
+static void init_key(void)
+{
+    pthread_key_create(&trace_key, free_buffer);
+}
+#endif
+
+static TraceBuffer *get_buffer(void)
+{
+    TraceBuffer *b;
+
+#if HAVE_PTHREADS
+    if ((b = pthread_getspecific(trace_key)))
+        return b;
+#else
+    if ((b = trace_buffer))
+        return b;
+#endif
+    if (!(b = av_mallocz(sizeof(TraceBuffer))))
+        return NULL;
+    trace_lock();
+    b->tid  = ++trace_nb_threads;
+    b->next = trace_buffers;
+    trace_buffers = b;
+    trace_unlock();
+#if HAVE_PTHREADS
+    pthread_setspecific(trace_key, b);
+#else
+    trace_buffer = b;
+#endif
+    return b;
+}
+
+int av_trace_start(const char *filename)
+{
+    FILE *f;
+
+#if HAVE_PTHREADS
+    pthread_once(&trace_once, init_key);
+#endif
+    if (av_trace_enabled)
+        return AVERROR(EINVAL);
+    if (!(f = fopen(filename, "w")))
+        return AVERROR(errno);
+
+    trace_lock();
+    fputs("[\n", f);
+    trace_file       = f;
+    trace_epoch      = trace_time();
+    trace_nb_written = 0;
+    trace_unlock();
+    av_trace_enabled = 1;
+    return 0;
+}
+
+void av_trace_stop(void)
+{
+    TraceBuffer *b;
+
+    if (!av_trace_enabled)
+        return;
+    av_trace_enabled = 0;
+
+    trace_lock();
+    for (b = trace_buffers; b; b = b->next)
+        flush_buffer(b);
+    fputs("\n]\n", trace_file);
+    fclose(trace_file);
+    trace_file = NULL;
+    trace_unlock();
+}
+
+int64_t av_trace_begin(void)
+{
+    return av_trace_enabled ? trace_time() : 0;
+}
+
+void av_trace_end(const char *cat, const char *name, int64_t start)
+{
+    TraceBuffer *b;
+    TraceEvent *e;
+
+    if (!av_trace_enabled || !start || !(b = get_buffer()))
+        return;
+
+    e = &b->events[b->nb_events++];
+    e->cat  = cat;
+    e->name = name;
+    e->ts   = start;
+    e->dur  = trace_time() - start;
+
+    if (b->nb_events == TRACE_BUFFER_SIZE) {
+        trace_lock();
+        flush_buffer(b);
+        trace_unlock();
+    }
+}
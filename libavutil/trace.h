@@ -0,0 +1,72 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Runtime enabled tracing of named scopes, written in the Chrome trace
+ * event format (JSON) which chrome://tracing and compatible viewers load.
+ *
+ * Unlike START_TIMER/STOP_TIMER from timer.h, the scopes are compiled in
+ * and only cost a test of av_trace_enabled while tracing is off. Events are
+ * collected in per-thread buffers and written out when a buffer is full.
+ */
+
+#ifndef AVUTIL_TRACE_H
+#define AVUTIL_TRACE_H
+
+#include <stdint.h>
+
+/** nonzero while events are being recorded, do not set directly */
+extern int av_trace_enabled;
+
+/**
+ * Starts recording trace events to a file.
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int av_trace_start(const char *filename);
+
+/**
+ * Writes out all recorded events and closes the trace file. No traced
+ * code may run in other threads at the same time.
+ */
+void av_trace_stop(void);
+
+/**
+ * Returns the current time for av_trace_end(), or 0 if tracing is off.
+ */
+int64_t av_trace_begin(void);
+
+/**
+ * Records a scope lasting from start, a value from av_trace_begin(), to now
+ * for the calling thread.
+ * @param cat category of the scope, e.g. "decode"
+ * @param name name of the scope, e.g. the codec name
+ * cat and name are not copied and must stay valid until av_trace_stop().
+ */
+void av_trace_end(const char *cat, const char *name, int64_t start);
+
+#define START_TRACE \
+{\
+    int64_t trace_start = av_trace_enabled ? av_trace_begin() : 0;
+
+#define STOP_TRACE(cat, name) \
+    if (trace_start)\
+        av_trace_end(cat, name, trace_start);\
+}
+
+#endif /* AVUTIL_TRACE_H */
@@ -0,0 +1,184 @@
+/*
+ * AES-NI accelerated AES
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86_cpu.h"
+#include "libavutil/aes_internal.h"
+
+#if HAVE_AESNI
+/* The round keys are applied from round_key[rounds] down to round_key[0]
+ * in both directions, see AVAES. They are loaded unaligned, as the
+ * context may come from anywhere. */
+
+#define AES_BLOCK1(name, OP)                                            \
+static void name(const AVAES *a, uint8_t *dst, const uint8_t *src)      \
+{                                                                       \
+    const uint8_t *key = a->round_key[a->rounds][0];                    \
+    x86_reg n = a->rounds - 1;                                          \
+                                                                        \
+    __asm__ volatile(                                                   \
+        "movdqu          (%3), %%xmm0       \n\t"                       \
+        "movdqu          (%0), %%xmm4       \n\t"                       \
+        "pxor          %%xmm4, %%xmm0       \n\t"                       \
+        "1:                                 \n\t"                       \
+        "sub              $16, %0           \n\t"                       \
+        "movdqu          (%0), %%xmm4       \n\t"                       \
+        OP"          %%xmm4, %%xmm0       \n\t"                         \
+        "dec               %1               \n\t"                       \
+        "jnz               1b               \n\t"                       \
+        "movdqu       -16(%0), %%xmm4       \n\t"                       \
+        OP"last      %%xmm4, %%xmm0       \n\t"                         \
+        "movdqu        %%xmm0, (%2)         \n\t"                       \
+        : "+r"(key), "+r"(n)                                            \
+        : "r"(dst), "r"(src)                                            \
+        : "memory");                                                    \
+}
+
+/* 4 independent blocks at once, to hide the latency of the rounds */
+#define AES_BLOCK4(name, OP)                                            \
+static void name(const AVAES *a, uint8_t *dst, const uint8_t *src)      \
+{                                                                       \
+    const uint8_t *key = a->round_key[a->rounds][0];                    \
+    x86_reg n = a->rounds - 1;                                          \
+                                                                        \
+    __asm__ volatile(                                                   \
+        "movdqu          (%3), %%xmm0       \n\t"                       \
+        "movdqu        16(%3), %%xmm1       \n\t"                       \
+        "movdqu        32(%3), %%xmm2       \n\t"                       \
+        "movdqu        48(%3), %%xmm3       \n\t"                       \
+        "movdqu          (%0), %%xmm4       \n\t"                       \
+        "pxor          %%xmm4, %%xmm0       \n\t"                       \
+        "pxor          %%xmm4, %%xmm1       \n\t"                       \
+        "pxor          %%xmm4, %%xmm2       \n\t"                       \
+        "pxor          %%xmm4, %%xmm3       \n\t"                       \
+        "1:                                 \n\t"                       \
+        "sub              $16, %0           \n\t"                       \
+        "movdqu          (%0), %%xmm4       \n\t"                       \
+        OP"          %%xmm4, %%xmm0       \n\t"                         \
+        OP"          %%xmm4, %%xmm1       \n\t"                         \
+        OP"          %%xmm4, %%xmm2       \n\t"                         \
+        OP"          %%xmm4, %%xmm3       \n\t"                         \
+        "dec               %1               \n\t"                       \
+        "jnz               1b               \n\t"                       \
+        "movdqu       -16(%0), %%xmm4       \n\t"                       \
+        OP"last      %%xmm4, %%xmm0       \n\t"                         \
+        OP"last      %%xmm4, %%xmm1       \n\t"                         \
+        OP"last      %%xmm4, %%xmm2       \n\t"                         \
+        OP"last      %%xmm4, %%xmm3       \n\t"                         \
+        "movdqu        %%xmm0,   (%2)       \n\t"                       \
+        "movdqu        %%xmm1, 16(%2)       \n\t"                       \
+        "movdqu        %%xmm2, 32(%2)       \n\t"                       \
+        "movdqu        %%xmm3, 48(%2)       \n\t"                       \
+        : "+r"(key), "+r"(n)                                            \
+        : "r"(dst), "r"(src)                                            \
+        : "memory");                                                    \
+}
+
+AES_BLOCK1(aes_encrypt1_aesni, "aesenc")
+AES_BLOCK1(aes_decrypt1_aesni, "aesdec")
+AES_BLOCK4(aes_encrypt4_aesni, "aesenc")
+AES_BLOCK4(aes_decrypt4_aesni, "aesdec")
+
+static inline void xor_block(uint8_t *dst, const uint8_t *a, const uint8_t *b)
+{
+    AV_WN64(dst,     AV_RN64(a)     ^ AV_RN64(b));
+    AV_WN64(dst + 8, AV_RN64(a + 8) ^ AV_RN64(b + 8));
+}
+
+static void aes_crypt_aesni(AVAES *a, uint8_t *dst, const uint8_t *src,
+                            int count, uint8_t *iv, int decrypt)
+{
+    uint8_t tmp[4][16];
+    int i;
+
+    if (!iv) {
+        for (; count >= 4; count -= 4, src += 64, dst += 64) {
+            if (decrypt) aes_decrypt4_aesni(a, dst, src);
+            else         aes_encrypt4_aesni(a, dst, src);
+        }
+        for (; count > 0; count--, src += 16, dst += 16) {
+            if (decrypt) aes_decrypt1_aesni(a, dst, src);
+            else         aes_encrypt1_aesni(a, dst, src);
+        }
+    } else if (decrypt) {
+        /* the blocks only depend on the ciphertext, decrypt 4 at once */
+        for (; count >= 4; count -= 4, src += 64, dst += 64) {
+            aes_decrypt4_aesni(a, tmp[0], src);
+            xor_block(tmp[0], tmp[0], iv);
+            for (i = 1; i < 4; i++)
+                xor_block(tmp[i], tmp[i], src + 16 * (i - 1));
+            memcpy(iv, src + 48, 16);
+            memcpy(dst, tmp, 64);
+        }
+        for (; count > 0; count--, src += 16, dst += 16) {
+            aes_decrypt1_aesni(a, tmp[0], src);
+            xor_block(tmp[0], tmp[0], iv);
+            memcpy(iv, src, 16);
+            memcpy(dst, tmp[0], 16);
+        }
+    } else {
+        for (; count > 0; count--, src += 16, dst += 16) {
+            xor_block(tmp[0], src, iv);
+            aes_encrypt1_aesni(a, dst, tmp[0]);
+            memcpy(iv, dst, 16);
+        }
+    }
+}
+
+static void aes_ctr_crypt_aesni(AVAES *a, uint8_t *dst, const uint8_t *src,
+                                int count, uint8_t *ctr)
+{
+    uint8_t keystream[4][16];
+    uint64_t hi = AV_RB64(ctr), lo = AV_RB64(ctr + 8);
+    int i;
+
+    for (; count >= 4; count -= 4, src += 64, dst += 64) {
+        for (i = 0; i < 4; i++) {
+            AV_WB64(keystream[i],     hi);
+            AV_WB64(keystream[i] + 8, lo);
+            hi += !++lo;
+        }
+        aes_encrypt4_aesni(a, keystream[0], keystream[0]);
+        for (i = 0; i < 4; i++)
+            xor_block(dst + 16 * i, src + 16 * i, keystream[i]);
+    }
+    for (; count > 0; count--, src += 16, dst += 16) {
+        AV_WB64(keystream[0],     hi);
+        AV_WB64(keystream[0] + 8, lo);
+        hi += !++lo;
+        aes_encrypt1_aesni(a, keystream[0], keystream[0]);
+        xor_block(dst, src, keystream[0]);
+    }
+    AV_WB64(ctr,     hi);
+    AV_WB64(ctr + 8, lo);
+}
+#endif /* HAVE_AESNI */
+
+void ff_aes_init_x86(AVAES *a)
+{
+#if HAVE_AESNI
+    if (av_get_cpu_flags() & AV_CPU_FLAG_AESNI) {
+        a->crypt     = aes_crypt_aesni;
+        a->ctr_crypt = aes_ctr_crypt_aesni;
+    }
+#endif
+}
@@ -0,0 +1,175 @@
+/*
+ * CRC folding with carry-less multiplications
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The buffer is reduced 64 bytes at a time to 4 accumulators, which are
+ * then reduced to one; the final 16 bytes are handled by the table based
+ * code. A 128 bit block A = H*x^64 + L followed by D bits is congruent,
+ * modulo the CRC polynomial P, to H*(x^(D+64) mod P) + L*(x^D mod P),
+ * which has less than 96 bits and is simply xored into the block D bits
+ * later.
+ * For the bit reversed (le) CRCs the blocks are used as loaded, with the
+ * constants bit reversed and shifted by one as the products of reversed
+ * operands are, see "Fast CRC Computation for Generic Polynomials Using
+ * PCLMULQDQ Instruction" by Gopal et al. (Intel, 2009). Otherwise the
+ * bytes of each block are reversed so that the first bit of the block is
+ * the highest bit of the register.
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86_cpu.h"
+#include "libavutil/crc_internal.h"
+
+#if HAVE_PCLMUL
+DECLARE_ALIGNED(16, static const uint64_t, bswap_mask)[2] = {
+    0x08090A0B0C0D0E0FULL, 0x0001020304050607ULL
+};
+
+#define COMMA ,
+#define SHUF_NONE(reg)
+#define SHUF_BSWAP(reg) "pshufb         %%xmm7, "reg"           \n\t"
+
+/* fold the accumulator reg into the block at off(%0), using xmm4 */
+#define FOLD_LOAD(reg, off, SHUF)                                       \
+        "movdqa           "reg", %%xmm5             \n\t"               \
+        "pclmulqdq $0x00, %%xmm4, "reg"             \n\t"               \
+        "pclmulqdq $0x11, %%xmm4, %%xmm5            \n\t"               \
+        "movdqu      "#off"(%0), %%xmm6             \n\t"               \
+        SHUF("%%xmm6")                                                  \
+        "pxor           %%xmm5, "reg"               \n\t"               \
+        "pxor           %%xmm6, "reg"               \n\t"
+
+/* fold the accumulator src into the next one, dst */
+#define FOLD_REG(src, dst)                                              \
+        "movdqa           "src", %%xmm5             \n\t"               \
+        "pclmulqdq $0x00, %%xmm4, "src"             \n\t"               \
+        "pclmulqdq $0x11, %%xmm4, %%xmm5            \n\t"               \
+        "pxor           %%xmm5, "dst"               \n\t"               \
+        "pxor             "src", "dst"              \n\t"
+
+#define CRC_FOLD(name, SHUF, LOAD_MASK, MASK_OPERAND)                   \
+static void name(uint8_t *out, const uint8_t *buf, size_t len,          \
+                 uint32_t crc, const uint64_t *k)                       \
+{                                                                       \
+    x86_reg n = len;                                                    \
+                                                                        \
+    __asm__ volatile(                                                   \
+        LOAD_MASK                                                       \
+        "movd               %4, %%xmm5              \n\t"               \
+        "movdqu           (%0), %%xmm0              \n\t"               \
+        "movdqu         16(%0), %%xmm1              \n\t"               \
+        "movdqu         32(%0), %%xmm2              \n\t"               \
+        "movdqu         48(%0), %%xmm3              \n\t"               \
+        "pxor           %%xmm5, %%xmm0              \n\t"               \
+        SHUF("%%xmm0")                                                  \
+        SHUF("%%xmm1")                                                  \
+        SHUF("%%xmm2")                                                  \
+        SHUF("%%xmm3")                                                  \
+        "movdqa           (%2), %%xmm4              \n\t"               \
+        "add               $64, %0                  \n\t"               \
+        "sub               $64, %1                  \n\t"               \
+        "cmp               $64, %1                  \n\t"               \
+        "jb                 2f                      \n\t"               \
+        "1:                                         \n\t"               \
+        FOLD_LOAD("%%xmm0",  0, SHUF)                                   \
+        FOLD_LOAD("%%xmm1", 16, SHUF)                                   \
+        FOLD_LOAD("%%xmm2", 32, SHUF)                                   \
+        FOLD_LOAD("%%xmm3", 48, SHUF)                                   \
+        "add               $64, %0                  \n\t"               \
+        "sub               $64, %1                  \n\t"               \
+        "cmp               $64, %1                  \n\t"               \
+        "jae                1b                      \n\t"               \
+        "2:                                         \n\t"               \
+        "movdqa         16(%2), %%xmm4              \n\t"               \
+        FOLD_REG("%%xmm0", "%%xmm1")                                    \
+        FOLD_REG("%%xmm1", "%%xmm2")                                    \
+        FOLD_REG("%%xmm2", "%%xmm3")                                    \
+        "test               %1, %1                  \n\t"               \
+        "jz                 4f                      \n\t"               \
+        "3:                                         \n\t"               \
+        FOLD_LOAD("%%xmm3",  0, SHUF)                                   \
+        "add               $16, %0                  \n\t"               \
+        "sub               $16, %1                  \n\t"               \
+        "jnz                3b                      \n\t"               \
+        "4:                                         \n\t"               \
+        SHUF("%%xmm3")                                                  \
+        "movdqu         %%xmm3, (%3)                \n\t"               \
+        : "+r"(buf), "+r"(n)                                            \
+        : "r"(k), "r"(out), "r"(crc) MASK_OPERAND                       \
+        : "memory");                                                    \
+}
+
+CRC_FOLD(crc_fold_le_pclmul, SHUF_NONE, "", )
+CRC_FOLD(crc_fold_be_pclmul, SHUF_BSWAP, "movdqa %5, %%xmm7 \n\t",
+         COMMA "m"(*bswap_mask))
+
+/* x^n modulo x^32 + p */
+static uint32_t xpow_mod(int n, uint32_t p)
+{
+    uint32_t r = 1;
+
+    while (n--)
+        r = (r << 1) ^ (p & -(r >> 31));
+    return r;
+}
+
+static uint32_t bitswap_32(uint32_t x)
+{
+    uint32_t r = 0;
+    int i;
+
+    for (i = 0; i < 32; i++)
+        r |= ((x >> i) & 1) << (31 - i);
+    return r;
+}
+#endif /* HAVE_PCLMUL */
+
+void ff_crc_fold_init_x86(CRCFoldContext *c, int le, int bits, uint32_t poly)
+{
+#if HAVE_PCLMUL
+    int mm_flags = av_get_cpu_flags();
+
+    if (!(mm_flags & AV_CPU_FLAG_PCLMUL))
+        return;
+
+    if (le) {
+        uint32_t p = bitswap_32(poly);
+
+        if (bits != 32)
+            return;
+        c->k[0] = (uint64_t)bitswap_32(xpow_mod(4*128 + 32, p)) << 1;
+        c->k[1] = (uint64_t)bitswap_32(xpow_mod(4*128 - 32, p)) << 1;
+        c->k[2] = (uint64_t)bitswap_32(xpow_mod(  128 + 32, p)) << 1;
+        c->k[3] = (uint64_t)bitswap_32(xpow_mod(  128 - 32, p)) << 1;
+        c->fold = crc_fold_le_pclmul;
+    } else if (mm_flags & AV_CPU_FLAG_SSSE3) {
+        /* CRCs of less than 32 bits are computed as 32 bit ones with
+           the polynomial multiplied by x^(32-bits) */
+        uint32_t p = poly << (32 - bits);
+
+        c->k[0] = xpow_mod(4*128,      p);
+        c->k[1] = xpow_mod(4*128 + 64, p);
+        c->k[2] = xpow_mod(  128,      p);
+        c->k[3] = xpow_mod(  128 + 64, p);
+        c->fold = crc_fold_be_pclmul;
+    }
+#endif
+}
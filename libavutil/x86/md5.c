@@ -0,0 +1,222 @@
+/*
+ * SSE2 multi-buffer MD5
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86_cpu.h"
+#include "libavutil/md5_internal.h"
+
+#if HAVE_SSE
+#define T4(x) { x, x, x, x }
+
+DECLARE_ALIGNED(16, static const uint32_t, T4)[64][4] = {
+    T4(0xd76aa478), T4(0xe8c7b756),
+    T4(0x242070db), T4(0xc1bdceee),
+    T4(0xf57c0faf), T4(0x4787c62a),
+    T4(0xa8304613), T4(0xfd469501),
+    T4(0x698098d8), T4(0x8b44f7af),
+    T4(0xffff5bb1), T4(0x895cd7be),
+    T4(0x6b901122), T4(0xfd987193),
+    T4(0xa679438e), T4(0x49b40821),
+    T4(0xf61e2562), T4(0xc040b340),
+    T4(0x265e5a51), T4(0xe9b6c7aa),
+    T4(0xd62f105d), T4(0x02441453),
+    T4(0xd8a1e681), T4(0xe7d3fbc8),
+    T4(0x21e1cde6), T4(0xc33707d6),
+    T4(0xf4d50d87), T4(0x455a14ed),
+    T4(0xa9e3e905), T4(0xfcefa3f8),
+    T4(0x676f02d9), T4(0x8d2a4c8a),
+    T4(0xfffa3942), T4(0x8771f681),
+    T4(0x6d9d6122), T4(0xfde5380c),
+    T4(0xa4beea44), T4(0x4bdecfa9),
+    T4(0xf6bb4b60), T4(0xbebfbc70),
+    T4(0x289b7ec6), T4(0xeaa127fa),
+    T4(0xd4ef3085), T4(0x04881d05),
+    T4(0xd9d4d039), T4(0xe6db99e5),
+    T4(0x1fa27cf8), T4(0xc4ac5665),
+    T4(0xf4292244), T4(0x432aff97),
+    T4(0xab9423a7), T4(0xfc93a039),
+    T4(0x655b59c3), T4(0x8f0ccc92),
+    T4(0xffeff47d), T4(0x85845dd1),
+    T4(0x6fa87e4f), T4(0xfe2ce6e0),
+    T4(0xa3014314), T4(0x4e0811a1),
+    T4(0xf7537e82), T4(0xbd3af235),
+    T4(0x2ad7d2bb), T4(0xeb86d391),
+};
+
+#define A "%%xmm0"
+#define B "%%xmm1"
+#define C "%%xmm2"
+#define D "%%xmm3"
+
+/* round functions of b, c, d into %%xmm4, %%xmm7 is all ones */
+#define MD5_F(b, c, d)                                                  \
+        "movdqa         "c", %%xmm4         \n\t"                       \
+        "pxor           "d", %%xmm4         \n\t"                       \
+        "pand           "b", %%xmm4         \n\t"                       \
+        "pxor           "d", %%xmm4         \n\t"
+#define MD5_G(b, c, d)                                                  \
+        "movdqa         "b", %%xmm4         \n\t"                       \
+        "pxor           "c", %%xmm4         \n\t"                       \
+        "pand           "d", %%xmm4         \n\t"                       \
+        "pxor           "c", %%xmm4         \n\t"
+#define MD5_H(b, c, d)                                                  \
+        "movdqa         "b", %%xmm4         \n\t"                       \
+        "pxor           "c", %%xmm4         \n\t"                       \
+        "pxor           "d", %%xmm4         \n\t"
+#define MD5_I(b, c, d)                                                  \
+        "movdqa         "d", %%xmm4         \n\t"                       \
+        "pxor          %%xmm7, %%xmm4       \n\t"                       \
+        "por            "b", %%xmm4         \n\t"                       \
+        "pxor           "c", %%xmm4         \n\t"
+
+/* a = b + ((a + f(b, c, d) + X[k] + T[i]) <<< s) */
+#define STEP(f, a, b, c, d, k, i, s)                                    \
+        MD5_ ## f(b, c, d)                                              \
+        "paddd   16*"#k"(%1), "a"           \n\t"                       \
+        "paddd   16*"#i"(%2), "a"           \n\t"                       \
+        "paddd         %%xmm4, "a"          \n\t"                       \
+        "movdqa         "a", %%xmm5         \n\t"                       \
+        "pslld          $"#s", "a"          \n\t"                       \
+        "psrld       $32-"#s", %%xmm5       \n\t"                       \
+        "por           %%xmm5, "a"          \n\t"                       \
+        "paddd          "b", "a"            \n\t"
+
+/**
+ * @param state 4 words of state (a, b, c, d) for 4 streams each
+ * @param block 16 words of input for 4 streams each
+ */
+static void md5_block_x4_sse2(uint32_t state[4][4], const uint32_t block[16][4])
+{
+    __asm__ volatile(
+        "pcmpeqd       %%xmm7, %%xmm7       \n\t"
+        "movdqa          (%0), %%xmm0       \n\t"
+        "movdqa        16(%0), %%xmm1       \n\t"
+        "movdqa        32(%0), %%xmm2       \n\t"
+        "movdqa        48(%0), %%xmm3       \n\t"
+        STEP(F, A, B, C, D,  0,  0,  7)
+        STEP(F, D, A, B, C,  1,  1, 12)
+        STEP(F, C, D, A, B,  2,  2, 17)
+        STEP(F, B, C, D, A,  3,  3, 22)
+        STEP(F, A, B, C, D,  4,  4,  7)
+        STEP(F, D, A, B, C,  5,  5, 12)
+        STEP(F, C, D, A, B,  6,  6, 17)
+        STEP(F, B, C, D, A,  7,  7, 22)
+        STEP(F, A, B, C, D,  8,  8,  7)
+        STEP(F, D, A, B, C,  9,  9, 12)
+        STEP(F, C, D, A, B, 10, 10, 17)
+        STEP(F, B, C, D, A, 11, 11, 22)
+        STEP(F, A, B, C, D, 12, 12,  7)
+        STEP(F, D, A, B, C, 13, 13, 12)
+        STEP(F, C, D, A, B, 14, 14, 17)
+        STEP(F, B, C, D, A, 15, 15, 22)
+        STEP(G, A, B, C, D,  1, 16,  5)
+        STEP(G, D, A, B, C,  6, 17,  9)
+        STEP(G, C, D, A, B, 11, 18, 14)
+        STEP(G, B, C, D, A,  0, 19, 20)
+        STEP(G, A, B, C, D,  5, 20,  5)
+        STEP(G, D, A, B, C, 10, 21,  9)
+        STEP(G, C, D, A, B, 15, 22, 14)
+        STEP(G, B, C, D, A,  4, 23, 20)
+        STEP(G, A, B, C, D,  9, 24,  5)
+        STEP(G, D, A, B, C, 14, 25,  9)
+        STEP(G, C, D, A, B,  3, 26, 14)
+        STEP(G, B, C, D, A,  8, 27, 20)
+        STEP(G, A, B, C, D, 13, 28,  5)
+        STEP(G, D, A, B, C,  2, 29,  9)
+        STEP(G, C, D, A, B,  7, 30, 14)
+        STEP(G, B, C, D, A, 12, 31, 20)
+        STEP(H, A, B, C, D,  5, 32,  4)
+        STEP(H, D, A, B, C,  8, 33, 11)
+        STEP(H, C, D, A, B, 11, 34, 16)
+        STEP(H, B, C, D, A, 14, 35, 23)
+        STEP(H, A, B, C, D,  1, 36,  4)
+        STEP(H, D, A, B, C,  4, 37, 11)
+        STEP(H, C, D, A, B,  7, 38, 16)
+        STEP(H, B, C, D, A, 10, 39, 23)
+        STEP(H, A, B, C, D, 13, 40,  4)
+        STEP(H, D, A, B, C,  0, 41, 11)
+        STEP(H, C, D, A, B,  3, 42, 16)
+        STEP(H, B, C, D, A,  6, 43, 23)
+        STEP(H, A, B, C, D,  9, 44,  4)
+        STEP(H, D, A, B, C, 12, 45, 11)
+        STEP(H, C, D, A, B, 15, 46, 16)
+        STEP(H, B, C, D, A,  2, 47, 23)
+        STEP(I, A, B, C, D,  0, 48,  6)
+        STEP(I, D, A, B, C,  7, 49, 10)
+        STEP(I, C, D, A, B, 14, 50, 15)
+        STEP(I, B, C, D, A,  5, 51, 21)
+        STEP(I, A, B, C, D, 12, 52,  6)
+        STEP(I, D, A, B, C,  3, 53, 10)
+        STEP(I, C, D, A, B, 10, 54, 15)
+        STEP(I, B, C, D, A,  1, 55, 21)
+        STEP(I, A, B, C, D,  8, 56,  6)
+        STEP(I, D, A, B, C, 15, 57, 10)
+        STEP(I, C, D, A, B,  6, 58, 15)
+        STEP(I, B, C, D, A, 13, 59, 21)
+        STEP(I, A, B, C, D,  4, 60,  6)
+        STEP(I, D, A, B, C, 11, 61, 10)
+        STEP(I, C, D, A, B,  2, 62, 15)
+        STEP(I, B, C, D, A,  9, 63, 21)
+        "paddd           (%0), %%xmm0       \n\t"
+        "paddd         16(%0), %%xmm1       \n\t"
+        "paddd         32(%0), %%xmm2       \n\t"
+        "paddd         48(%0), %%xmm3       \n\t"
+        "movdqa        %%xmm0,   (%0)       \n\t"
+        "movdqa        %%xmm1, 16(%0)       \n\t"
+        "movdqa        %%xmm2, 32(%0)       \n\t"
+        "movdqa        %%xmm3, 48(%0)       \n\t"
+        :: "r"(state), "r"(block), "r"(T4)
+        : "memory");
+}
+
+static void md5_blocks_x4_sse2(uint32_t ABCD[4][4], const uint8_t *src[4],
+                               int nb_blocks)
+{
+    DECLARE_ALIGNED(16, uint32_t, state)[4][4];
+    DECLARE_ALIGNED(16, uint32_t, block)[16][4];
+    int i, j, n;
+
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            state[i][j] = ABCD[j][3 - i];
+
+    for (n = 0; n < nb_blocks; n++) {
+        for (i = 0; i < 16; i++)
+            for (j = 0; j < 4; j++)
+                block[i][j] = AV_RL32(src[j] + 64 * n + 4 * i);
+        md5_block_x4_sse2(state, block);
+    }
+
+    for (i = 0; i < 4; i++)
+        for (j = 0; j < 4; j++)
+            ABCD[j][3 - i] = state[i][j];
+}
+#endif /* HAVE_SSE */
+
+void ff_md5_init_x86(MD5DSPContext *c)
+{
+#if HAVE_SSE
+    if (av_get_cpu_flags() & AV_CPU_FLAG_SSE2)
+        c->blocks_x4 = md5_blocks_x4_sse2;
+#endif
+}
@@ -43,6 +43,8 @@ do_lavfi "crop_vflip"         "crop=100:100,vflip"
 do_lavfi "null"               "null"
 do_lavfi "scale200"           "scale=200:200"
 do_lavfi "scale500"           "scale=500:500"
+do_lavfi "unsharp"            "unsharp"
+do_lavfi "yadif"              "yadif"
 do_lavfi "vflip"              "vflip"
 do_lavfi "vflip_crop"         "vflip,crop=100:100"
 do_lavfi "vflip_vflip"        "vflip,vflip"
@@ -71,8 +73,22 @@ if [ -n "$do_lavfi_pix_fmts" ]; then
     done
 fi
 
+# gray input must stay gray between the scalers, which then copy it
+# unchanged, instead of being converted to rgb24, the first of the
+# allowed formats, and back
+if [ -n "$do_scale_gray" ] ; then
+    do_ffmpeg ${outfile}scale_gray.nut -f image2 -vcodec pgm -i $raw_src \
+        -vf slicify=random,scale=0:0,format=rgb24:gray,scale=0:0 -vcodec rawvideo
+fi
+
+# ffv1 releases the buffer a frame was rendered into before returning
+# the frame, decode it through the graph to test direct rendering
+if [ -n "$do_ffv1_dr1" ] ; then
+    do_video_encoding ffv1_dr1.avi "-strict -2" "-an -vcodec ffv1"
+    do_ffmpeg ${outfile}ffv1_dr1.nut -i $target_path/$file -vf slicify=random,null -vcodec rawvideo
+fi
+
 # TODO: add tests for
-# direct rendering,
 # chains with feedback loops
 
 rm -f "$bench" "$bench2"
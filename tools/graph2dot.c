@@ -23,6 +23,7 @@
 #undef HAVE_AV_CONFIG_H
 #include "libavutil/pixdesc.h"
 #include "libavfilter/graphparser.h"
+#include "libavfilter/vsrc_buffer.h"
 
 static void usage(void)
 {
@@ -32,6 +33,8 @@ static void usage(void)
            "Options:\n"
            "-i INFILE         set INFILE as input file, stdin if omitted\n"
            "-o OUTFILE        set OUTFILE as output file, stdout if omitted\n"
+           "-n FRAMES         profile the graph on FRAMES blank frames fed to its\n"
+           "                  buffer sources, and show the statistics\n"
            "-h                print this help\n");
 }
 
@@ -40,14 +43,18 @@ struct line {
     struct line *next;
 };
 
-static void print_digraph(FILE *outfile, AVFilterGraph *graph)
+static void print_digraph(FILE *outfile, AVFilterGraph *graph, int profiled)
 {
     int i, j;
+    int64_t total = 0;
 
     fprintf(outfile, "digraph G {\n");
     fprintf(outfile, "node [shape=box]\n");
     fprintf(outfile, "rankdir=LR\n");
 
+    for (i = 0; i < graph->filter_count; i++)
+        total += graph->filters[i]->stats.wall_time;
+
     for (i = 0; i < graph->filter_count; i++) {
         char filter_ctx_label[128];
         const AVFilterContext *filter_ctx = graph->filters[i];
@@ -56,6 +63,16 @@ static void print_digraph(FILE *outfile, AVFilterGraph *graph)
                  filter_ctx->name,
                  filter_ctx->filter->name);
 
+        if (profiled) {
+            const AVFilterStats *s = &filter_ctx->stats;
+            fprintf(outfile, "\"%s\" [ label= \"%s\\nwall:%.3fms (%.1f%%) cpu:%.3fms\\n"
+                    "frames:%u slices:%u alloc:%"PRId64"kB\"];\n",
+                    filter_ctx_label, filter_ctx_label,
+                    s->wall_time / 1000.0, total ? 100.0 * s->wall_time / total : 0.0,
+                    s->cpu_time / 1000.0, s->frame_count, s->slice_count,
+                    s->buffer_bytes >> 10);
+        }
+
         for (j = 0; j < filter_ctx->output_count; j++) {
             AVFilterLink *link = filter_ctx->outputs[j];
             if (link) {
@@ -67,14 +84,71 @@ static void print_digraph(FILE *outfile, AVFilterGraph *graph)
                          dst_filter_ctx->filter->name);
 
                 fprintf(outfile, "\"%s\" -> \"%s\"", filter_ctx_label, dst_filter_ctx_label);
-                fprintf(outfile, " [ label= \"fmt:%s w:%d h:%d\"];\n",
+                fprintf(outfile, " [ label= \"fmt:%s w:%d h:%d",
                         av_pix_fmt_descriptors[link->format].name, link->w, link->h);
+                if (profiled)
+                    fprintf(outfile, "\\nframes:%u copies:%u queue:%u",
+                            link->stats.frame_count, link->stats.copy_count,
+                            link->stats.max_queued);
+                fprintf(outfile, "\"];\n");
             }
         }
     }
     fprintf(outfile, "}\n");
 }
 
+/**
+ * Feed nb_frames blank frames to the buffer sources of the graph and pull
+ * all the frames available out of its sinks.
+ */
+static int run_graph(AVFilterGraph *graph, int nb_frames)
+{
+    AVFilter *buffer = avfilter_get_by_name("buffer");
+    AVPicture *pics = av_mallocz(graph->filter_count * sizeof(AVPicture));
+    int i, n;
+
+    for (i = 0; i < graph->filter_count; i++) {
+        AVFilterContext *filter = graph->filters[i];
+        AVFilterLink *link = filter->outputs ? filter->outputs[0] : NULL;
+
+        if (filter->filter != buffer || !link)
+            continue;
+        if (avpicture_alloc(&pics[i], link->format, link->w, link->h) < 0)
+            return -1;
+        memset(pics[i].data[0], 0x80,
+               avpicture_get_size(link->format, link->w, link->h));
+    }
+
+    for (n = 0; n < nb_frames; n++) {
+        for (i = 0; i < graph->filter_count; i++) {
+            AVFrame frame;
+
+            if (graph->filters[i]->filter != buffer)
+                continue;
+            memset(&frame, 0, sizeof(frame));
+            memcpy(frame.data,     pics[i].data,     sizeof(pics[i].data));
+            memcpy(frame.linesize, pics[i].linesize, sizeof(pics[i].linesize));
+            av_vsrc_buffer_add_frame(graph->filters[i], &frame, n, (AVRational){1, 1});
+        }
+
+        for (i = 0; i < graph->filter_count; i++) {
+            AVFilterContext *filter = graph->filters[i];
+
+            if (filter->output_count || !filter->input_count)
+                continue;
+            while (avfilter_poll_frame(filter->inputs[0]) > 0)
+                if (avfilter_request_frame(filter->inputs[0]) < 0)
+                    break;
+        }
+    }
+
+    for (i = 0; i < graph->filter_count; i++)
+        if (pics[i].data[0])
+            avpicture_free(&pics[i]);
+    av_free(pics);
+    return 0;
+}
+
 int main(int argc, char **argv)
 {
     const char *outfilename = NULL;
@@ -83,11 +157,12 @@ int main(int argc, char **argv)
     FILE *infile = NULL;
     char *graph_string = NULL;
     AVFilterGraph *graph = av_mallocz(sizeof(AVFilterGraph));
+    int nb_frames = 0;
     char c;
 
     av_log_set_level(AV_LOG_DEBUG);
 
-    while ((c = getopt(argc, argv, "hi:o:")) != -1) {
+    while ((c = getopt(argc, argv, "hi:n:o:")) != -1) {
         switch(c) {
         case 'h':
             usage();
@@ -95,6 +170,9 @@ int main(int argc, char **argv)
         case 'i':
             infilename = optarg;
             break;
+        case 'n':
+            nb_frames = atoi(optarg);
+            break;
         case 'o':
             outfilename = optarg;
             break;
@@ -156,7 +234,16 @@ int main(int argc, char **argv)
         avfilter_graph_config_links  (graph, NULL))
         return 1;
 
-    print_digraph(outfile, graph);
+    if (nb_frames > 0) {
+        avfilter_graph_set_profiling(graph, 1);
+        if (run_graph(graph, nb_frames) < 0) {
+            fprintf(stderr, "Failed to run the graph\n");
+            return 1;
+        }
+        avfilter_graph_dump_stats(graph, NULL);
+    }
+
+    print_digraph(outfile, graph, nb_frames > 0);
     fflush(outfile);
 
     return 0;